@@ -0,0 +1,122 @@
+#include "libdom/atom.h"
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace LibDOM {
+
+static constexpr std::wstring_view KNOWN_NAMES[] = {
+    L"",
+#define ATOM(id, name) name,
+#include "libdom/atomnames.inc"
+#undef ATOM
+};
+
+// The known names are found through an open addressing hash table that is
+// built at compile time, so looking them up needs neither a lock nor any
+// initialization.
+static constexpr size_t KNOWN_SLOT_COUNT = 2048;
+static_assert(Atoms::KNOWN_ATOM_COUNT * 2 <= KNOWN_SLOT_COUNT,
+              "the known atom table is too full");
+
+struct KnownSlots {
+  unsigned short atoms[KNOWN_SLOT_COUNT];
+};
+
+static constexpr KnownSlots buildKnownSlots() {
+  KnownSlots slots{};
+  for (unsigned short atom = 1; atom < Atoms::KNOWN_ATOM_COUNT; atom++) {
+    size_t slot = atomHash(KNOWN_NAMES[atom]) & (KNOWN_SLOT_COUNT - 1);
+    while (slots.atoms[slot] != NULL_ATOM) {
+      if (KNOWN_NAMES[slots.atoms[slot]] == KNOWN_NAMES[atom])
+        throw "atomnames.inc lists a name twice";
+      slot = (slot + 1) & (KNOWN_SLOT_COUNT - 1);
+    }
+    slots.atoms[slot] = atom;
+  }
+  return slots;
+}
+
+static constexpr KnownSlots KNOWN_SLOTS = buildKnownSlots();
+
+// Names that aren't known are added at runtime. Their strings are never freed
+// or moved, so the views handed out by atomName() stay valid.
+struct DynamicAtoms {
+  std::shared_mutex mutex;
+  std::deque<std::wstring> names;
+  std::unordered_map<std::wstring_view, Atom> atoms;
+};
+
+static DynamicAtoms &dynamicAtoms() {
+  static DynamicAtoms dynamic;
+  return dynamic;
+}
+
+static Atom findKnown(std::wstring_view name, unsigned int hash) {
+  for (size_t slot = hash & (KNOWN_SLOT_COUNT - 1);
+       KNOWN_SLOTS.atoms[slot] != NULL_ATOM;
+       slot = (slot + 1) & (KNOWN_SLOT_COUNT - 1)) {
+    Atom atom = static_cast<Atom>(KNOWN_SLOTS.atoms[slot]);
+    if (KNOWN_NAMES[atom] == name)
+      return atom;
+  }
+  return NULL_ATOM;
+}
+
+static Atom findDynamic(DynamicAtoms &dynamic, std::wstring_view name) {
+  auto it = dynamic.atoms.find(name);
+  return it == dynamic.atoms.end() ? NULL_ATOM : it->second;
+}
+
+Atom atomize(std::wstring_view name) { return atomize(name, atomHash(name)); }
+
+Atom atomize(std::wstring_view name, unsigned int hash) {
+  if (name.empty())
+    return NULL_ATOM;
+  if (Atom atom = findKnown(name, hash))
+    return atom;
+
+  auto &dynamic = dynamicAtoms();
+  {
+    std::shared_lock<std::shared_mutex> lock(dynamic.mutex);
+    if (Atom atom = findDynamic(dynamic, name))
+      return atom;
+  }
+  std::unique_lock<std::shared_mutex> lock(dynamic.mutex);
+  // another thread might have added it while the lock was released
+  if (Atom atom = findDynamic(dynamic, name))
+    return atom;
+  if (dynamic.names.size() == MAX_DYNAMIC_ATOMS)
+    return UNINTERNED_ATOM;
+  auto atom =
+      static_cast<Atom>(Atoms::KNOWN_ATOM_COUNT + dynamic.names.size());
+  dynamic.names.emplace_back(name);
+  dynamic.atoms.emplace(dynamic.names.back(), atom);
+  return atom;
+}
+
+Atom findAtom(std::wstring_view name) {
+  if (name.empty())
+    return NULL_ATOM;
+  if (Atom atom = findKnown(name, atomHash(name)))
+    return atom;
+  auto &dynamic = dynamicAtoms();
+  std::shared_lock<std::shared_mutex> lock(dynamic.mutex);
+  return findDynamic(dynamic, name);
+}
+
+std::wstring_view atomName(Atom atom) {
+  if (atom < Atoms::KNOWN_ATOM_COUNT)
+    return KNOWN_NAMES[atom];
+  if (atom == UNINTERNED_ATOM)
+    return std::wstring_view();
+  auto &dynamic = dynamicAtoms();
+  std::shared_lock<std::shared_mutex> lock(dynamic.mutex);
+  return dynamic.names[atom - Atoms::KNOWN_ATOM_COUNT];
+}
+
+} // namespace LibDOM
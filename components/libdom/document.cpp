@@ -0,0 +1,68 @@
+#include "libdom/document.h"
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include <cstdint>
+
+namespace LibDOM {
+
+using namespace Atoms;
+
+DocumentType::DocumentType() { this->nodeType = DOCUMENT_TYPE_NODE; }
+
+Document::Document() { this->nodeType = DOCUMENT_NODE; }
+
+RefPtr<Document> Document::create() { return RefPtr<Document>(new Document); }
+
+Element *Document::documentElement() const {
+  for (Node *child = firstChild(); child != nullptr;
+       child = child->nextSibling()) {
+    if (child->nodeType == ELEMENT_NODE)
+      return static_cast<Element *>(child);
+  }
+  return nullptr;
+}
+
+/** The first HTML element called `name` or `other` in the html element. */
+static Element *htmlChild(const Element *html, Atom name,
+                          Atom other = NULL_ATOM) {
+  if (html == nullptr || html->localName != ATOM_html ||
+      html->namespaceURI != HTML_NAMESPACE)
+    return nullptr;
+  for (Node *child = html->firstChild(); child != nullptr;
+       child = child->nextSibling()) {
+    if (child->nodeType != Node::ELEMENT_NODE)
+      continue;
+    auto *element = static_cast<Element *>(child);
+    if (element->namespaceURI == HTML_NAMESPACE &&
+        (element->localName == name || element->localName == other))
+      return element;
+  }
+  return nullptr;
+}
+
+Element *Document::head() const {
+  return htmlChild(documentElement(), ATOM_head);
+}
+
+Element *Document::body() const {
+  return htmlChild(documentElement(), ATOM_body, ATOM_frameset);
+}
+
+void Document::removedLastRef() {
+  m_tearingDown = true;
+  Node *dying = nullptr;
+  releaseChildren(dying);
+  destroyNodes(dying);
+  m_tearingDown = false;
+  if (m_arena.liveCount() == 0)
+    delete this;
+}
+
+void Document::freeNode(Node *node, uint16_t sizeClass) {
+  m_arena.free(node, sizeClass);
+  if (m_arena.liveCount() == 0 && m_refCount == 0 && !m_tearingDown)
+    delete this;
+}
+
+} // namespace LibDOM
@@ -0,0 +1,281 @@
+#include "libdom/domstring.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace LibDOM {
+
+struct DOMString::Buffer {
+  Buffer(size_t capacity, bool is8Bit)
+      : is8Bit(is8Bit), capacity(static_cast<uint32_t>(capacity)) {}
+
+  std::atomic<unsigned int> refCount{1};
+  bool is8Bit;
+  /** How many code units are in use, from the start of the buffer. */
+  uint32_t length = 0;
+  uint32_t capacity;
+
+  // the code units follow the header
+  unsigned char *latin1() {
+    return reinterpret_cast<unsigned char *>(this + 1);
+  }
+  char16_t *utf16() { return reinterpret_cast<char16_t *>(this + 1); }
+};
+
+/** Turns a character into UTF-16 code units, and returns how many. */
+static size_t encodeUTF16(wchar_t c, char16_t units[2]) {
+  auto codePoint = static_cast<uint32_t>(c);
+  if (codePoint < 0x10000) {
+    units[0] = static_cast<char16_t>(codePoint);
+    return 1;
+  }
+  if (codePoint > 0x10FFFF) {
+    units[0] = 0xFFFD;
+    return 1;
+  }
+  codePoint -= 0x10000;
+  units[0] = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+  units[1] = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+  return 2;
+}
+
+/** How many code units `s` takes, and whether they all fit in a byte. */
+static size_t unitCount(std::wstring_view s, bool &is8Bit) {
+  size_t count = 0;
+  is8Bit = true;
+  for (wchar_t c : s) {
+    auto codePoint = static_cast<uint32_t>(c);
+    if (codePoint > 0xFF)
+      is8Bit = false;
+    count += codePoint >= 0x10000 && codePoint <= 0x10FFFF ? 2 : 1;
+  }
+  return count;
+}
+
+DOMString::Buffer *DOMString::allocate(size_t capacity, bool is8Bit) {
+  assert(capacity <= UINT32_MAX);
+  void *memory =
+      ::operator new(sizeof(Buffer) + capacity * (is8Bit ? 1 : 2));
+  return new (memory) Buffer(capacity, is8Bit);
+}
+
+void DOMString::release(Buffer *buffer) {
+  if (buffer == nullptr ||
+      buffer->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  buffer->~Buffer();
+  ::operator delete(buffer);
+}
+
+DOMString::DOMString(const wchar_t *s) : DOMString(std::wstring_view(s)) {}
+
+DOMString::DOMString(const std::wstring &s)
+    : DOMString(std::wstring_view(s)) {}
+
+DOMString::DOMString(std::wstring_view s) { append(s); }
+
+DOMString::DOMString(const DOMString &other)
+    : m_buffer(other.m_buffer), m_start(other.m_start),
+      m_length(other.m_length) {
+  if (m_buffer != nullptr)
+    m_buffer->refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+DOMString::DOMString(DOMString &&other) noexcept
+    : m_buffer(other.m_buffer), m_start(other.m_start),
+      m_length(other.m_length) {
+  other.m_buffer = nullptr;
+  other.m_start = 0;
+  other.m_length = 0;
+}
+
+DOMString &DOMString::operator=(const DOMString &other) {
+  DOMString copy(other);
+  return *this = std::move(copy);
+}
+
+DOMString &DOMString::operator=(DOMString &&other) noexcept {
+  std::swap(m_buffer, other.m_buffer);
+  std::swap(m_start, other.m_start);
+  std::swap(m_length, other.m_length);
+  return *this;
+}
+
+DOMString::~DOMString() { release(m_buffer); }
+
+bool DOMString::is8Bit() const {
+  return m_buffer == nullptr || m_buffer->is8Bit;
+}
+
+char16_t DOMString::operator[](size_t index) const {
+  assert(index < m_length);
+  if (m_buffer->is8Bit)
+    return m_buffer->latin1()[m_start + index];
+  return m_buffer->utf16()[m_start + index];
+}
+
+DOMString DOMString::substring(size_t start, size_t length) const {
+  DOMString result;
+  if (start >= m_length)
+    return result;
+  length = std::min(length, m_length - start);
+  if (length == 0)
+    return result;
+  result = *this;
+  result.m_start = static_cast<uint32_t>(m_start + start);
+  result.m_length = static_cast<uint32_t>(length);
+  return result;
+}
+
+void DOMString::reserve(size_t length, bool is8Bit) {
+  // a buffer that only this string uses can grow in place, even if the
+  // string stopped short of its end
+  if (m_buffer != nullptr &&
+      m_buffer->refCount.load(std::memory_order_acquire) == 1 &&
+      m_buffer->is8Bit == is8Bit && m_start + length <= m_buffer->capacity) {
+    m_buffer->length = m_start + m_length;
+    return;
+  }
+
+  size_t capacity = std::max(length, size_t(m_length) * 2);
+  Buffer *buffer = allocate(capacity, is8Bit);
+  if (m_length != 0 && m_buffer->is8Bit == is8Bit) {
+    if (is8Bit)
+      std::memcpy(buffer->latin1(), m_buffer->latin1() + m_start, m_length);
+    else
+      std::memcpy(buffer->utf16(), m_buffer->utf16() + m_start,
+                  m_length * sizeof(char16_t));
+  } else {
+    // only 8-bit strings are widened
+    for (size_t i = 0; i < m_length; i++)
+      buffer->utf16()[i] = m_buffer->latin1()[m_start + i];
+  }
+  buffer->length = m_length;
+  release(m_buffer);
+  m_buffer = buffer;
+  m_start = 0;
+}
+
+void DOMString::append(std::wstring_view s) {
+  if (s.empty())
+    return;
+  bool narrow;
+  size_t units = unitCount(s, narrow);
+  bool is8Bit = this->is8Bit() && narrow;
+  reserve(m_length + units, is8Bit);
+
+  size_t position = m_start + m_length;
+  if (is8Bit) {
+    auto *out = m_buffer->latin1() + position;
+    for (wchar_t c : s)
+      *out++ = static_cast<unsigned char>(c);
+  } else {
+    auto *out = m_buffer->utf16() + position;
+    for (wchar_t c : s)
+      out += encodeUTF16(c, out);
+  }
+  m_length = static_cast<uint32_t>(m_length + units);
+  m_buffer->length = m_start + m_length;
+}
+
+void DOMString::append(const DOMString &s) {
+  if (s.empty())
+    return;
+  // holding on to the buffer of `s` keeps it from being grown in place when it
+  // is this string's own
+  DOMString source = s;
+  bool is8Bit = this->is8Bit() && source.is8Bit();
+  reserve(m_length + source.m_length, is8Bit);
+
+  size_t position = m_start + m_length;
+  if (is8Bit) {
+    std::memcpy(m_buffer->latin1() + position,
+                source.m_buffer->latin1() + source.m_start, source.m_length);
+  } else {
+    for (size_t i = 0; i < source.m_length; i++)
+      m_buffer->utf16()[position + i] = source[i];
+  }
+  m_length += source.m_length;
+  m_buffer->length = m_start + m_length;
+}
+
+std::wstring DOMString::toWString() const {
+  std::wstring result;
+  result.reserve(m_length);
+  for (size_t i = 0; i < m_length; i++) {
+    char16_t unit = (*this)[i];
+    if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < m_length) {
+      char16_t next = (*this)[i + 1];
+      if (next >= 0xDC00 && next <= 0xDFFF) {
+        result += static_cast<wchar_t>(0x10000 + ((unit - 0xD800) << 10) +
+                                       (next - 0xDC00));
+        i++;
+        continue;
+      }
+    }
+    result += static_cast<wchar_t>(unit);
+  }
+  return result;
+}
+
+bool DOMString::equals(const DOMString &other) const {
+  if (m_length != other.m_length)
+    return false;
+  if (m_length == 0)
+    return true;
+  if (m_buffer->is8Bit && other.m_buffer->is8Bit)
+    return std::memcmp(m_buffer->latin1() + m_start,
+                       other.m_buffer->latin1() + other.m_start,
+                       m_length) == 0;
+  for (size_t i = 0; i < m_length; i++) {
+    if ((*this)[i] != other[i])
+      return false;
+  }
+  return true;
+}
+
+bool DOMString::equals(std::wstring_view s) const {
+  // every character takes at least one code unit
+  if (s.size() > m_length)
+    return false;
+  size_t i = 0;
+  for (wchar_t c : s) {
+    char16_t units[2];
+    size_t count = encodeUTF16(c, units);
+    if (i + count > m_length)
+      return false;
+    for (size_t j = 0; j < count; j++) {
+      if ((*this)[i++] != units[j])
+        return false;
+    }
+  }
+  return i == m_length;
+}
+
+bool DOMString::equalsIgnoringASCIICase(std::wstring_view lowercase) const {
+  if (lowercase.size() != m_length)
+    return false;
+  for (size_t i = 0; i < m_length; i++) {
+    char16_t unit = (*this)[i];
+    if (unit >= 'A' && unit <= 'Z')
+      unit += 'a' - 'A';
+    if (unit != static_cast<char16_t>(lowercase[i]))
+      return false;
+  }
+  return true;
+}
+
+size_t DOMString::bufferSize() const {
+  if (m_buffer == nullptr)
+    return 0;
+  return sizeof(Buffer) + m_buffer->capacity * (m_buffer->is8Bit ? 1 : 2);
+}
+
+} // namespace LibDOM
@@ -1,28 +1,63 @@
 #include "libdom/element.h"
+#include "libdom/atom.h"
 #include "libdom/domstring.h"
 #include "libdom/namednodemap.h"
-#include <memory>
+#include <string>
+#include <utility>
 
 namespace LibDOM {
 
-Element::Element() { this->nodeType = Node::ELEMENT_NODE; }
+Element::Element() : attributes(*this) { this->nodeType = Node::ELEMENT_NODE; }
+
+DOMString Element::tagName() const {
+  // FIXME: uppercase the names of HTML elements in HTML documents
+  DOMString name;
+  if (prefix != NULL_ATOM) {
+    name = atomName(prefix);
+    name += L':';
+  }
+  if (localName == UNINTERNED_ATOM)
+    name += uninternedLocalName;
+  else
+    name += atomName(localName);
+  return name;
+}
+
+DOMString Element::nodeName() const { return tagName(); }
 
 DOMString Element::getAttribute(DOMString qualifiedName) {
-  auto a = attributes.getNamedItem(qualifiedName);
-  if (a == nullptr)
-    return L"";
-  return a->value;
+  const Attribute *attribute = attributes.find(qualifiedName);
+  if (attribute == nullptr)
+    return DOMString();
+  return attribute->value;
+}
+
+DOMString Element::getAttribute(Atom qualifiedName) {
+  const Attribute *attribute = attributes.find(qualifiedName);
+  if (attribute == nullptr)
+    return DOMString();
+  return attribute->value;
 }
 
 void Element::setAttribute(DOMString qualifiedName, DOMString value) {
-  auto attr = std::make_shared<Attr>();
-  attr->name = qualifiedName;
-  attr->value = value;
-  attributes.setNamedItem(attr);
+  auto name = qualifiedName.toWString();
+  attributes.set(atomize(name), std::move(value), name);
+}
+
+void Element::setAttribute(Atom qualifiedName, DOMString value) {
+  attributes.set(qualifiedName, std::move(value));
+}
+
+void Element::removeAttribute(DOMString qualifiedName) {
+  attributes.remove(qualifiedName);
 }
 
 bool Element::hasAttribute(DOMString qualifiedName) {
-  return attributes.getNamedItem(qualifiedName) != nullptr;
+  return attributes.find(qualifiedName) != nullptr;
+}
+
+bool Element::hasAttribute(Atom qualifiedName) {
+  return attributes.find(qualifiedName) != nullptr;
 }
 
 } // namespace LibDOM
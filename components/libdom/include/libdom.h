@@ -1,9 +1,11 @@
 #ifndef LIBDOM_H
 #define LIBDOM_H
 
+#include "libdom/atom.h"
 #include "libdom/document.h"
 #include "libdom/domstring.h"
 #include "libdom/node.h"
+#include "libdom/refptr.h"
 #include "libdom/text.h"
 
 #endif
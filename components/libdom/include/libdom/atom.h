@@ -0,0 +1,84 @@
+#ifndef LIBDOM_ATOM_H
+#define LIBDOM_ATOM_H
+
+#include <string_view>
+
+namespace LibDOM {
+
+namespace Atoms {
+
+/**
+  An interned name. Every name has exactly one atom, so names are compared by
+  comparing their atoms.
+
+  The names in atomnames.inc have fixed atoms that can be used as constants;
+  the atoms of any other name are handed out the first time it is atomized and
+  stay valid for the rest of the program. As those are never freed, only
+  MAX_DYNAMIC_ATOMS of them are handed out, and the names that come after are
+  all given UNINTERNED_ATOM.
+*/
+enum Atom : unsigned int {
+  NULL_ATOM,
+#define ATOM(id, name) id,
+#include "libdom/atomnames.inc"
+#undef ATOM
+  KNOWN_ATOM_COUNT,
+};
+
+} // namespace Atoms
+
+using Atoms::Atom;
+using Atoms::NULL_ATOM;
+
+/** How many names that aren't known atomize() adds to the table at most. */
+const unsigned int MAX_DYNAMIC_ATOMS = 1 << 14;
+
+/**
+  The atom of every name that atomize() didn't add because the table is full.
+  It doesn't tell such names apart, so whatever has one of them keeps the name
+  as a string too, and compares it by that.
+*/
+const Atom UNINTERNED_ATOM =
+    static_cast<Atom>(Atoms::KNOWN_ATOM_COUNT + MAX_DYNAMIC_ATOMS);
+
+/**
+  The hash that atoms are looked up by, built one character at a time, so that
+  the tokenizer can hash names while it lowercases them (FNV-1a).
+*/
+const unsigned int ATOM_HASH_SEED = 2166136261u;
+constexpr unsigned int atomHashStep(unsigned int hash, wchar_t c) {
+  return (hash ^ static_cast<unsigned int>(c)) * 16777619u;
+}
+constexpr unsigned int atomHash(std::wstring_view name) {
+  unsigned int hash = ATOM_HASH_SEED;
+  for (wchar_t c : name)
+    hash = atomHashStep(hash, c);
+  return hash;
+}
+
+/**
+  Returns the atom of a name, adding it to the table if it isn't there yet,
+  or UNINTERNED_ATOM if the table is full. Known names are found without
+  taking a lock, so this is safe and cheap to call from any thread. The empty
+  name is NULL_ATOM.
+*/
+Atom atomize(std::wstring_view name);
+/** Same as atomize(name), for a name whose atomHash() is already known. */
+Atom atomize(std::wstring_view name, unsigned int hash);
+
+/**
+  Returns the atom of a name if it has one, or NULL_ATOM, without adding it to
+  the table. This is what looking a name up should use, so that names that
+  are only asked for don't fill the table.
+*/
+Atom findAtom(std::wstring_view name);
+
+/**
+  The name of an atom, valid for the rest of the program. UNINTERNED_ATOM has
+  no name of its own, and gives the empty name.
+*/
+std::wstring_view atomName(Atom atom);
+
+} // namespace LibDOM
+
+#endif
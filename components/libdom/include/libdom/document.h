@@ -2,25 +2,72 @@
 #define LIBDOM_DOCUMENT_H
 
 #include "libdom/element.h"
-#include <memory>
+#include "libdom/nodearena.h"
+#include "libdom/refptr.h"
+#include <cstdint>
+#include <new>
+#include <string>
+#include <utility>
 
 namespace LibDOM {
 
 class DocumentType : public Node {
 public:
+  DocumentType();
+
   DOMString name;
   DOMString publicId;
   DOMString systemId;
 };
 
+/**
+  A document owns the arena its nodes are in. Once nothing refers to the
+  document, its tree is torn down, but the document itself stays around until
+  the last of its nodes that are still referenced elsewhere is freed, as they
+  point to it and their memory is its.
+*/
 class Document : public Node {
 public:
+  static RefPtr<Document> create();
+
+  /** Makes a node of this document, with a reference to it. */
+  template <typename T, typename... Args> RefPtr<T> createNode(Args &&...args) {
+    uint16_t sizeClass;
+    void *memory = m_arena.allocate(sizeof(T), sizeClass);
+    T *node = new (memory) T(std::forward<Args>(args)...);
+    node->ownerDocument = this;
+    node->m_sizeClass = sizeClass;
+    return RefPtr<T>(node);
+  }
+
   std::string mode = "no-quirks";
 
-  std::shared_ptr<Element> head;
-  std::shared_ptr<Element> body;
+  /** https://dom.spec.whatwg.org/#dom-document-documentelement */
+  Element *documentElement() const;
+  /**
+    https://html.spec.whatwg.org/multipage/dom.html#dom-document-head
+
+    Looked up in the tree rather than kept, so that the document doesn't hold
+    on to an element that was taken out of it.
+  */
+  Element *head() const;
+  /** https://html.spec.whatwg.org/multipage/dom.html#dom-document-body */
+  Element *body() const;
 
   bool parserCannotChangeMode = false;
+
+  const NodeArena &arena() const { return m_arena; }
+
+private:
+  friend class Node;
+
+  Document();
+
+  void removedLastRef();
+  void freeNode(Node *node, uint16_t sizeClass);
+
+  NodeArena m_arena;
+  bool m_tearingDown = false;
 };
 
 } // namespace LibDOM
@@ -1,11 +1,132 @@
 #ifndef LIBDOM_DOMSTRING_H
 #define LIBDOM_DOMSTRING_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace LibDOM {
 
-typedef std::wstring DOMString;
+/**
+  https://webidl.spec.whatwg.org/#idl-DOMString
+
+  A sequence of UTF-16 code units. A string whose code units all fit in a byte
+  is stored as Latin-1, with one byte each, and only a string with any other
+  code unit takes two bytes for each, so that the mostly ASCII text of a
+  document doesn't take four bytes per character, as in a std::wstring.
+
+  The code units are in a buffer that is shared by reference counting:
+  copying a string or taking a substring of it doesn't copy any of them.
+  Strings don't change once made, apart from append(), which copies the
+  buffer first unless the string is the only one using it. Strings can be
+  handed between threads, but a single string can't be used by several at
+  once.
+
+  Converting from and to a std::wstring turns characters outside the BMP into
+  surrogate pairs and back.
+*/
+class DOMString {
+public:
+  static const size_t npos = static_cast<size_t>(-1);
+
+  DOMString() = default;
+  DOMString(const wchar_t *s);
+  DOMString(std::wstring_view s);
+  DOMString(const std::wstring &s);
+  DOMString(const DOMString &other);
+  DOMString(DOMString &&other) noexcept;
+  DOMString &operator=(const DOMString &other);
+  DOMString &operator=(DOMString &&other) noexcept;
+  ~DOMString();
+
+  /** The number of UTF-16 code units. */
+  size_t length() const { return m_length; }
+  bool empty() const { return m_length == 0; }
+  /** Whether the code units are stored with one byte each. */
+  bool is8Bit() const;
+  char16_t operator[](size_t index) const;
+
+  /** The code units from `start` on, sharing this string's buffer. */
+  DOMString substring(size_t start, size_t length = npos) const;
+
+  void append(std::wstring_view s);
+  void append(const DOMString &s);
+  DOMString &operator+=(std::wstring_view s) {
+    append(s);
+    return *this;
+  }
+  DOMString &operator+=(const std::wstring &s) {
+    append(std::wstring_view(s));
+    return *this;
+  }
+  DOMString &operator+=(const wchar_t *s) {
+    append(std::wstring_view(s));
+    return *this;
+  }
+  DOMString &operator+=(const DOMString &s) {
+    append(s);
+    return *this;
+  }
+  DOMString &operator+=(wchar_t c) {
+    append(std::wstring_view(&c, 1));
+    return *this;
+  }
+
+  std::wstring toWString() const;
+
+  bool equals(const DOMString &other) const;
+  bool equals(std::wstring_view s) const;
+  /** Compares to a lowercase string, treating A-Z like a-z. */
+  bool equalsIgnoringASCIICase(std::wstring_view lowercase) const;
+
+  /**
+    The bytes of the buffer this string holds on to, which may be shared with
+    others, or 0 for an empty string.
+  */
+  size_t bufferSize() const;
+
+private:
+  struct Buffer;
+
+  /** Takes a buffer with room for `capacity` code units, and a reference. */
+  static Buffer *allocate(size_t capacity, bool is8Bit);
+  static void release(Buffer *buffer);
+  /**
+    Makes this string the only one on a buffer that it ends the used part of,
+    and that has room for `length` code units of the given width.
+  */
+  void reserve(size_t length, bool is8Bit);
+
+  Buffer *m_buffer = nullptr;
+  uint32_t m_start = 0;
+  uint32_t m_length = 0;
+};
+
+inline bool operator==(const DOMString &a, const DOMString &b) {
+  return a.equals(b);
+}
+inline bool operator==(const DOMString &a, std::wstring_view b) {
+  return a.equals(b);
+}
+inline bool operator==(const DOMString &a, const std::wstring &b) {
+  return a.equals(std::wstring_view(b));
+}
+inline bool operator==(const DOMString &a, const wchar_t *b) {
+  return a.equals(std::wstring_view(b));
+}
+inline bool operator!=(const DOMString &a, const DOMString &b) {
+  return !a.equals(b);
+}
+inline bool operator!=(const DOMString &a, std::wstring_view b) {
+  return !a.equals(b);
+}
+inline bool operator!=(const DOMString &a, const std::wstring &b) {
+  return !a.equals(std::wstring_view(b));
+}
+inline bool operator!=(const DOMString &a, const wchar_t *b) {
+  return !a.equals(std::wstring_view(b));
+}
 
 } // namespace LibDOM
 
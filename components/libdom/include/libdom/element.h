@@ -1,10 +1,10 @@
 #ifndef LIBDOM_ELEMENT_H
 #define LIBDOM_ELEMENT_H
 
+#include "libdom/atom.h"
 #include "libdom/domstring.h"
 #include "libdom/namednodemap.h"
 #include "node.h"
-#include <memory>
 
 namespace LibDOM {
 
@@ -12,16 +12,22 @@ class Element : public Node {
 public:
   Element();
 
-  DOMString namespaceURI;
-  DOMString prefix;
-  DOMString localName;
-  DOMString tagName;
+  Atom namespaceURI = NULL_ATOM;
+  Atom prefix = NULL_ATOM;
+  Atom localName = NULL_ATOM;
+  /** The local name as a string, if localName is UNINTERNED_ATOM. */
+  DOMString uninternedLocalName;
+  DOMString tagName() const;
+  DOMString nodeName() const override;
 
   NamedNodeMap attributes;
   DOMString getAttribute(DOMString qualifiedName);
+  DOMString getAttribute(Atom qualifiedName);
   void setAttribute(DOMString qualifiedName, DOMString value);
+  void setAttribute(Atom qualifiedName, DOMString value);
   void removeAttribute(DOMString qualifiedName);
   bool hasAttribute(DOMString qualifiedName);
+  bool hasAttribute(Atom qualifiedName);
 };
 
 class HTMLElement : public Element {};
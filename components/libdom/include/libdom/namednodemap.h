@@ -1,37 +1,142 @@
 #ifndef LIBDOM_NAMEDNODEMAP_H
 #define LIBDOM_NAMEDNODEMAP_H
 
+#include "libdom/atom.h"
 #include "libdom/domstring.h"
 #include "libdom/node.h"
+#include "libdom/refptr.h"
+#include <cstddef>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 namespace LibDOM {
 
 class Element;
 
+/** An attribute as an element keeps it, without an Attr node. */
+struct Attribute {
+  Atom namespaceURI = NULL_ATOM;
+  Atom prefix = NULL_ATOM;
+  Atom localName = NULL_ATOM;
+  /** The local name as a string, if localName is UNINTERNED_ATOM. */
+  DOMString uninternedLocalName;
+  DOMString value;
+
+  DOMString name() const;
+  /**
+    Whether the qualified name is `qualifiedName`, see Element. A name without
+    an atom of its own is compared as `uninterned`.
+  */
+  bool hasName(Atom qualifiedName, std::wstring_view uninterned = {}) const;
+};
+
+/**
+  https://dom.spec.whatwg.org/#interface-attr
+
+  Made only when an attribute is asked for as a node. While the attribute is
+  on an element, its value is the element's; once it is removed, or the
+  element is gone, the Attr keeps a copy.
+*/
 class Attr : public Node {
 public:
-  DOMString namespaceURI;
-  DOMString prefix;
-  DOMString localName;
-  DOMString name;
-  DOMString value;
+  Attr();
+
+  Atom namespaceURI = NULL_ATOM;
+  Atom prefix = NULL_ATOM;
+  Atom localName = NULL_ATOM;
+  /** The local name as a string, if localName is UNINTERNED_ATOM. */
+  DOMString uninternedLocalName;
+  DOMString name() const;
+  DOMString value() const;
+  void setValue(DOMString value);
 
   Element *ownerElement = nullptr;
   const bool specified = true;
+
+private:
+  friend class NamedNodeMap;
+
+  /** The value while the Attr isn't on an element. */
+  DOMString m_value;
 };
 
+/**
+  https://dom.spec.whatwg.org/#interface-namednodemap
+
+  The attribute list of an element. The attributes are stored in it directly,
+  and looking one up compares atoms. The methods that return an Attr make one
+  the first time an attribute is asked for, and return the same one after that.
+*/
 class NamedNodeMap {
 public:
-  unsigned long length();
-  std::shared_ptr<Attr> item(unsigned long index);
-  std::shared_ptr<Attr> getNamedItem(DOMString qualifiedName);
-  std::shared_ptr<Attr> setNamedItem(std::shared_ptr<Attr> attr);
-  std::shared_ptr<Attr> removeNamedItem(DOMString qualifiedName);
+  explicit NamedNodeMap(Element &element) : m_element(element) {}
+  NamedNodeMap(const NamedNodeMap &) = delete;
+  NamedNodeMap &operator=(const NamedNodeMap &) = delete;
+  ~NamedNodeMap();
+
+  unsigned long length() const { return m_attributes.size(); }
+  RefPtr<Attr> item(unsigned long index);
+  RefPtr<Attr> getNamedItem(DOMString qualifiedName);
+  /** Same as getNamedItem(DOMString), without building any strings. */
+  RefPtr<Attr> getNamedItem(Atom qualifiedName);
+  /**
+    Returns the Attr that `attr` replaced, if any, or nullptr if there was
+    none or `attr` is on another element.
+  */
+  RefPtr<Attr> setNamedItem(RefPtr<Attr> attr);
+  RefPtr<Attr> removeNamedItem(DOMString qualifiedName);
+
+  // the attributes without Attr nodes, for everything that isn't script
+
+  std::vector<Attribute>::const_iterator begin() const {
+    return m_attributes.begin();
+  }
+  std::vector<Attribute>::const_iterator end() const {
+    return m_attributes.end();
+  }
+  const Attribute &operator[](size_t index) const {
+    return m_attributes[index];
+  }
+  /**
+    The attribute with a qualified name, or nullptr. If the name has no atom
+    of its own, `qualifiedName` is UNINTERNED_ATOM and `uninterned` is the
+    name, as atomize() returned it; it isn't looked at otherwise.
+  */
+  const Attribute *find(Atom qualifiedName,
+                        std::wstring_view uninterned = {}) const;
+  /**
+    Same as find(Atom), for a name given as a string. The name is looked up
+    with findAtom() once, so it isn't added to the atom table, and the
+    attributes are compared by atom.
+  */
+  const Attribute *find(const DOMString &qualifiedName) const;
+  /**
+    Sets the value of the attribute with a qualified name, or adds one by that
+    name with no namespace. See find() for `uninterned`.
+  */
+  void set(Atom qualifiedName, DOMString value,
+           std::wstring_view uninterned = {});
+  /** Adds an attribute, which mustn't be there already. */
+  void append(Attribute attribute);
+  bool remove(Atom qualifiedName, std::wstring_view uninterned = {});
+  /** Same as remove(Atom), for a name given as a string, see find(). */
+  bool remove(const DOMString &qualifiedName);
 
 private:
-  std::vector<std::shared_ptr<Attr>> m_attrs;
+  friend class Attr;
+
+  /** The attribute with the namespace and local name of an Attr. */
+  Attribute *findFor(const Attr &attr);
+  /** The Attr of an attribute, made if there isn't one yet. */
+  RefPtr<Attr> attrFor(const Attribute &attribute);
+  /** Lets the Attr of an attribute, if there is one, keep its own value. */
+  void detachAttr(const Attribute &attribute);
+
+  Element &m_element;
+  std::vector<Attribute> m_attributes;
+  /** The Attrs that were asked for, if any. */
+  std::unique_ptr<std::vector<RefPtr<Attr>>> m_attrs;
 };
 
 }; // namespace LibDOM
@@ -2,15 +2,31 @@
 #define LIBDOM_NODE_H
 
 #include "libdom/domstring.h"
+#include "libdom/nodelist.h"
+#include "libdom/refptr.h"
+#include <cstdint>
 #include <memory>
-#include <vector>
+#include <string>
 
 namespace LibDOM {
 
 class Document;
 
+/**
+  Nodes count their own references, see RefPtr, and are allocated in the
+  NodeArena of their ownerDocument with Document::createNode(). A node that
+  isn't referenced any more is freed along with the children that nothing else
+  holds on to, however deep the tree under it is.
+
+  The children of a node are linked to their siblings, and the node holds a
+  reference to each of them, so inserting, removing and replacing a child
+  don't depend on how many siblings it has.
+*/
 class Node {
 public:
+  Node() = default;
+  Node(const Node &) = delete;
+  Node &operator=(const Node &) = delete;
   virtual ~Node() = default;
 
   static const unsigned short ELEMENT_NODE = 1;
@@ -27,16 +43,79 @@ public:
   static const unsigned short NOTATION_NODE = 12; // legacy
 
   unsigned short nodeType;
-  DOMString nodeName;
-  std::shared_ptr<Document> ownerDocument = nullptr;
+  /** The document whose arena the node is in, or nullptr for a document. */
+  Document *ownerDocument = nullptr;
   Node *parentNode = nullptr;
-  std::vector<std::shared_ptr<Node>> childNodes;
 
-  virtual void appendChild(std::shared_ptr<Node> node);
+  Node *firstChild() const { return m_firstChild; }
+  Node *lastChild() const { return m_lastChild; }
+  Node *previousSibling() const { return m_previousSibling; }
+  Node *nextSibling() const { return m_nextSibling; }
+  bool hasChildNodes() const { return m_firstChild != nullptr; }
+  /** Made the first time it is asked for, and kept up to date after that. */
+  NodeList &childNodes() const;
+
+  virtual DOMString nodeName() const;
+
+  // these move the node here if it already has a parent, and do nothing if
+  // `child` isn't a child of this node
+
+  virtual void appendChild(RefPtr<Node> node);
+  /** Appends the node if `child` is nullptr. */
+  virtual void insertBefore(RefPtr<Node> node, Node *child);
+  /** Returns the child, or nullptr if it isn't one. */
+  virtual RefPtr<Node> removeChild(Node *child);
+  /** Returns the child that was replaced, or nullptr if it isn't one. */
+  virtual RefPtr<Node> replaceChild(RefPtr<Node> node, Node *child);
+  /**
+    Appends all of the children of `node`, in order. Unlike appending them one
+    at a time, no references change hands.
+  */
+  void appendChildrenOf(Node &node);
 
   virtual const std::string internalName();
+
+  void ref() { m_refCount++; }
+  void deref();
+
+protected:
+  /**
+    Drops the references to the children, and adds the ones that aren't used
+    anywhere else to a list of nodes to free, linked through their parentNode.
+  */
+  void releaseChildren(Node *&dying);
+  /** Frees the nodes of such a list, and those their children add to it. */
+  static void destroyNodes(Node *dying);
+
+private:
+  friend class Document;
+
+  /** Links the node in before `next`, or last, taking its reference. */
+  void link(Node *node, Node *next);
+  void unlink(Node *child);
+  void childrenChanged() {
+    if (m_childNodes != nullptr)
+      m_childNodes->invalidate();
+  }
+
+  uint16_t m_sizeClass = 0;
+  unsigned int m_refCount = 0;
+  Node *m_firstChild = nullptr;
+  Node *m_lastChild = nullptr;
+  Node *m_previousSibling = nullptr;
+  Node *m_nextSibling = nullptr;
+  mutable std::unique_ptr<NodeList> m_childNodes;
 };
 
+inline NodeList::Iterator &NodeList::Iterator::operator++() {
+  m_node = m_node->nextSibling();
+  return *this;
+}
+
+inline NodeList::Iterator NodeList::begin() const {
+  return Iterator(m_owner.firstChild());
+}
+
 } // namespace LibDOM
 
 #endif
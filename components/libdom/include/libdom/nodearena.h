@@ -0,0 +1,71 @@
+#ifndef LIBDOM_NODEARENA_H
+#define LIBDOM_NODEARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LibDOM {
+
+/**
+  The memory the nodes of a document live in. Nodes are sorted by their size,
+  which in practice sorts them by kind, and each size is handed out from its
+  own blocks by bumping a pointer, with freed nodes kept on a list to be used
+  again. The blocks of a size start small and double, so that a document with
+  only a few nodes doesn't take much. All of them are released at once when
+  the arena is destroyed, which must not happen while any node is in use.
+*/
+class NodeArena {
+public:
+  NodeArena() = default;
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+  ~NodeArena();
+
+  /**
+    Returns room for `size` bytes, and the size class to give back to free()
+    with it. Sizes larger than any class come from the heap.
+  */
+  void *allocate(size_t size, uint16_t &sizeClass);
+  void free(void *memory, uint16_t sizeClass);
+
+  /** How many allocations haven't been freed yet. */
+  size_t liveCount() const { return m_liveCount; }
+  /** The bytes of all the blocks, whether they are in use or not. */
+  size_t blockBytes() const { return m_blockBytes; }
+  /** The bytes of the blocks of all the arenas there are, on any thread. */
+  static size_t totalBlockBytes() {
+    return s_totalBlockBytes.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr size_t GRANULE = 16;
+  static constexpr size_t SIZE_CLASSES = 32;
+  static constexpr size_t FIRST_BLOCK_SIZE = 1024;
+  static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+  /** The size class of memory that doesn't come from a block. */
+  static constexpr uint16_t HEAP = SIZE_CLASSES;
+
+  struct FreeSlot {
+    FreeSlot *next;
+  };
+  struct SizeClass {
+    char *cursor = nullptr;
+    char *end = nullptr;
+    size_t nextBlockSize = FIRST_BLOCK_SIZE;
+    FreeSlot *freeList = nullptr;
+  };
+
+  void *allocateSlow(SizeClass &sizeClass, size_t slotSize);
+
+  SizeClass m_classes[SIZE_CLASSES];
+  std::vector<void *> m_blocks;
+  size_t m_blockBytes = 0;
+  size_t m_liveCount = 0;
+  static std::atomic<size_t> s_totalBlockBytes;
+};
+
+} // namespace LibDOM
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef LIBDOM_NODELIST_H
+#define LIBDOM_NODELIST_H
+
+#include <vector>
+
+namespace LibDOM {
+
+class Node;
+
+/**
+  https://dom.spec.whatwg.org/#interface-nodelist
+
+  The live list of a node's children, see Node::childNodes(). Iterating over
+  it follows the sibling links, while length() and item() copy the children
+  into an array the first time they are used after the children changed.
+*/
+class NodeList {
+public:
+  explicit NodeList(const Node &owner) : m_owner(owner) {}
+  NodeList(const NodeList &) = delete;
+  NodeList &operator=(const NodeList &) = delete;
+
+  unsigned long length() const;
+  /** The child at `index`, or nullptr past the end. */
+  Node *item(unsigned long index) const;
+
+  class Iterator {
+  public:
+    explicit Iterator(Node *node) : m_node(node) {}
+    Node *operator*() const { return m_node; }
+    inline Iterator &operator++();
+    bool operator==(const Iterator &other) const {
+      return m_node == other.m_node;
+    }
+    bool operator!=(const Iterator &other) const {
+      return m_node != other.m_node;
+    }
+
+  private:
+    Node *m_node;
+  };
+  inline Iterator begin() const;
+  Iterator end() const { return Iterator(nullptr); }
+
+private:
+  friend class Node;
+
+  /** Called by the owner whenever its children change. */
+  void invalidate() {
+    m_items.clear();
+    m_valid = false;
+  }
+  void materialize() const;
+
+  const Node &m_owner;
+  mutable std::vector<Node *> m_items;
+  mutable bool m_valid = false;
+};
+
+} // namespace LibDOM
+
+#endif
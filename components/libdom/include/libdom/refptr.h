@@ -0,0 +1,98 @@
+#ifndef LIBDOM_REFPTR_H
+#define LIBDOM_REFPTR_H
+
+#include <cstddef>
+#include <utility>
+
+namespace LibDOM {
+
+/**
+  A reference to an object that counts its own references with ref() and
+  deref(), like a Node. Unlike std::shared_ptr, there is no control block, and
+  the count isn't atomic: an object and everything that holds on to it must
+  only be used by one thread at a time.
+*/
+template <typename T> class RefPtr {
+public:
+  RefPtr() = default;
+  RefPtr(std::nullptr_t) {}
+  RefPtr(T *ptr) : m_ptr(ptr) {
+    if (m_ptr != nullptr)
+      m_ptr->ref();
+  }
+  RefPtr(const RefPtr &other) : RefPtr(other.m_ptr) {}
+  template <typename U> RefPtr(const RefPtr<U> &other) : RefPtr(other.get()) {}
+  RefPtr(RefPtr &&other) noexcept : m_ptr(other.leakRef()) {}
+  template <typename U>
+  RefPtr(RefPtr<U> &&other) noexcept : m_ptr(other.leakRef()) {}
+  ~RefPtr() {
+    if (m_ptr != nullptr)
+      m_ptr->deref();
+  }
+
+  RefPtr &operator=(const RefPtr &other) {
+    RefPtr copy(other);
+    swap(copy);
+    return *this;
+  }
+  RefPtr &operator=(RefPtr &&other) noexcept {
+    RefPtr moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+  RefPtr &operator=(std::nullptr_t) {
+    RefPtr empty;
+    swap(empty);
+    return *this;
+  }
+
+  T *get() const { return m_ptr; }
+  T &operator*() const { return *m_ptr; }
+  T *operator->() const { return m_ptr; }
+  explicit operator bool() const { return m_ptr != nullptr; }
+
+  /** Lets go of the object without dropping the reference to it. */
+  T *leakRef() { return std::exchange(m_ptr, nullptr); }
+  /** Takes over a reference that was let go of with leakRef(). */
+  static RefPtr adopt(T *ptr) {
+    RefPtr result;
+    result.m_ptr = ptr;
+    return result;
+  }
+  void swap(RefPtr &other) noexcept { std::swap(m_ptr, other.m_ptr); }
+
+private:
+  T *m_ptr = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const RefPtr<T> &a, const RefPtr<U> &b) {
+  return a.get() == b.get();
+}
+template <typename T, typename U>
+bool operator!=(const RefPtr<T> &a, const RefPtr<U> &b) {
+  return a.get() != b.get();
+}
+template <typename T, typename U>
+bool operator==(const RefPtr<T> &a, const U *b) {
+  return a.get() == b;
+}
+template <typename T, typename U>
+bool operator!=(const RefPtr<T> &a, const U *b) {
+  return a.get() != b;
+}
+template <typename T> bool operator==(const RefPtr<T> &a, std::nullptr_t) {
+  return a.get() == nullptr;
+}
+template <typename T> bool operator!=(const RefPtr<T> &a, std::nullptr_t) {
+  return a.get() != nullptr;
+}
+
+template <typename T, typename U>
+RefPtr<T> static_pointer_cast(const RefPtr<U> &ptr) {
+  return RefPtr<T>(static_cast<T *>(ptr.get()));
+}
+
+} // namespace LibDOM
+
+#endif
@@ -1,36 +1,239 @@
 #include "libdom/namednodemap.h"
-#include <algorithm>
-#include <iterator>
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace LibDOM {
 
-unsigned long NamedNodeMap::length() { return m_attrs.size(); }
-std::shared_ptr<Attr> NamedNodeMap::item(unsigned long index) {
-  return m_attrs[index];
+static DOMString qualifiedName(Atom prefix, Atom localName,
+                               const DOMString &uninterned) {
+  DOMString name;
+  if (prefix != NULL_ATOM) {
+    name = atomName(prefix);
+    name += L':';
+  }
+  if (localName == UNINTERNED_ATOM)
+    name += uninterned;
+  else
+    name += atomName(localName);
+  return name;
+}
+
+// whether an attribute and an Attr have the same namespace and local name
+template <typename A, typename B>
+static bool sameLocalName(const A &a, const B &b) {
+  return a.localName == b.localName && a.namespaceURI == b.namespaceURI &&
+         (a.localName != UNINTERNED_ATOM ||
+          a.uninternedLocalName == b.uninternedLocalName);
+}
+
+// the atom to look up a name that is given as a string by, without adding it
+// to the table: a name that has no atom can only be on an attribute that keeps
+// it as a string, which is what UNINTERNED_ATOM finds
+static Atom lookupAtom(std::wstring_view name) {
+  Atom atom = findAtom(name);
+  return atom == NULL_ATOM ? UNINTERNED_ATOM : atom;
+}
+
+DOMString Attribute::name() const {
+  return qualifiedName(prefix, localName, uninternedLocalName);
+}
+
+bool Attribute::hasName(Atom qualifiedName,
+                        std::wstring_view uninterned) const {
+  if (prefix == NULL_ATOM && localName != UNINTERNED_ATOM)
+    return localName == qualifiedName;
+  auto wanted = qualifiedName == UNINTERNED_ATOM ? uninterned
+                                                 : atomName(qualifiedName);
+  if (prefix == NULL_ATOM)
+    return uninternedLocalName == wanted;
+  return name() == wanted;
+}
+
+Attr::Attr() { this->nodeType = ATTRIBUTE_NODE; }
+
+DOMString Attr::name() const {
+  return qualifiedName(prefix, localName, uninternedLocalName);
+}
+
+DOMString Attr::value() const {
+  if (ownerElement == nullptr)
+    return m_value;
+  return ownerElement->attributes.findFor(*this)->value;
+}
+
+void Attr::setValue(DOMString value) {
+  if (ownerElement == nullptr)
+    m_value = std::move(value);
+  else
+    ownerElement->attributes.findFor(*this)->value = std::move(value);
+}
+
+NamedNodeMap::~NamedNodeMap() {
+  if (m_attrs == nullptr)
+    return;
+  for (const auto &attribute : m_attributes)
+    detachAttr(attribute);
+}
+
+const Attribute *NamedNodeMap::find(Atom qualifiedName,
+                                   std::wstring_view uninterned) const {
+  for (const auto &attribute : m_attributes) {
+    if (attribute.hasName(qualifiedName, uninterned))
+      return &attribute;
+  }
+  return nullptr;
+}
+
+const Attribute *NamedNodeMap::find(const DOMString &qualifiedName) const {
+  auto name = qualifiedName.toWString();
+  return find(lookupAtom(name), name);
+}
+
+Attribute *NamedNodeMap::findFor(const Attr &attr) {
+  for (auto &attribute : m_attributes) {
+    if (sameLocalName(attribute, attr))
+      return &attribute;
+  }
+  return nullptr;
+}
+
+void NamedNodeMap::set(Atom qualifiedName, DOMString value,
+                       std::wstring_view uninterned) {
+  for (auto &attribute : m_attributes) {
+    if (attribute.hasName(qualifiedName, uninterned)) {
+      attribute.value = std::move(value);
+      return;
+    }
+  }
+  Attribute attribute;
+  attribute.localName = qualifiedName;
+  if (qualifiedName == UNINTERNED_ATOM)
+    attribute.uninternedLocalName = uninterned;
+  attribute.value = std::move(value);
+  m_attributes.push_back(std::move(attribute));
+}
+
+void NamedNodeMap::append(Attribute attribute) {
+  m_attributes.push_back(std::move(attribute));
+}
+
+bool NamedNodeMap::remove(Atom qualifiedName, std::wstring_view uninterned) {
+  for (auto it = m_attributes.begin(); it != m_attributes.end(); ++it) {
+    if (it->hasName(qualifiedName, uninterned)) {
+      detachAttr(*it);
+      m_attributes.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NamedNodeMap::remove(const DOMString &qualifiedName) {
+  auto name = qualifiedName.toWString();
+  return remove(lookupAtom(name), name);
 }
 
-std::shared_ptr<Attr> NamedNodeMap::getNamedItem(DOMString qualifiedName) {
-  auto it = std::find_if(m_attrs.begin(), m_attrs.end(),
-                         [qualifiedName](std::shared_ptr<Attr> attr) {
-                           return attr->name == qualifiedName;
-                         });
-  if (it == m_attrs.end())
+RefPtr<Attr> NamedNodeMap::attrFor(const Attribute &attribute) {
+  if (m_attrs == nullptr)
+    m_attrs = std::make_unique<std::vector<RefPtr<Attr>>>();
+  for (const auto &attr : *m_attrs) {
+    if (sameLocalName(attribute, *attr))
+      return attr;
+  }
+  auto attr = m_element.ownerDocument->createNode<Attr>();
+  attr->namespaceURI = attribute.namespaceURI;
+  attr->prefix = attribute.prefix;
+  attr->localName = attribute.localName;
+  attr->uninternedLocalName = attribute.uninternedLocalName;
+  attr->ownerElement = &m_element;
+  m_attrs->push_back(attr);
+  return attr;
+}
+
+void NamedNodeMap::detachAttr(const Attribute &attribute) {
+  if (m_attrs == nullptr)
+    return;
+  for (auto it = m_attrs->begin(); it != m_attrs->end(); ++it) {
+    auto &attr = **it;
+    if (sameLocalName(attribute, attr)) {
+      attr.m_value = attribute.value;
+      attr.ownerElement = nullptr;
+      m_attrs->erase(it);
+      return;
+    }
+  }
+}
+
+RefPtr<Attr> NamedNodeMap::item(unsigned long index) {
+  if (index >= m_attributes.size())
     return nullptr;
-  return *it;
+  return attrFor(m_attributes[index]);
 }
 
-std::shared_ptr<Attr> NamedNodeMap::setNamedItem(std::shared_ptr<Attr> attr) {
-  std::shared_ptr<Attr> ret;
-  auto it = std::find_if(
-      m_attrs.begin(), m_attrs.end(),
-      [attr](std::shared_ptr<Attr> a1) { return a1->name == attr->name; });
-  if (it == m_attrs.end()) {
-    ret = attr;
-    m_attrs.push_back(attr);
+RefPtr<Attr> NamedNodeMap::getNamedItem(DOMString qualifiedName) {
+  const Attribute *attribute = find(qualifiedName);
+  if (attribute == nullptr)
+    return nullptr;
+  return attrFor(*attribute);
+}
+
+RefPtr<Attr> NamedNodeMap::getNamedItem(Atom qualifiedName) {
+  const Attribute *attribute = find(qualifiedName);
+  if (attribute == nullptr)
+    return nullptr;
+  return attrFor(*attribute);
+}
+
+RefPtr<Attr> NamedNodeMap::setNamedItem(RefPtr<Attr> attr) {
+  if (attr->ownerElement == &m_element)
+    return attr;
+  if (attr->ownerElement != nullptr)
+    return nullptr;
+
+  RefPtr<Attr> old;
+  DOMString value = attr->m_value;
+  if (auto *attribute = findFor(*attr)) {
+    old = attrFor(*attribute);
+    detachAttr(*attribute);
+    attribute->prefix = attr->prefix;
+    attribute->value = std::move(value);
   } else {
-    ret = *it;
-    ret->value = attr->value;
+    Attribute added;
+    added.namespaceURI = attr->namespaceURI;
+    added.prefix = attr->prefix;
+    added.localName = attr->localName;
+    added.uninternedLocalName = attr->uninternedLocalName;
+    added.value = std::move(value);
+    m_attributes.push_back(std::move(added));
+  }
+  attr->m_value = DOMString();
+  attr->ownerElement = &m_element;
+  if (m_attrs == nullptr)
+    m_attrs = std::make_unique<std::vector<RefPtr<Attr>>>();
+  m_attrs->push_back(attr);
+  return old;
+}
+
+RefPtr<Attr> NamedNodeMap::removeNamedItem(DOMString qualifiedName) {
+  auto name = qualifiedName.toWString();
+  Atom atom = lookupAtom(name);
+  for (auto it = m_attributes.begin(); it != m_attributes.end(); ++it) {
+    if (it->hasName(atom, name)) {
+      auto attr = attrFor(*it);
+      detachAttr(*it);
+      m_attributes.erase(it);
+      return attr;
+    }
   }
-  return ret;
+  return nullptr;
 }
 
 } // namespace LibDOM
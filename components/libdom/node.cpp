@@ -1,16 +1,150 @@
 #include "libdom/node.h"
+#include "libdom/document.h"
+#include "libdom/refptr.h"
+#include <cassert>
 #include <cxxabi.h>
-#include <iostream>
 #include <memory>
+#include <utility>
 
 namespace LibDOM {
 
-void Node::appendChild(std::shared_ptr<Node> node) {
-  std::wcout << "(dom) appending " << node->internalName().c_str() << " ("
-             << node->nodeName << ") to " << this->internalName().c_str()
-             << " (" << this->nodeName << ")\n";
-  childNodes.push_back(node);
+// FIXME: "#text", "#comment", "#document" and the other fixed names
+DOMString Node::nodeName() const { return L""; }
+
+NodeList &Node::childNodes() const {
+  if (m_childNodes == nullptr)
+    m_childNodes = std::make_unique<NodeList>(*this);
+  return *m_childNodes;
+}
+
+void Node::link(Node *node, Node *next) {
   node->parentNode = this;
+  node->m_nextSibling = next;
+  node->m_previousSibling = next != nullptr ? next->m_previousSibling
+                                            : m_lastChild;
+  if (node->m_previousSibling != nullptr)
+    node->m_previousSibling->m_nextSibling = node;
+  else
+    m_firstChild = node;
+  if (next != nullptr)
+    next->m_previousSibling = node;
+  else
+    m_lastChild = node;
+  childrenChanged();
+}
+
+void Node::unlink(Node *child) {
+  if (child->m_previousSibling != nullptr)
+    child->m_previousSibling->m_nextSibling = child->m_nextSibling;
+  else
+    m_firstChild = child->m_nextSibling;
+  if (child->m_nextSibling != nullptr)
+    child->m_nextSibling->m_previousSibling = child->m_previousSibling;
+  else
+    m_lastChild = child->m_previousSibling;
+  child->parentNode = nullptr;
+  child->m_previousSibling = nullptr;
+  child->m_nextSibling = nullptr;
+  childrenChanged();
+}
+
+void Node::appendChild(RefPtr<Node> node) {
+  insertBefore(std::move(node), nullptr);
+}
+
+void Node::insertBefore(RefPtr<Node> node, Node *child) {
+  if (child != nullptr && child->parentNode != this)
+    return;
+  if (child == node.get())
+    child = child->m_nextSibling;
+  if (node->parentNode != nullptr)
+    node->parentNode->unlink(node.get());
+  else
+    node->ref();
+  // the reference the old parent held is this node's now
+  link(node.get(), child);
+}
+
+RefPtr<Node> Node::removeChild(Node *child) {
+  if (child == nullptr || child->parentNode != this)
+    return nullptr;
+  unlink(child);
+  return RefPtr<Node>::adopt(child);
+}
+
+RefPtr<Node> Node::replaceChild(RefPtr<Node> node, Node *child) {
+  if (child == nullptr || child->parentNode != this)
+    return nullptr;
+  if (node.get() == child)
+    return node;
+  Node *next = child->m_nextSibling;
+  if (next == node.get())
+    next = next->m_nextSibling;
+  auto removed = removeChild(child);
+  insertBefore(std::move(node), next);
+  return removed;
+}
+
+void Node::appendChildrenOf(Node &node) {
+  if (node.m_firstChild == nullptr || &node == this)
+    return;
+  for (Node *child = node.m_firstChild; child != nullptr;
+       child = child->m_nextSibling)
+    child->parentNode = this;
+  node.m_firstChild->m_previousSibling = m_lastChild;
+  if (m_lastChild != nullptr)
+    m_lastChild->m_nextSibling = node.m_firstChild;
+  else
+    m_firstChild = node.m_firstChild;
+  m_lastChild = node.m_lastChild;
+  node.m_firstChild = nullptr;
+  node.m_lastChild = nullptr;
+  node.childrenChanged();
+  childrenChanged();
+}
+
+void Node::deref() {
+  assert(m_refCount > 0);
+  if (--m_refCount != 0)
+    return;
+  if (nodeType == DOCUMENT_NODE) {
+    static_cast<Document *>(this)->removedLastRef();
+    return;
+  }
+  parentNode = nullptr;
+  destroyNodes(this);
+}
+
+void Node::releaseChildren(Node *&dying) {
+  for (Node *child = m_firstChild; child != nullptr;) {
+    Node *next = child->m_nextSibling;
+    child->m_previousSibling = nullptr;
+    child->m_nextSibling = nullptr;
+    if (--child->m_refCount != 0) {
+      child->parentNode = nullptr;
+    } else {
+      child->parentNode = dying;
+      dying = child;
+    }
+    child = next;
+  }
+  m_firstChild = nullptr;
+  m_lastChild = nullptr;
+  childrenChanged();
+}
+
+void Node::destroyNodes(Node *dying) {
+  // tearing the tree down one node at a time, instead of letting each node's
+  // destructor drop its children, keeps deep trees from overflowing the stack
+  while (dying != nullptr) {
+    Node *node = dying;
+    dying = node->parentNode;
+    node->releaseChildren(dying);
+    Document *document = node->ownerDocument;
+    uint16_t sizeClass = node->m_sizeClass;
+    node->~Node();
+    document->freeNode(node, sizeClass);
+  }
 }
 
 const std::string Node::internalName() {
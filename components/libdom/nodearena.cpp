@@ -0,0 +1,71 @@
+#include "libdom/nodearena.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace LibDOM {
+
+std::atomic<size_t> NodeArena::s_totalBlockBytes{0};
+
+NodeArena::~NodeArena() {
+  assert(m_liveCount == 0);
+  for (void *block : m_blocks)
+    ::operator delete(block);
+  s_totalBlockBytes.fetch_sub(m_blockBytes, std::memory_order_relaxed);
+}
+
+void *NodeArena::allocate(size_t size, uint16_t &sizeClass) {
+  size_t index = (std::max<size_t>(size, 1) + GRANULE - 1) / GRANULE - 1;
+  if (index >= SIZE_CLASSES) {
+    sizeClass = HEAP;
+    m_liveCount++;
+    return ::operator new(size);
+  }
+
+  sizeClass = static_cast<uint16_t>(index);
+  m_liveCount++;
+  auto &slots = m_classes[index];
+  if (slots.freeList != nullptr) {
+    FreeSlot *slot = slots.freeList;
+    slots.freeList = slot->next;
+    return slot;
+  }
+  size_t slotSize = (index + 1) * GRANULE;
+  if (static_cast<size_t>(slots.end - slots.cursor) >= slotSize) {
+    void *slot = slots.cursor;
+    slots.cursor += slotSize;
+    return slot;
+  }
+  return allocateSlow(slots, slotSize);
+}
+
+void *NodeArena::allocateSlow(SizeClass &slots, size_t slotSize) {
+  size_t blockSize = std::max(slots.nextBlockSize, slotSize);
+  slots.nextBlockSize = std::min(slots.nextBlockSize * 2, MAX_BLOCK_SIZE);
+  m_blocks.reserve(m_blocks.size() + 1);
+  char *block = static_cast<char *>(::operator new(blockSize));
+  m_blocks.push_back(block);
+  m_blockBytes += blockSize;
+  s_totalBlockBytes.fetch_add(blockSize, std::memory_order_relaxed);
+  // whatever is left of the last block is too small for a slot
+  slots.cursor = block + slotSize;
+  slots.end = block + blockSize - blockSize % slotSize;
+  return block;
+}
+
+void NodeArena::free(void *memory, uint16_t sizeClass) {
+  assert(m_liveCount > 0);
+  m_liveCount--;
+  if (sizeClass == HEAP) {
+    ::operator delete(memory);
+    return;
+  }
+  auto *slot = static_cast<FreeSlot *>(memory);
+  slot->next = m_classes[sizeClass].freeList;
+  m_classes[sizeClass].freeList = slot;
+}
+
+} // namespace LibDOM
@@ -0,0 +1,25 @@
+#include "libdom/nodelist.h"
+#include "libdom/node.h"
+
+namespace LibDOM {
+
+void NodeList::materialize() const {
+  if (m_valid)
+    return;
+  for (Node *child = m_owner.firstChild(); child != nullptr;
+       child = child->nextSibling())
+    m_items.push_back(child);
+  m_valid = true;
+}
+
+unsigned long NodeList::length() const {
+  materialize();
+  return m_items.size();
+}
+
+Node *NodeList::item(unsigned long index) const {
+  materialize();
+  return index < m_items.size() ? m_items[index] : nullptr;
+}
+
+} // namespace LibDOM
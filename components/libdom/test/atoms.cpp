@@ -0,0 +1,96 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include "testing.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LibDOM::Atoms;
+
+int main() {
+  check(LibDOM::atomize(L"div") == ATOM_div, "div is a known atom");
+  check(LibDOM::atomName(ATOM_div) == L"div", "the name of ATOM_div");
+  check(LibDOM::atomize(L"foreignObject") == ATOM_foreignObject &&
+            LibDOM::atomize(L"foreignobject") == ATOM_foreignobject,
+        "SVG names are known in both cases");
+  check(LibDOM::atomize(L"http://www.w3.org/1999/xhtml") == HTML_NAMESPACE,
+        "namespaces are known atoms");
+  check(LibDOM::atomize(L"DIV") != ATOM_div, "atoms are case sensitive");
+  check(LibDOM::atomize(L"") == NULL_ATOM, "the empty name");
+
+  std::wstring name = L"my-element";
+  unsigned int hash = LibDOM::ATOM_HASH_SEED;
+  for (wchar_t c : name)
+    hash = LibDOM::atomHashStep(hash, c);
+  auto atom = LibDOM::atomize(name, hash);
+  check(atom >= KNOWN_ATOM_COUNT, "unknown names get new atoms");
+  check(LibDOM::atomize(name) == atom, "atomizing again gives the same atom");
+  name.clear();
+  check(LibDOM::atomName(atom) == L"my-element",
+        "atoms keep their own copy of the name");
+
+  // threads atomizing the same new names must agree on their atoms
+  const size_t THREADS = 8;
+  const size_t NAMES = 1000;
+  std::vector<std::vector<LibDOM::Atom>> atoms(THREADS);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < THREADS; t++) {
+    threads.emplace_back([t, &atoms]() {
+      for (size_t i = 0; i < NAMES; i++) {
+        auto name = L"x-" + std::to_wstring((i + t * 97) % NAMES);
+        atoms[t].push_back(LibDOM::atomize(name));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  bool agree = true;
+  for (size_t t = 0; t < THREADS; t++) {
+    for (size_t i = 0; i < NAMES; i++) {
+      size_t j = (i + t * 97) % NAMES;
+      agree = agree && atoms[t][i] == atoms[0][j] &&
+              LibDOM::atomName(atoms[t][i]) == L"x-" + std::to_wstring(j);
+    }
+  }
+  check(agree, "threads agree on the atoms of the names they add");
+
+  check(LibDOM::findAtom(L"only-looked-up") == NULL_ATOM &&
+            LibDOM::findAtom(L"div") == ATOM_div &&
+            LibDOM::findAtom(L"my-element") == atom &&
+            LibDOM::atomize(L"only-looked-up") ==
+                LibDOM::findAtom(L"only-looked-up"),
+        "finding an atom doesn't add one");
+
+  // once the table is full, new names all get UNINTERNED_ATOM
+  unsigned int added = 0;
+  while (LibDOM::atomize(L"fill-" + std::to_wstring(added)) !=
+         LibDOM::UNINTERNED_ATOM)
+    added++;
+  check(added < LibDOM::MAX_DYNAMIC_ATOMS &&
+            LibDOM::atomize(L"one-too-many") == LibDOM::UNINTERNED_ATOM &&
+            LibDOM::findAtom(L"one-too-many") == NULL_ATOM &&
+            LibDOM::atomize(L"my-element") == atom &&
+            LibDOM::atomName(LibDOM::UNINTERNED_ATOM).empty(),
+        "the table stops growing once it is full");
+
+  // and attributes by such names keep them as strings
+  auto document = LibDOM::Document::create();
+  auto element = document->createNode<LibDOM::HTMLElement>();
+  element->setAttribute(LibDOM::DOMString(L"one-too-many"), L"1");
+  element->setAttribute(LibDOM::DOMString(L"two-too-many"), L"2");
+  element->setAttribute(LibDOM::DOMString(L"one-too-many"), L"3");
+  check(element->attributes.length() == 2 &&
+            element->getAttribute(LibDOM::DOMString(L"one-too-many")) ==
+                L"3" &&
+            element->attributes.getNamedItem(LibDOM::DOMString(
+                L"two-too-many"))->value() == L"2",
+        "attributes past the limit");
+  element->removeAttribute(L"one-too-many");
+  check(element->attributes.length() == 1 &&
+            element->attributes[0].name() == L"two-too-many",
+        "removing an attribute past the limit");
+
+  return s_failures == 0 ? 0 : 1;
+}
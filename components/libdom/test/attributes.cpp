@@ -0,0 +1,106 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/namednodemap.h"
+#include "libdom/refptr.h"
+#include "testing.h"
+
+using namespace LibDOM::Atoms;
+
+int main() {
+  auto document = LibDOM::Document::create();
+  auto element = document->createNode<LibDOM::HTMLElement>();
+  size_t live = document->arena().liveCount();
+
+  element->setAttribute(ATOM_id, L"main");
+  element->setAttribute(LibDOM::DOMString(L"class"), L"a b");
+  element->setAttribute(ATOM_id, L"top");
+  check(element->attributes.length() == 2 &&
+            element->getAttribute(ATOM_id) == L"top" &&
+            element->getAttribute(LibDOM::DOMString(L"class")) == L"a b" &&
+            element->hasAttribute(ATOM_class) &&
+            !element->hasAttribute(ATOM_title),
+        "setting and getting attributes");
+  check(document->arena().liveCount() == live,
+        "attributes don't make Attr nodes");
+
+  auto id = element->attributes.getNamedItem(ATOM_id);
+  check(id != nullptr && id->ownerElement == element.get() &&
+            id->name() == L"id" && id->value() == L"top",
+        "asking for an Attr makes one");
+  check(element->attributes.item(0) == id &&
+            element->attributes.getNamedItem(LibDOM::DOMString(L"id")) == id,
+        "the same Attr is returned every time");
+  id->setValue(L"side");
+  check(element->getAttribute(ATOM_id) == L"side",
+        "setting an Attr's value sets the element's");
+  element->setAttribute(ATOM_id, L"bottom");
+  check(id->value() == L"bottom", "an Attr's value is the element's");
+
+  auto removed = element->attributes.removeNamedItem(L"id");
+  check(removed == id && id->ownerElement == nullptr &&
+            id->value() == L"bottom" &&
+            !element->hasAttribute(ATOM_id),
+        "removing an attribute detaches its Attr");
+  element->setAttribute(ATOM_id, L"again");
+  check(id->value() == L"bottom", "a removed Attr keeps its value");
+
+  auto title = document->createNode<LibDOM::Attr>();
+  title->localName = ATOM_title;
+  title->setValue(L"Title");
+  check(element->attributes.setNamedItem(title) == nullptr &&
+            title->ownerElement == element.get() &&
+            element->getAttribute(ATOM_title) == L"Title",
+        "adding an Attr");
+  auto other = document->createNode<LibDOM::HTMLElement>();
+  check(other->attributes.setNamedItem(title) == nullptr &&
+            !other->hasAttribute(ATOM_title),
+        "an Attr on another element isn't added");
+  auto newTitle = document->createNode<LibDOM::Attr>();
+  newTitle->localName = ATOM_title;
+  newTitle->setValue(L"New title");
+  check(element->attributes.setNamedItem(newTitle) == title &&
+            title->ownerElement == nullptr && title->value() == L"Title" &&
+            element->getAttribute(ATOM_title) == L"New title",
+        "an Attr replaces the one with its name");
+
+  element->removeAttribute(L"class");
+  check(!element->hasAttribute(ATOM_class) &&
+            element->attributes.length() == 2,
+        "removing an attribute by name");
+
+  // looking names up doesn't add them to the atom table; only setting does
+  element->getAttribute(LibDOM::DOMString(L"data-get"));
+  element->hasAttribute(LibDOM::DOMString(L"data-has"));
+  element->removeAttribute(L"data-remove");
+  element->attributes.getNamedItem(LibDOM::DOMString(L"data-item"));
+  element->attributes.removeNamedItem(L"data-remove-item");
+  check(LibDOM::findAtom(L"data-get") == NULL_ATOM &&
+            LibDOM::findAtom(L"data-has") == NULL_ATOM &&
+            LibDOM::findAtom(L"data-remove") == NULL_ATOM &&
+            LibDOM::findAtom(L"data-item") == NULL_ATOM &&
+            LibDOM::findAtom(L"data-remove-item") == NULL_ATOM,
+        "looking up an attribute by a new name doesn't intern it");
+
+  // namespaced attributes are found by their qualified name
+  LibDOM::Attribute href;
+  href.namespaceURI = XLINK_NAMESPACE;
+  href.prefix = ATOM_xlink;
+  href.localName = ATOM_href;
+  href.value = L"#target";
+  element->attributes.append(href);
+  check(element->getAttribute(ATOM_xlink_href) == L"#target" &&
+            element->getAttribute(LibDOM::DOMString(L"xlink:href")) ==
+                L"#target" &&
+            !element->hasAttribute(ATOM_href) &&
+            !element->hasAttribute(LibDOM::DOMString(L"href")),
+        "a prefixed attribute");
+
+  auto kept = element->attributes.getNamedItem(ATOM_xlink_href);
+  element = nullptr;
+  check(kept->ownerElement == nullptr && kept->value() == L"#target" &&
+            id->ownerElement == nullptr && id->value() == L"bottom",
+        "the Attrs of a freed element keep their values");
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "libdom/domstring.h"
+#include "testing.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using LibDOM::DOMString;
+
+int main() {
+  DOMString empty;
+  check(empty.empty() && empty.is8Bit() && empty.bufferSize() == 0 &&
+            empty == L"",
+        "the empty string has no buffer");
+
+  DOMString latin1 = L"café";
+  check(latin1.is8Bit() && latin1.length() == 4 && latin1[3] == 0xE9,
+        "Latin-1 is stored with a byte per code unit");
+  check(latin1 == L"café" && latin1 != L"cafe" && latin1 != L"caf",
+        "comparing to wide strings");
+
+  DOMString greek = L"αβ";
+  check(!greek.is8Bit() && greek.length() == 2 && greek[0] == 0x3B1,
+        "other BMP characters take two bytes");
+  DOMString astral = L"a\U0001F600b";
+  check(astral.length() == 4 && astral[1] == 0xD83D && astral[2] == 0xDE00,
+        "characters outside the BMP are surrogate pairs");
+  check(astral.toWString() == L"a\U0001F600b" && astral == L"a\U0001F600b",
+        "surrogate pairs turn back into characters");
+
+  // copies and substrings share the buffer
+  DOMString copy = latin1;
+  DOMString sub = latin1.substring(1, 2);
+  check(copy == latin1 && sub == L"af" && sub.length() == 2,
+        "copies and substrings");
+  check(latin1.substring(2) == L"fé" && latin1.substring(9).empty(),
+        "substrings are clamped to the string");
+
+  // appending widens only when it has to, and doesn't touch shared buffers
+  DOMString text = L"abc";
+  DOMString shared = text;
+  text += L"def";
+  check(text == L"abcdef" && shared == L"abc" && text.is8Bit(),
+        "appending to a shared buffer copies it");
+  text += L'α';
+  check(text == L"abcdefα" && !text.is8Bit() && shared.is8Bit(),
+        "appending a wide character widens the string");
+  DOMString head = text.substring(0, 3);
+  head += L"!";
+  check(head == L"abc!" && text == L"abcdefα",
+        "appending to a substring leaves the rest of the buffer alone");
+  DOMString twice = L"ab";
+  twice += twice;
+  check(twice == L"abab", "appending a string to itself");
+
+  check(DOMString(L"HiDdEn").equalsIgnoringASCIICase(L"hidden") &&
+            !DOMString(L"hidde").equalsIgnoringASCIICase(L"hidden"),
+        "ASCII case-insensitive comparison");
+  check(DOMString(L"αab").substring(1) == DOMString(L"ab"),
+        "comparing 8-bit and 16-bit strings");
+
+  // copies of one string can be used and dropped on several threads
+  DOMString original = L"shared between threads";
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([original] {
+      for (int i = 0; i < 10000; i++) {
+        DOMString local = original;
+        local += L"!";
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  check(original == L"shared between threads",
+        "copies on other threads don't change the original");
+
+  return s_failures == 0 ? 0 : 1;
+}
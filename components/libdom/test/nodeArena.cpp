@@ -0,0 +1,66 @@
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/nodearena.h"
+#include "libdom/refptr.h"
+#include "libdom/text.h"
+#include "testing.h"
+#include <cstdint>
+
+int main() {
+  LibDOM::NodeArena arena;
+  uint16_t small, large, heap;
+  void *a = arena.allocate(40, small);
+  void *b = arena.allocate(40, small);
+  void *c = arena.allocate(200, large);
+  check(a != b && small != large && arena.liveCount() == 3,
+        "sizes are handed out from their own blocks");
+  arena.free(a, small);
+  check(arena.allocate(33, small) == a, "freed memory is used again");
+  void *huge = arena.allocate(100000, heap);
+  arena.free(huge, heap);
+  arena.free(a, small);
+  arena.free(b, small);
+  arena.free(c, large);
+  check(arena.liveCount() == 0, "everything was freed");
+
+  auto document = LibDOM::Document::create();
+  check(document->nodeType == LibDOM::Node::DOCUMENT_NODE,
+        "documents have their node type");
+  auto body = document->createNode<LibDOM::HTMLElement>();
+  auto text = document->createNode<LibDOM::Text>(L"text");
+  check(body->ownerDocument == document.get() &&
+            text->ownerDocument == document.get(),
+        "nodes belong to the document that made them");
+  document->appendChild(body);
+  body->appendChild(text);
+  check(document->arena().liveCount() == 2, "the arena counts the nodes");
+
+  // a node that is only in the tree goes when it is removed
+  auto removed = document->createNode<LibDOM::Text>(L"gone");
+  body->appendChild(removed);
+  removed = nullptr;
+  check(document->arena().liveCount() == 3, "the tree holds on to its nodes");
+  body->removeChild(body->lastChild());
+  check(document->arena().liveCount() == 2, "a removed node is freed");
+
+  // a very deep tree can be freed without recursing
+  LibDOM::Node *deepest = body.get();
+  for (int i = 0; i < 1000000; i++) {
+    auto child = document->createNode<LibDOM::HTMLElement>();
+    deepest->appendChild(child);
+    deepest = child.get();
+  }
+  body->removeChild(body->lastChild());
+  check(document->arena().liveCount() == 2, "a deep tree is freed");
+
+  // nodes that are still used outlive their document's tree
+  body = nullptr;
+  document = nullptr;
+  check(text->parentNode == nullptr &&
+            text->ownerDocument->arena().liveCount() == 1,
+        "a node outlives the tree it was in");
+  check(text->data == L"text", "the node is still usable");
+  text = nullptr;
+
+  return s_failures == 0 ? 0 : 1;
+}
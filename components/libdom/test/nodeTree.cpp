@@ -0,0 +1,92 @@
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/nodelist.h"
+#include "libdom/refptr.h"
+#include "libdom/text.h"
+#include "testing.h"
+#include <string>
+
+/** The text of the children, checked against the links both ways. */
+static std::wstring children(const LibDOM::Node &node) {
+  std::wstring out;
+  LibDOM::Node *previous = nullptr;
+  for (LibDOM::Node *child = node.firstChild(); child != nullptr;
+       child = child->nextSibling()) {
+    if (child->parentNode != &node || child->previousSibling() != previous)
+      return L"(broken links)";
+    out += static_cast<LibDOM::Text *>(child)->data.toWString();
+    previous = child;
+  }
+  if (node.lastChild() != previous)
+    return L"(broken links)";
+  return out;
+}
+
+int main() {
+  auto document = LibDOM::Document::create();
+  auto parent = document->createNode<LibDOM::HTMLElement>();
+  auto a = document->createNode<LibDOM::Text>(L"a");
+  auto b = document->createNode<LibDOM::Text>(L"b");
+  auto c = document->createNode<LibDOM::Text>(L"c");
+  auto d = document->createNode<LibDOM::Text>(L"d");
+
+  parent->appendChild(a);
+  parent->appendChild(c);
+  parent->insertBefore(b, c.get());
+  parent->insertBefore(d, nullptr);
+  check(children(*parent) == L"abcd", "appending and inserting");
+  parent->insertBefore(d, a.get());
+  check(children(*parent) == L"dabc", "inserting a child moves it");
+  parent->insertBefore(a, a.get());
+  check(children(*parent) == L"dabc", "inserting a node before itself");
+
+  auto &list = parent->childNodes();
+  check(list.length() == 4 && list.item(1) == a.get() &&
+            list.item(4) == nullptr,
+        "the child list");
+  auto removed = parent->removeChild(d.get());
+  check(removed == d && d->parentNode == nullptr &&
+            d->nextSibling() == nullptr && children(*parent) == L"abc",
+        "removing a child");
+  check(&parent->childNodes() == &list && list.length() == 3 &&
+            list.item(0) == a.get(),
+        "the child list is live");
+  check(parent->removeChild(d.get()) == nullptr,
+        "removing a node that isn't a child");
+
+  auto replaced = parent->replaceChild(d, b.get());
+  check(replaced == b && b->parentNode == nullptr &&
+            children(*parent) == L"adc",
+        "replacing a child");
+  parent->replaceChild(c, d.get());
+  check(children(*parent) == L"ac", "replacing a child with its sibling");
+
+  auto other = document->createNode<LibDOM::HTMLElement>();
+  other->appendChild(b);
+  other->appendChild(d);
+  parent->appendChild(d);
+  check(children(*parent) == L"acd" && children(*other) == L"b",
+        "appending a child of another node moves it");
+  other->appendChildrenOf(*parent);
+  check(children(*other) == L"bacd" && !parent->hasChildNodes() &&
+            list.length() == 0 && other->childNodes().length() == 4,
+        "moving all the children at once");
+
+  // the parent's reference is all that keeps a child alive
+  size_t live = document->arena().liveCount();
+  other->insertBefore(document->createNode<LibDOM::Text>(L"x"), nullptr);
+  check(document->arena().liveCount() == live + 1,
+        "children are held by their parent");
+  other->removeChild(other->lastChild());
+  check(document->arena().liveCount() == live, "removed children are freed");
+
+  size_t index = 0;
+  for (auto *node : other->childNodes()) {
+    if (other->childNodes().item(index++) != node)
+      break;
+  }
+  check(index == 4, "iterating over the children");
+
+  return s_failures == 0 ? 0 : 1;
+}
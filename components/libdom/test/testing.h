@@ -0,0 +1,68 @@
+#ifndef LIBDOM_TEST_TESTING_H
+#define LIBDOM_TEST_TESTING_H
+
+#include "libdom/comment.h"
+#include "libdom/element.h"
+#include "libdom/namednodemap.h"
+#include "libdom/node.h"
+#include "libdom/nodelist.h"
+#include "libdom/text.h"
+#include <iostream>
+#include <string>
+
+// What the tests of the components have in common. A test reports each check
+// that fails and carries on, and main() returns 1 if any did.
+
+inline int s_failures = 0;
+
+inline void fail(const char *what) {
+  std::cout << "[TEST FAIL] " << what << "\n";
+  s_failures++;
+}
+
+inline void check(bool condition, const char *what) {
+  if (!condition)
+    fail(what);
+}
+
+/**
+  Writes a tree as markup, like <p>1<b>2</b></p>, to compare it with the tree
+  a test expects. With `details`, text is quoted, and comments and attributes
+  are written too.
+*/
+inline void serialize(const LibDOM::Node &node, std::wstring &out,
+                      bool details = false) {
+  if (node.nodeType == LibDOM::Node::TEXT_NODE) {
+    auto &text = static_cast<const LibDOM::Text &>(node);
+    if (details)
+      out += L"\"" + text.data.toWString() + L"\"";
+    else
+      out += text.data.toWString();
+    return;
+  }
+  if (details && node.nodeType == LibDOM::Node::COMMENT_NODE) {
+    auto &comment = static_cast<const LibDOM::Comment &>(node);
+    out += L"<!--" + comment.data.toWString() + L"-->";
+    return;
+  }
+  auto name = node.nodeName().toWString();
+  out += L"<" + name;
+  if (details && node.nodeType == LibDOM::Node::ELEMENT_NODE) {
+    for (const auto &attribute :
+         static_cast<const LibDOM::Element &>(node).attributes)
+      out += L" " + attribute.name().toWString() + L"=" +
+             attribute.value.toWString();
+  }
+  out += L">";
+  for (const auto *child : node.childNodes())
+    serialize(*child, out, details);
+  out += L"</" + name + L">";
+}
+
+inline std::wstring serialize(const LibDOM::Node &node, bool details = false) {
+  std::wstring out;
+  serialize(node, out, details);
+  return out;
+}
+
+#endif
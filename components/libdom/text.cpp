@@ -1,11 +1,12 @@
 #include "libdom/text.h"
 #include "libdom/characterdata.h"
 #include "libdom/domstring.h"
+#include <utility>
 
 namespace LibDOM {
 
 Text::Text(DOMString data) : CharacterData() {
-  this->data = data;
+  this->data = std::move(data);
   this->nodeType = Node::TEXT_NODE;
 }
 
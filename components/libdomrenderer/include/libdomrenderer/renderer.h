@@ -1,8 +1,10 @@
 #ifndef LIBDOMRENDERER_RENDERER_H
 #define LIBDOMRENDERER_RENDERER_H
 
+#include "libdom/document.h"
 #include "libdom/element.h"
 #include "libdom/node.h"
+#include "libdom/refptr.h"
 #include "libdom/text.h"
 #include "libdomrenderer/viewport.h"
 #include <fontconfig/fontconfig.h>
@@ -17,8 +19,10 @@ class Renderer {
 public:
   Renderer();
   ~Renderer();
+  Renderer(const Renderer &) = delete;
+  Renderer &operator=(const Renderer &) = delete;
 
-  void renderToViewport(std::shared_ptr<LibDOM::Document> document,
+  void renderToViewport(LibDOM::RefPtr<LibDOM::Document> document,
                         std::shared_ptr<Viewport> viewport);
 
 private:
@@ -22,14 +22,21 @@ Renderer::Renderer() {
   }
   FT_Set_Pixel_Sizes(m_timesNewRoman, 0, 16);
 }
-Renderer::~Renderer() { FcFini(); }
 
-void Renderer::renderToViewport(std::shared_ptr<LibDOM::Document> document,
+// FcFini() would tear down fontconfig for every other renderer in the process,
+// so only what this one loaded is released
+Renderer::~Renderer() {
+  FT_Done_Face(m_timesNewRoman);
+  FT_Done_FreeType(m_freetype);
+  FcConfigDestroy(m_fontConfig);
+}
+
+void Renderer::renderToViewport(LibDOM::RefPtr<LibDOM::Document> document,
                                 std::shared_ptr<Viewport> viewport) {
-  if (document->body == nullptr)
+  if (document->body() == nullptr)
     return;
   (void)viewport;
-  // renderElement(document->body, viewport, 0, 0);
+  // renderElement(document->body(), viewport, 0, 0);
 }
 
 void Renderer::putBitmap(FT_Bitmap *bitmap, std::shared_ptr<Viewport> viewport,
@@ -0,0 +1,93 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/domstring.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Measures what attributes cost once they are parsed: the resident memory
+// each one takes, and how long looking one up on an element takes, which
+// selector matching and the renderer do for every element, by atom, and by a
+// name given as a string, as scripts do.
+
+#define ELEMENTS 200000
+#define ATTRIBUTES 3
+
+using namespace LibDOM::Atoms;
+
+static size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/** The resident memory a page of `ELEMENTS` links takes once it is parsed. */
+static size_t pageBytes(bool withAttributes,
+                        LibDOM::RefPtr<LibDOM::Document> &document) {
+  std::string page = "<!DOCTYPE html><body>";
+  for (int i = 0; i < ELEMENTS; i++) {
+    if (withAttributes)
+      page += "<a href=\"/" + std::to_string(i % 100) +
+              "\" class=link id=l" + std::to_string(i) + ">x</a>";
+    else
+      page += "<a>x</a>";
+  }
+  size_t before = residentBytes();
+  LibHTML::Parser parser;
+  parser.recoveryMode = LibHTML::BEST_EFFORT;
+  parser.parse(page.c_str(), page.size());
+  parser.finish();
+  document = parser.document;
+  return residentBytes() - before;
+}
+
+/** The time a lookup takes, for a function that does one on each element. */
+template <typename F> static double bestNanoseconds(F func) {
+  return bestSeconds(func) * 1e9 / ELEMENTS;
+}
+
+int main() {
+  LibDOM::RefPtr<LibDOM::Document> bare, document;
+  size_t bareBytes = pageBytes(false, bare);
+  size_t bytes = pageBytes(true, document);
+
+  std::vector<LibDOM::Element *> links;
+  for (LibDOM::Node *node = document->body()->firstChild(); node != nullptr;
+       node = node->nextSibling())
+    links.push_back(static_cast<LibDOM::Element *>(node));
+
+  size_t found = 0;
+  double get = bestNanoseconds([&] {
+    for (auto *link : links)
+      found += link->getAttribute(ATOM_id).length();
+  });
+  double has = bestNanoseconds([&] {
+    for (auto *link : links)
+      found += link->hasAttribute(ATOM_title);
+  });
+  LibDOM::DOMString id(L"id"), title(L"title");
+  double getString = bestNanoseconds([&] {
+    for (auto *link : links)
+      found += link->getAttribute(id).length();
+  });
+  double hasString = bestNanoseconds([&] {
+    for (auto *link : links)
+      found += link->hasAttribute(title);
+  });
+
+  printf("  per attribute        %8.1f bytes\n",
+         double(bytes - bareBytes) / (ELEMENTS * ATTRIBUTES));
+  printf("  getAttribute         %8.1f ns\n", get);
+  printf("  hasAttribute, absent %8.1f ns\n", has);
+  printf("  getAttribute(string) %8.1f ns\n", getString);
+  printf("  hasAttribute(string) %8.1f ns\n", hasString);
+  return found == 0 ? 1 : 0;
+}
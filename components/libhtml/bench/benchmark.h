@@ -0,0 +1,27 @@
+#ifndef LIBHTML_BENCH_BENCHMARK_H
+#define LIBHTML_BENCH_BENCHMARK_H
+
+#include <chrono>
+
+// What the benchmarks have in common. What a benchmark measures is timed a
+// few times, and the fastest run is reported, as it is the one that the rest
+// of the machine got in the way of the least.
+
+#define ITERATIONS 5
+
+/** The seconds the fastest of `iterations` calls to `func` took. */
+template <typename F>
+inline double bestSeconds(F func, int iterations = ITERATIONS) {
+  double best = 1e9;
+  for (int i = 0; i < iterations; i++) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+#endif
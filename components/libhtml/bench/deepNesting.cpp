@@ -0,0 +1,51 @@
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+
+// Measures the tree builder on deeply nested markup, where every p start tag,
+// p end tag and block end tag asks whether an element is in scope. The cost of
+// a tag shouldn't depend on how deep it is nested.
+
+#define PARAGRAPHS 2000
+
+/**
+  `depth` nested divs that all start with a paragraph, and a run of paragraphs
+  in the innermost one.
+*/
+static std::string makeDocument(size_t depth, size_t &tags) {
+  std::string document = "<!DOCTYPE html><html><head></head><body>\n";
+  tags = 4;
+  for (size_t i = 0; i < depth; i++) {
+    document += "<div class=level><p>nested paragraph</p>\n";
+    tags += 3;
+  }
+  for (size_t i = 0; i < PARAGRAPHS; i++) {
+    document += "<p>a paragraph with <b>bold</b> text\n";
+    tags += 3;
+  }
+  for (size_t i = 0; i < depth; i++) {
+    document += "</div>\n";
+    tags += 1;
+  }
+  document += "</body></html>\n";
+  tags += 2;
+  return document;
+}
+
+static void parse(const std::string &document) {
+  LibHTML::Parser parser;
+  parser.parse(document.c_str(), document.size());
+  parser.finish();
+}
+
+int main() {
+  for (size_t depth : {10, 100, 1000, 5000}) {
+    size_t tags = 0;
+    std::string document = makeDocument(depth, tags);
+    double secs = bestSeconds([&] { parse(document); });
+    printf("  depth %-6zu %8zu tags %10.1f ns/tag\n", depth, tags,
+           secs / tags * 1e9);
+  }
+  return 0;
+}
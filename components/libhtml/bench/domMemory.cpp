@@ -0,0 +1,103 @@
+#include "libdom/characterdata.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Measures how much resident memory the documents of a corpus take once they
+// are parsed, most of which is their text and attribute values. The pages to
+// parse can be given as arguments, and otherwise pages shaped like a news
+// article are made up: mostly ASCII, with some text in other scripts.
+
+#define COPIES 200
+
+static size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/** The code units in the text, comments and attribute values of a tree. */
+static size_t stringLength(LibDOM::Node &node) {
+  size_t length = 0;
+  if (node.nodeType == LibDOM::Node::TEXT_NODE ||
+      node.nodeType == LibDOM::Node::COMMENT_NODE)
+    length += static_cast<LibDOM::CharacterData &>(node).data.length();
+  if (node.nodeType == LibDOM::Node::ELEMENT_NODE) {
+    auto &attributes = static_cast<LibDOM::Element &>(node).attributes;
+    for (const auto &attribute : attributes)
+      length += attribute.value.length();
+  }
+  for (const auto &child : node.childNodes())
+    length += stringLength(*child);
+  return length;
+}
+
+static std::string articlePage(int seed) {
+  std::string page = "<!DOCTYPE html><html><head><title>Article " +
+                     std::to_string(seed) + "</title></head><body><nav>";
+  for (int i = 0; i < 20; i++) {
+    page += "<a href=\"/section/" + std::to_string(i) +
+            "\" class=\"nav-link nav-link-" + std::to_string(i) +
+            "\">Section " + std::to_string(i) + "</a> ";
+  }
+  page += "</nav><article>";
+  for (int i = 0; i < 40; i++) {
+    page += "<p class=\"body-text\">The committee met on Tuesday to discuss "
+            "the proposal, which would change how the <a href=\"https://"
+            "example.com/reports/" +
+            std::to_string(seed * 40 + i) +
+            "\">annual report</a> is published. Members raised <em>several"
+            "</em> concerns about the timeline and the budget.</p>";
+    if (i % 10 == 9) {
+      page += "<p lang=\"el\">Η επιτροπή συνεδρίασε την Τρίτη για να "
+              "συζητήσει την πρόταση.</p>";
+    }
+  }
+  page += "</article><footer>&copy; Example News</footer></body></html>";
+  return page;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> corpus;
+  for (int i = 1; i < argc; i++) {
+    std::ifstream file(argv[i]);
+    corpus.emplace_back(std::istreambuf_iterator<char>(file),
+                        std::istreambuf_iterator<char>());
+  }
+  if (corpus.empty()) {
+    for (int i = 0; i < 10; i++)
+      corpus.push_back(articlePage(i));
+  }
+
+  std::vector<LibDOM::RefPtr<LibDOM::Document>> documents;
+  size_t inputBytes = 0;
+  size_t characters = 0;
+  size_t before = residentBytes();
+  for (int copy = 0; copy < COPIES; copy++) {
+    for (const auto &page : corpus) {
+      LibHTML::Parser parser;
+      parser.recoveryMode = LibHTML::BEST_EFFORT;
+      parser.parse(page.c_str(), page.size());
+      parser.finish();
+      inputBytes += page.size();
+      characters += stringLength(*parser.document);
+      documents.push_back(parser.document);
+    }
+  }
+  size_t resident = residentBytes() - before;
+
+  printf("  documents            %10zu\n", documents.size());
+  printf("  input                %10.1f MB\n", inputBytes / 1e6);
+  printf("  string characters    %10.1f M\n", characters / 1e6);
+  printf("  resident memory      %10.1f MB\n", resident / 1e6);
+  printf("  per input byte       %10.2f bytes\n", double(resident) / inputBytes);
+  return 0;
+}
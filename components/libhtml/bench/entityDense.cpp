@@ -0,0 +1,89 @@
+#include "libhtml/entities.h"
+#include "libhtml/tokenizer.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+
+// Measures how fast the tokenizer gets through text and attribute values that
+// are dense with named character references, from short common ones to the
+// longest name in the table.
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+
+static std::string makeText() {
+  const std::string words[] = {
+      "Fish&nbsp;",  "&amp; ",       "chips&nbsp;", "&mdash; ",
+      "&pound;5 ",   "&ndash; ",     "&euro;7",     "&hellip; ",
+      "&lt;tag&gt; ", "&copy 2024 ", "&notit; ",
+      "&CounterClockwiseContourIntegral; ", "&nosuchthing;<br>\n"};
+  std::string text;
+  text.reserve(INPUT_SIZE + 64);
+  size_t i = 0;
+  while (text.size() < INPUT_SIZE)
+    text += words[i++ % 13];
+  return text;
+}
+
+static std::string makeAttributes() {
+  const std::string tag =
+      "<a href=\"/search?q=fish&amp;chips&copy=2\" title=\"R&amp;D &mdash; "
+      "&quot;Fish&nbsp;&amp;&nbsp;Chips&quot;\">\n";
+  std::string text;
+  text.reserve(INPUT_SIZE + tag.size());
+  while (text.size() < INPUT_SIZE)
+    text += tag;
+  return text;
+}
+
+static size_t tokenize(const std::string &text) {
+  // reused like a parser reuses its tokenizer, so the buffers are warm
+  static LibHTML::Tokenizer tokenizer;
+  tokenizer.reset();
+  size_t tokens = 0;
+  tokenizer.process(text.c_str(), text.size(),
+                    [&tokens](LibHTML::Token &) { tokens++; });
+  return tokens;
+}
+
+/** Looks up every reference in the text the way the tokenizer does. */
+static size_t matchAll(const std::string &text) {
+  size_t matches = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '&')
+      continue;
+    size_t node = LibHTML::ENTITY_ROOT;
+    for (size_t j = i + 1; j < text.size(); j++) {
+      node = LibHTML::entityStep(node, text[j]);
+      if (node == LibHTML::ENTITY_ROOT)
+        break;
+      if (!LibHTML::entityValue(node).empty())
+        matches++;
+    }
+  }
+  return matches;
+}
+
+static size_t countReferences(const std::string &text) {
+  size_t count = 0;
+  for (char c : text)
+    count += c == '&';
+  return count;
+}
+
+static void report(const char *what, const std::string &text, double secs) {
+  printf("  %-30s %10.1f MB/s %10.1f M refs/s\n", what,
+         text.size() / secs / (1024 * 1024),
+         countReferences(text) / secs / 1e6);
+}
+
+int main() {
+  const std::string text = makeText();
+  const std::string attributes = makeAttributes();
+
+  report("match references in text", text,
+         bestSeconds([&] { matchAll(text); }));
+  report("tokenize text (DATA)", text, bestSeconds([&] { tokenize(text); }));
+  report("tokenize attribute values", attributes,
+         bestSeconds([&] { tokenize(attributes); }));
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Measures parsing many small fragments, the way a templating pipeline does,
+// with one parser and the fragment parsing algorithm against a new parser and
+// a whole document around every fragment.
+
+#define FRAGMENTS 10000
+
+using namespace LibDOM::Atoms;
+
+static LibDOM::RefPtr<LibDOM::Node>
+findBody(const LibDOM::RefPtr<LibDOM::Node> &node) {
+  if (node->nodeType == LibDOM::Node::ELEMENT_NODE &&
+      static_cast<LibDOM::Element &>(*node).localName == ATOM_body)
+    return node;
+  for (const auto &child : node->childNodes()) {
+    if (auto body = findBody(child))
+      return body;
+  }
+  return nullptr;
+}
+
+int main() {
+  std::vector<std::string> fragments;
+  for (size_t i = 0; i < FRAGMENTS; i++) {
+    fragments.push_back("<div class=\"item\"><a href=\"/items/" +
+                        std::to_string(i) + "\">Item " + std::to_string(i) +
+                        "</a> <b>new</b></div>");
+  }
+
+  std::vector<LibDOM::RefPtr<LibDOM::Node>> nodes;
+  double documents = bestSeconds([&] {
+    nodes.clear();
+    for (const auto &fragment : fragments) {
+      std::string document =
+          "<!DOCTYPE html><html><head></head><body>" + fragment;
+      LibHTML::Parser parser;
+      parser.parse(document.c_str(), document.size());
+      parser.finish();
+      for (auto *child : findBody(parser.document)->childNodes())
+        nodes.push_back(child);
+    }
+  });
+
+  LibHTML::Parser parser;
+  auto context = parser.document->createNode<LibDOM::HTMLElement>();
+  context->namespaceURI = HTML_NAMESPACE;
+  context->localName = ATOM_body;
+  double fragmentParsing = bestSeconds([&] {
+    nodes.clear();
+    for (const auto &fragment : fragments)
+      parser.parseFragment(*context, fragment.c_str(), fragment.size(), nodes);
+  });
+
+  printf("  whole documents %10.0f fragments/s\n", FRAGMENTS / documents);
+  printf("  fragments       %10.0f fragments/s\n", FRAGMENTS / fragmentParsing);
+  return 0;
+}
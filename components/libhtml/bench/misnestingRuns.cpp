@@ -0,0 +1,38 @@
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+
+// Measures adversarial runs of misnested formatting elements, which the
+// adoption agency algorithm and the reconstruction of active formatting
+// elements handle. The cost of a repetition shouldn't depend on how many came
+// before it; with a quadratic algorithm, 5000 repetitions would take about 20
+// times as long each as 250.
+
+static void parse(const std::string &document) {
+  LibHTML::Parser parser;
+  parser.parse(document.c_str(), document.size());
+  parser.finish();
+}
+
+int main() {
+  for (const char *unit : {
+           "<b>1<i>2</b>3</i>",
+           "<b>1<p>2</b>3</p>",
+           "<a>1<div>2<a>3</div>",
+           "<b><i><u><s>1<p>2</b>",
+           "<b>1</i>",
+           "<div><b><span><span><span><span><p>1</b>",
+       }) {
+    printf("  %s\n", unit);
+    for (size_t count : {250, 1000, 5000}) {
+      std::string document = "<!DOCTYPE html><html><head></head><body>";
+      for (size_t i = 0; i < count; i++)
+        document += unit;
+      double secs = bestSeconds([&] { parse(document); });
+      printf("    %6zu repetitions %10.1f ns each\n", count,
+             secs / count * 1e9);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "libdom/document.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+// Measures parsing a large document and then dropping it, which is how most
+// documents end, as the time to free a tree of many small nodes can be a good
+// part of the time it took to build it.
+
+#define SECTIONS 10000
+
+static std::string largePage() {
+  std::string page = "<!DOCTYPE html><html><head><title>Large</title></head>"
+                     "<body>";
+  for (int i = 0; i < SECTIONS; i++) {
+    std::string n = std::to_string(i);
+    page += "<section id=\"s" + n + "\"><h2 class=\"title\">Section " + n +
+            "</h2><p>Some <b>bold</b> and <i>italic</i> text, with a <a "
+            "href=\"/link/" +
+            n + "\">link</a>.</p><ul>";
+    for (int j = 0; j < 5; j++)
+      page += "<li class=\"item\">Item " + std::to_string(j) + "</li>";
+    page += "</ul><table><tr><td>1</td><td>2</td></tr></table><!-- " + n +
+            " --></section>";
+  }
+  page += "</body></html>";
+  return page;
+}
+
+int main() {
+  std::string page = largePage();
+
+  double bestParse = 1e9, bestFree = 1e9, bestTotal = 1e9;
+  for (int i = 0; i < ITERATIONS; i++) {
+    auto start = std::chrono::steady_clock::now();
+    LibDOM::RefPtr<LibDOM::Document> document;
+    {
+      LibHTML::Parser parser;
+      parser.recoveryMode = LibHTML::BEST_EFFORT;
+      parser.parse(page.c_str(), page.size());
+      parser.finish();
+      document = std::move(parser.document);
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    document = nullptr;
+    auto freed = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> parse = parsed - start;
+    std::chrono::duration<double> free = freed - parsed;
+    if (parse.count() < bestParse)
+      bestParse = parse.count();
+    if (free.count() < bestFree)
+      bestFree = free.count();
+    if (parse.count() + free.count() < bestTotal)
+      bestTotal = parse.count() + free.count();
+  }
+
+  double megabytes = page.size() / 1e6;
+  printf("  input           %8.1f MB\n", megabytes);
+  printf("  parse           %8.2f ms\n", bestParse * 1e3);
+  printf("  free            %8.2f ms\n", bestFree * 1e3);
+  printf("  parse and free  %8.1f MB/s\n", megabytes / bestTotal);
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include "libhtml/parser.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+
+// Measures parsing a large document on one thread against parsing it with the
+// tokenizer running ahead on a worker thread.
+
+#define ITEMS 20000
+
+static std::string makeDocument() {
+  std::string document = "<!DOCTYPE html><html><head><title>a large "
+                         "document</title><style>p { }</style></head><body>\n";
+  for (size_t i = 0; i < ITEMS; i++) {
+    document += "<div class=\"item\" id=\"item" + std::to_string(i) +
+                "\"><p>a paragraph with <b>bold</b>, <a href=\"/link\">a "
+                "link</a> and &amp; some text</p></div>\n";
+  }
+  document += "</body></html>\n";
+  return document;
+}
+
+int main() {
+  std::string document = makeDocument();
+  double single = bestSeconds([&] {
+    LibHTML::Parser parser;
+    parser.parse(document.c_str(), document.size());
+    parser.finish();
+  });
+  double pipelined = bestSeconds([&] {
+    LibHTML::Parser parser;
+    parser.parsePipelined(document.c_str(), document.size());
+  });
+
+  double mb = document.size() / 1e6;
+  printf("  one thread  %8.2f ms %8.1f MB/s\n", single * 1e3, mb / single);
+  printf("  pipelined   %8.2f ms %8.1f MB/s\n", pipelined * 1e3,
+         mb / pipelined);
+  return 0;
+}
@@ -0,0 +1,49 @@
+#include "libhtml/parserpool.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Measures how the throughput of a ParserPool grows with its threads. Parsers
+// share nothing, so it should grow about linearly up to the number of cores.
+
+#define POOL_ITERATIONS 3
+#define DOCUMENTS 256
+#define ITEMS 200
+
+static std::string makeDocument(size_t index) {
+  std::string document = "<!DOCTYPE html><html><head><title>document " +
+                         std::to_string(index) + "</title></head><body>\n";
+  for (size_t i = 0; i < ITEMS; i++) {
+    document += "<div class=\"item\"><p>a paragraph with <b>bold</b>, <a "
+                "href=\"/link\">a link</a> and &amp; some text</p></div>\n";
+  }
+  document += "</body></html>\n";
+  return document;
+}
+
+int main() {
+  std::vector<std::string> documents;
+  size_t bytes = 0;
+  for (size_t i = 0; i < DOCUMENTS; i++) {
+    documents.push_back(makeDocument(i));
+    bytes += documents.back().size();
+  }
+  std::vector<std::string_view> views(documents.begin(), documents.end());
+
+  size_t cores = std::thread::hardware_concurrency();
+  printf("  %zu cores\n", cores);
+  double base = 0;
+  for (size_t threads = 1; threads <= 2 * cores || threads == 1;
+       threads *= 2) {
+    LibHTML::ParserPool pool(threads);
+    double secs = bestSeconds([&] { pool.parse(views); }, POOL_ITERATIONS);
+    if (threads == 1)
+      base = secs;
+    printf("  %3zu threads %8.1f MB/s %6.2fx\n", threads, bytes / secs / 1e6,
+           base / secs);
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "libhtml/scanner.h"
+#include "libhtml/tokenizer.h"
+#include "benchmark.h"
+#include <codecvt>
+#include <cstdio>
+#include <iostream>
+#include <locale>
+#include <string>
+
+// Measures how fast the text states get through large bodies of plain text
+// with each scanner implementation. The scalar implementation is what the
+// tokenizer did before the vector scanners existed. The wstring_convert numbers
+// are for the conversion Parser::parse() used to do before tokenizing.
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+
+static std::string makeParagraph() {
+  const std::string words[] = {"lorem ", "ipsum ",  "dolor ", "sit ",
+                               "amet, ", "consectetur ", "adipiscing ",
+                               "elit.<br>\n"};
+  std::string text;
+  text.reserve(INPUT_SIZE + 16);
+  size_t i = 0;
+  while (text.size() < INPUT_SIZE)
+    text += words[i++ % 8];
+  return text;
+}
+
+// the same kind of text, but with a multibyte character in most words
+static std::string makeUTF8Paragraph() {
+  const std::string words[] = {"größe ", "café ", "naïve ", "日本語 ",
+                               "Ελληνικά ", "déjà ", "vu ", "fin.<br>\n"};
+  std::string text;
+  text.reserve(INPUT_SIZE + 16);
+  size_t i = 0;
+  while (text.size() < INPUT_SIZE)
+    text += words[i++ % 8];
+  return text;
+}
+
+static std::string makeScript() {
+  const std::string line =
+      "  for (var i = 0; i != items.length; i++) { total += items[i].value "
+      "&& 1; }\n";
+  std::string text;
+  text.reserve(INPUT_SIZE + line.size());
+  while (text.size() < INPUT_SIZE)
+    text += line;
+  return text;
+}
+
+static size_t scanAll(const std::string &text, bool stopAtAmpersand) {
+  size_t stops = 0;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    pos += LibHTML::findTextSentinel(&text[pos], text.size() - pos,
+                                     stopAtAmpersand) +
+           1;
+    stops++;
+  }
+  return stops;
+}
+
+static size_t tokenize(const std::string &text,
+                       LibHTML::TokenizerState state) {
+  // reused like a parser reuses its tokenizer, so the buffers are warm
+  static LibHTML::Tokenizer tokenizer;
+  tokenizer.reset();
+  tokenizer.currentState = state;
+  size_t tokens = 0;
+  tokenizer.process(text.c_str(), text.size(),
+                    [&tokens](LibHTML::Token &) { tokens++; });
+  return tokens;
+}
+
+static size_t convert(const std::string &text) {
+  std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+  return converter.from_bytes(text).size();
+}
+
+static void report(const char *what, const std::string &text, double secs) {
+  printf("  %-30s %10.1f MB/s\n", what, text.size() / secs / (1024 * 1024));
+}
+
+int main() {
+  const std::string paragraph = makeParagraph();
+  const std::string utf8Paragraph = makeUTF8Paragraph();
+  const std::string script = makeScript();
+
+  const struct {
+    LibHTML::ScannerImpl impl;
+    const char *name;
+  } impls[] = {
+      {LibHTML::SCANNER_SCALAR, "scalar"},
+      {LibHTML::SCANNER_SSE2, "sse2"},
+      {LibHTML::SCANNER_AVX2, "avx2"},
+  };
+
+  printf("wstring_convert:\n");
+  report("convert text", paragraph, bestSeconds([&] { convert(paragraph); }));
+  report("convert UTF-8 text", utf8Paragraph,
+         bestSeconds([&] { convert(utf8Paragraph); }));
+
+  size_t expectedStops = 0;
+  for (const auto &impl : impls) {
+    if (!LibHTML::setScannerImpl(impl.impl)) {
+      printf("%s: not supported on this CPU\n", impl.name);
+      continue;
+    }
+    printf("%s:\n", impl.name);
+
+    // every implementation has to stop at exactly the same places
+    size_t stops = scanAll(paragraph, true) + scanAll(script, false);
+    if (expectedStops == 0)
+      expectedStops = stops;
+    if (stops != expectedStops) {
+      printf("[BENCH FAIL] %s disagrees with the scalar scanner\n", impl.name);
+      return 1;
+    }
+
+    report("scan text", paragraph,
+           bestSeconds([&] { scanAll(paragraph, true); }));
+    report("scan script", script,
+           bestSeconds([&] { scanAll(script, false); }));
+    report("tokenize text (DATA)", paragraph,
+           bestSeconds([&] { tokenize(paragraph, LibHTML::DATA); }));
+    report("tokenize UTF-8 text (DATA)", utf8Paragraph,
+           bestSeconds([&] { tokenize(utf8Paragraph, LibHTML::DATA); }));
+    report("tokenize script (SCRIPT_DATA)", script,
+           bestSeconds([&] { tokenize(script, LibHTML::SCRIPT_DATA); }));
+  }
+
+  return 0;
+}
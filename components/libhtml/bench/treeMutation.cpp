@@ -0,0 +1,50 @@
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libdom/text.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <vector>
+
+// Measures inserting, replacing and removing children of an element with
+// many of them, the way scripts build lists, which must not get slower per
+// child as the list gets longer.
+
+int main() {
+  auto document = LibDOM::Document::create();
+  auto list = document->createNode<LibDOM::HTMLElement>();
+
+  for (size_t children : {1000, 10000, 100000}) {
+    std::vector<LibDOM::RefPtr<LibDOM::Node>> items;
+    for (size_t i = 0; i < children; i++)
+      items.push_back(document->createNode<LibDOM::Text>(L"item"));
+
+    double insert = bestSeconds([&] {
+      for (auto &item : items)
+        list->insertBefore(item, list->firstChild());
+    });
+    double replace = bestSeconds([&] {
+      // puts every item back where it was, half way down the list
+      LibDOM::Node *middle = items[children / 2].get();
+      for (auto &item : items) {
+        if (item.get() != middle)
+          list->replaceChild(list->replaceChild(item, middle), item.get());
+      }
+    });
+    double remove = bestSeconds([&] {
+      while (list->hasChildNodes())
+        list->removeChild(list->firstChild());
+      for (auto &item : items)
+        list->appendChild(item);
+    });
+    while (list->hasChildNodes())
+      list->removeChild(list->lastChild());
+
+    printf("%7zu children:  insert first %6.1f ns  replace %6.1f ns  "
+           "remove first %6.1f ns\n",
+           children, insert * 1e9 / children, replace * 1e9 / children / 2,
+           remove * 1e9 / children / 2);
+  }
+  return 0;
+}
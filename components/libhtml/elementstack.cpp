@@ -0,0 +1,147 @@
+#include "libhtml/elementstack.h"
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include "libhtml/tagsets.h"
+#include <cassert>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace LibHTML {
+
+static const TagSet *const SCOPE_BOUNDARY_SETS[SCOPE_COUNT] = {
+    &SCOPE_BOUNDARIES,
+    &LIST_ITEM_SCOPE_BOUNDARIES,
+    &BUTTON_SCOPE_BOUNDARIES,
+    &TABLE_SCOPE_BOUNDARIES,
+    &SPECIAL_ELEMENTS,
+};
+
+void ElementStack::push_back(LibDOM::RefPtr<LibDOM::Element> element) {
+  auto name = element->localName;
+  if (m_topmost.empty())
+    m_topmost.resize(LibDOM::Atoms::KNOWN_ATOM_COUNT, 0);
+
+  Links links;
+  links.previousSameName = topmost(name);
+  size_t position = m_elements.size() + 1;
+  for (size_t scope = 0; scope < SCOPE_COUNT; scope++) {
+    size_t below = m_links.empty() ? 0 : m_links.back().boundaries[scope];
+    // FIXME: check the namespace too once there is foreign content
+    links.boundaries[scope] =
+        SCOPE_BOUNDARY_SETS[scope]->contains(name) ? position : below;
+  }
+
+  if (name < LibDOM::Atoms::KNOWN_ATOM_COUNT)
+    m_topmost[name] = position;
+  else
+    m_dynamicTopmost[name] = position;
+  m_elements.push_back(std::move(element));
+  m_links.push_back(links);
+}
+
+void ElementStack::pop_back() {
+  auto name = m_elements.back()->localName;
+  size_t previous = m_links.back().previousSameName;
+  if (name < LibDOM::Atoms::KNOWN_ATOM_COUNT)
+    m_topmost[name] = previous;
+  else if (previous == 0)
+    m_dynamicTopmost.erase(name);
+  else
+    m_dynamicTopmost[name] = previous;
+  m_elements.pop_back();
+  m_links.pop_back();
+}
+
+void ElementStack::erase(const_iterator position) {
+  // everything above the element has to be linked up again, which pushing it
+  // back does
+  size_t index = position - m_elements.begin();
+  std::vector<LibDOM::RefPtr<LibDOM::Element>> above(
+      m_elements.begin() + index + 1, m_elements.end());
+  while (m_elements.size() > index)
+    pop_back();
+  for (auto &element : above)
+    push_back(std::move(element));
+}
+
+void ElementStack::insert(const_iterator position,
+                          LibDOM::RefPtr<LibDOM::Element> element) {
+  size_t index = position - m_elements.begin();
+  std::vector<LibDOM::RefPtr<LibDOM::Element>> above(
+      m_elements.begin() + index, m_elements.end());
+  while (m_elements.size() > index)
+    pop_back();
+  push_back(std::move(element));
+  for (auto &element : above)
+    push_back(std::move(element));
+}
+
+void ElementStack::replace(const_iterator position,
+                           LibDOM::RefPtr<LibDOM::Element> element) {
+  // the links only depend on the names, so they stay as they are
+  size_t index = position - m_elements.begin();
+  assert(m_elements[index]->localName == element->localName);
+  m_elements[index] = std::move(element);
+}
+
+void ElementStack::clear() {
+  m_elements.clear();
+  m_links.clear();
+  m_topmost.clear();
+  m_dynamicTopmost.clear();
+}
+
+size_t ElementStack::topmost(LibDOM::Atom name) const {
+  if (name < LibDOM::Atoms::KNOWN_ATOM_COUNT)
+    return name < m_topmost.size() ? m_topmost[name] : 0;
+  auto it = m_dynamicTopmost.find(name);
+  return it == m_dynamicTopmost.end() ? 0 : it->second;
+}
+
+bool ElementStack::contains(LibDOM::Atom name) const {
+  return topmost(name) != 0;
+}
+
+bool ElementStack::contains(
+    const LibDOM::RefPtr<LibDOM::Element> &element) const {
+  return find(element) != 0;
+}
+
+size_t ElementStack::find(const LibDOM::RefPtr<LibDOM::Element> &element,
+                          size_t hint) const {
+  if (hint != 0 && hint <= m_elements.size() &&
+      m_elements[hint - 1] == element)
+    return hint;
+  for (size_t position = topmost(element->localName); position != 0;
+       position = m_links[position - 1].previousSameName) {
+    if (m_elements[position - 1] == element)
+      return position;
+  }
+  return 0;
+}
+
+bool ElementStack::hasInScope(LibDOM::Atom name, Scope scope) const {
+  // the element is in scope if it is open and no boundary is above it; a
+  // boundary is in scope itself, as the steps check for the target first
+  size_t position = topmost(name);
+  return position != 0 && position >= m_links.back().boundaries[scope];
+}
+
+bool ElementStack::hasInScope(const LibDOM::RefPtr<LibDOM::Element> &element,
+                              Scope scope) const {
+  if (m_elements.empty())
+    return false;
+  size_t boundary = m_links.back().boundaries[scope];
+  for (size_t position = topmost(element->localName);
+       position != 0 && position >= boundary;
+       position = m_links[position - 1].previousSameName) {
+    if (m_elements[position - 1] == element)
+      return true;
+  }
+  return false;
+}
+
+} // namespace LibHTML
@@ -0,0 +1,46 @@
+#include "libhtml/entities.h"
+#include <cstddef>
+#include <string_view>
+
+namespace LibHTML {
+
+struct EntityTrieNode {
+  /**
+    Bit n is set if the name goes on with the character whose symbol is n.
+    The children are stored next to each other, in the order of their
+    symbols, so a child's index is the number of bits set below its own.
+  */
+  unsigned long long children;
+  unsigned short firstChild;
+  /** Index into ENTITY_VALUES. */
+  unsigned short value;
+};
+
+#include "entitytable.inc"
+
+// __builtin_popcountll() is a library call unless the target has POPCNT
+static inline unsigned countBits(unsigned long long x) {
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return (x * 0x0101010101010101ull) >> 56;
+}
+
+size_t entityStep(size_t node, wchar_t c) {
+  if (c < 0 || c >= 128 || ENTITY_SYMBOLS[c] == 0)
+    return ENTITY_ROOT;
+  unsigned long long bit = 1ull << (ENTITY_SYMBOLS[c] - 1);
+  const EntityTrieNode &parent = ENTITY_NODES[node];
+  if (!(parent.children & bit))
+    return ENTITY_ROOT;
+  return parent.firstChild + countBits(parent.children & (bit - 1));
+}
+
+std::wstring_view entityValue(size_t node) {
+  const wchar_t *value = ENTITY_VALUES[ENTITY_NODES[node].value];
+  if (value[0] == 0)
+    return {};
+  return std::wstring_view(value, value[1] == 0 ? 1 : 2);
+}
+
+} // namespace LibHTML
@@ -0,0 +1,44 @@
+#include "libhtml/fetchqueue.h"
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace LibHTML {
+
+bool FetchQueue::push(FetchRequest request) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (request.url.empty() || !m_seen.insert(request.url).second)
+    return false;
+  m_requests[request.priority].push_back(std::move(request));
+  return true;
+}
+
+bool FetchQueue::pop(FetchRequest &request) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto &requests : m_requests) {
+    if (!requests.empty()) {
+      request = std::move(requests.front());
+      requests.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t FetchQueue::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t size = 0;
+  for (const auto &requests : m_requests)
+    size += requests.size();
+  return size;
+}
+
+void FetchQueue::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto &requests : m_requests)
+    requests.clear();
+  m_seen.clear();
+}
+
+} // namespace LibHTML
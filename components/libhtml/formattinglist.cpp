@@ -0,0 +1,128 @@
+#include "libhtml/formattinglist.h"
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include "libhtml/elementstack.h"
+#include <cstddef>
+#include <utility>
+
+namespace LibHTML {
+
+/** Whether two elements have the same attributes, in any order. */
+static bool sameAttributes(LibDOM::Element &a, LibDOM::Element &b) {
+  if (a.attributes.length() != b.attributes.length())
+    return false;
+  for (const auto &attribute : a.attributes) {
+    auto *other = b.attributes.find(attribute.localName);
+    if (other == nullptr || other->namespaceURI != attribute.namespaceURI ||
+        other->value != attribute.value)
+      return false;
+  }
+  return true;
+}
+
+bool FormattingList::push(LibDOM::RefPtr<LibDOM::Element> element,
+                          size_t stackPosition, size_t limit) {
+  // "If there are already three elements in the list of active formatting
+  // elements after the last marker, if any, or anywhere in the list if there
+  // are no markers, that have the same tag name, namespace, and attributes as
+  // element, then remove the earliest such element from the list"
+  int count = 0;
+  size_t first = m_entries.size();
+  for (size_t i = m_entries.size(); i-- > 0;) {
+    const auto &entry = m_entries[i];
+    if (entry.isMarker())
+      break;
+    first = i;
+    // the names are compared first, as they rule out most entries cheaply
+    if (entry.element->localName != element->localName ||
+        entry.element->namespaceURI != element->namespaceURI ||
+        !sameAttributes(*entry.element, *element))
+      continue;
+    if (++count == 3) {
+      erase(i);
+      // the list is no longer than it was, so it is within the limit
+      limit = 0;
+      break;
+    }
+  }
+  bool full = limit != 0 && m_entries.size() - first >= limit;
+  if (full)
+    erase(first);
+  insert(m_entries.size(), std::move(element), stackPosition);
+  return full;
+}
+
+void FormattingList::insertMarker() { m_entries.push_back({nullptr, 0}); }
+
+void FormattingList::clearUpToLastMarker() {
+  while (!m_entries.empty()) {
+    bool marker = m_entries.back().isMarker();
+    erase(m_entries.size() - 1);
+    if (marker)
+      return;
+  }
+}
+
+void FormattingList::insert(size_t index,
+                            LibDOM::RefPtr<LibDOM::Element> element,
+                            size_t stackPosition) {
+  m_members.insert(element.get());
+  m_entries.insert(m_entries.begin() + index,
+                   {std::move(element), stackPosition});
+}
+
+void FormattingList::replace(size_t index,
+                             LibDOM::RefPtr<LibDOM::Element> element,
+                             size_t stackPosition) {
+  m_members.erase(m_entries[index].element.get());
+  m_members.insert(element.get());
+  m_entries[index] = {std::move(element), stackPosition};
+}
+
+void FormattingList::erase(size_t index) {
+  if (!m_entries[index].isMarker())
+    m_members.erase(m_entries[index].element.get());
+  m_entries.erase(m_entries.begin() + index);
+}
+
+void FormattingList::clear() {
+  m_entries.clear();
+  m_members.clear();
+}
+
+bool FormattingList::contains(
+    const LibDOM::RefPtr<LibDOM::Element> &element) const {
+  return m_members.count(element.get()) != 0;
+}
+
+size_t FormattingList::find(
+    const LibDOM::RefPtr<LibDOM::Element> &element) const {
+  if (!contains(element))
+    return NOT_FOUND;
+  // the elements that are looked up are usually near the end
+  for (size_t i = m_entries.size(); i-- > 0;) {
+    if (m_entries[i].element == element)
+      return i;
+  }
+  return NOT_FOUND;
+}
+
+size_t FormattingList::findAfterLastMarker(LibDOM::Atom name) const {
+  for (size_t i = m_entries.size(); i-- > 0;) {
+    if (m_entries[i].isMarker())
+      break;
+    if (m_entries[i].element->localName == name)
+      return i;
+  }
+  return NOT_FOUND;
+}
+
+size_t FormattingList::stackPosition(size_t index,
+                                     const ElementStack &stack) const {
+  const auto &entry = m_entries[index];
+  entry.stackPosition = stack.find(entry.element, entry.stackPosition);
+  return entry.stackPosition;
+}
+
+} // namespace LibHTML
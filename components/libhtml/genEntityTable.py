@@ -1,2 +1,99 @@
-# TODO
-# https://html.spec.whatwg.org/entities.json
+#!/usr/bin/env python3
+"""Generates entitytable.inc, the named character reference trie.
+
+https://html.spec.whatwg.org/multipage/named-characters.html
+
+Usage: genEntityTable.py [entities.json] > entitytable.inc
+
+Without an argument the table that ships with Python (html.entities.html5) is
+used, which is generated from the same https://html.spec.whatwg.org/entities.json.
+"""
+
+import html.entities
+import json
+import sys
+
+
+def load_entities():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], encoding="utf-8") as f:
+            return {
+                name.lstrip("&"): entity["characters"]
+                for name, entity in json.load(f).items()
+            }
+    return dict(html.entities.html5)
+
+
+def build_trie(entities):
+    # every node is [character, children (dict), value]
+    root = [None, {}, None]
+    for name, value in entities.items():
+        node = root
+        for c in name:
+            node = node[1].setdefault(c, [c, {}, None])
+        node[2] = value
+    return root
+
+
+def main():
+    entities = load_entities()
+    root = build_trie(entities)
+
+    # breadth first, so that the children of each node are next to each other
+    # and sorted by character, which is also the order of their symbols
+    nodes = [root]
+    first_child = []
+    i = 0
+    while i < len(nodes):
+        node = nodes[i]
+        first_child.append(len(nodes))
+        nodes.extend(node[1][c] for c in sorted(node[1]))
+        i += 1
+    assert len(nodes) < 0x10000
+
+    values = sorted({node[2] for node in nodes if node[2] is not None})
+    value_index = {value: index + 1 for index, value in enumerate(values)}
+
+    # the names only use a few ASCII characters, so the children of a node fit
+    # in a bit mask indexed by symbol
+    alphabet = sorted({c for name in entities for c in name})
+    assert len(alphabet) <= 64
+    symbol = {c: index for index, c in enumerate(alphabet)}
+
+    out = sys.stdout
+    out.write("// Generated by genEntityTable.py, do not edit.\n")
+    out.write(f"// {len(entities)} named character references, {len(nodes)} "
+              "trie nodes.\n\n")
+
+    out.write("// symbol + 1 of every ASCII character, 0 if no name uses it\n")
+    out.write("static constexpr unsigned char ENTITY_SYMBOLS[128] = {\n")
+    row = []
+    for c in range(128):
+        row.append(str(symbol[chr(c)] + 1 if chr(c) in symbol else 0))
+        if len(row) == 16:
+            out.write("    " + ", ".join(row) + ",\n")
+            row = []
+    out.write("};\n\n")
+
+    out.write("static constexpr EntityTrieNode ENTITY_NODES[] = {\n")
+    for i, node in enumerate(nodes):
+        mask = 0
+        for c in node[1]:
+            mask |= 1 << symbol[c]
+        value = value_index.get(node[2], 0)
+        out.write(f"    {{0x{mask:X}ull, {first_child[i]}, {value}}},\n")
+    out.write("};\n\n")
+
+    out.write("// index 0 means that no reference ends at the node\n")
+    out.write("static constexpr wchar_t ENTITY_VALUES[][2] = {\n")
+    out.write("    {0, 0},\n")
+    for value in values:
+        chars = ", ".join(f"0x{ord(c):X}" for c in value)
+        if len(value) == 1:
+            chars += ", 0"
+        out.write(f"    {{{chars}}},\n")
+    out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,7 +1,11 @@
 #ifndef LIBHTML_H
 #define LIBHTML_H
 
+#include "libhtml/fetchqueue.h"
 #include "libhtml/parser.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/parserpool.h"
+#include "libhtml/preloadscanner.h"
 #include "libhtml/tokenizer.h"
 
 #endif
@@ -0,0 +1,112 @@
+#ifndef LIBHTML_ELEMENTSTACK_H
+#define LIBHTML_ELEMENTSTACK_H
+
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace LibHTML {
+
+/**
+  The kinds of scope that an element can be in.
+  https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-the-specific-scope
+*/
+enum Scope {
+  DEFAULT_SCOPE,
+  LIST_ITEM_SCOPE,
+  BUTTON_SCOPE,
+  TABLE_SCOPE,
+  /**
+    Not one of the spec's scopes: its boundaries are the special elements,
+    which is how far down the stack an "any other end tag" looks for its
+    element in the in body insertion mode.
+  */
+  SPECIAL_SCOPE,
+  SCOPE_COUNT,
+};
+
+/**
+  https://html.spec.whatwg.org/multipage/parsing.html#stack-of-open-elements
+
+  Besides the elements, the stack keeps track of the topmost open element of
+  every name and the topmost boundary of every kind of scope, and updates them
+  as elements are pushed and popped. "Has an element in scope" is then a
+  matter of comparing two positions, however deep the stack is.
+*/
+class ElementStack {
+public:
+  typedef std::vector<LibDOM::RefPtr<LibDOM::Element>>::const_iterator
+      const_iterator;
+
+  void push_back(LibDOM::RefPtr<LibDOM::Element> element);
+  void pop_back();
+  void erase(const_iterator position);
+  void insert(const_iterator position,
+              LibDOM::RefPtr<LibDOM::Element> element);
+  /** Puts another element with the same name in place of an element. */
+  void replace(const_iterator position,
+               LibDOM::RefPtr<LibDOM::Element> element);
+  void clear();
+
+  const LibDOM::RefPtr<LibDOM::Element> &back() const {
+    return m_elements.back();
+  }
+  const LibDOM::RefPtr<LibDOM::Element> &operator[](size_t index) const {
+    return m_elements[index];
+  }
+  size_t size() const { return m_elements.size(); }
+  bool empty() const { return m_elements.empty(); }
+  const_iterator begin() const { return m_elements.begin(); }
+  const_iterator end() const { return m_elements.end(); }
+
+  /** Whether an element with the given name is open. */
+  bool contains(LibDOM::Atom name) const;
+  bool contains(const LibDOM::RefPtr<LibDOM::Element> &element) const;
+  /**
+    Where an element is on the stack, as its index + 1, or 0 if it isn't open.
+    `hint` is where the element was last seen, which is checked first, so
+    callers that hold on to positions find their elements in constant time
+    unless something below them was taken out of the stack.
+  */
+  size_t find(const LibDOM::RefPtr<LibDOM::Element> &element,
+              size_t hint = 0) const;
+
+  /** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-the-specific-scope */
+  bool hasInScope(LibDOM::Atom name, Scope scope = DEFAULT_SCOPE) const;
+  /**
+    Same as hasInScope(name), for a particular element. This looks at the open
+    elements with the same name above the scope boundary, which there are only
+    a few of in practice.
+  */
+  bool hasInScope(const LibDOM::RefPtr<LibDOM::Element> &element,
+                  Scope scope = DEFAULT_SCOPE) const;
+
+private:
+  // positions in the stack are stored as index + 1, so that 0 means none
+  struct Links {
+    /** The next lower open element with the same name. */
+    size_t previousSameName;
+    /** The topmost boundary of every kind of scope, up to this element. */
+    size_t boundaries[SCOPE_COUNT];
+  };
+
+  /** The position of the topmost open element with the given name. */
+  size_t topmost(LibDOM::Atom name) const;
+
+  std::vector<LibDOM::RefPtr<LibDOM::Element>> m_elements;
+  std::vector<Links> m_links;
+  /** Indexed by the known atoms, see KNOWN_ATOM_COUNT. */
+  std::vector<size_t> m_topmost;
+  /**
+    The same for the atoms that are added at runtime, which only has the
+    names that are open, so that the stack doesn't grow with the atom table.
+  */
+  std::unordered_map<LibDOM::Atom, size_t> m_dynamicTopmost;
+};
+
+} // namespace LibHTML
+
+#endif
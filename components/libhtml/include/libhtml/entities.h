@@ -0,0 +1,34 @@
+#ifndef LIBHTML_ENTITIES_H
+#define LIBHTML_ENTITIES_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace LibHTML {
+
+/*
+  Named character references are matched one character at a time by walking a
+  trie of their names, which starts at ENTITY_ROOT. The trie is constant data
+  generated by genEntityTable.py, so matching needs neither initialization nor
+  allocation.
+
+  https://html.spec.whatwg.org/multipage/named-characters.html
+*/
+
+const size_t ENTITY_ROOT = 0;
+
+/**
+  Returns the node reached from `node` through `c`, or ENTITY_ROOT if no
+  reference name continues that way.
+*/
+size_t entityStep(size_t node, wchar_t c);
+
+/**
+  Returns the characters of the reference whose name ends at `node`, or an
+  empty string if no name ends there.
+*/
+std::wstring_view entityValue(size_t node);
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef LIBHTML_FETCHQUEUE_H
+#define LIBHTML_FETCHQUEUE_H
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace LibHTML {
+
+enum FetchType {
+  FETCH_STYLESHEET,
+  FETCH_SCRIPT,
+  FETCH_IMAGE,
+  FETCH_FONT,
+  FETCH_OTHER,
+};
+
+/** How soon a subresource is needed, most urgent first. */
+enum FetchPriority {
+  /**
+    Blocks rendering or parsing: stylesheets, scripts that are neither async
+    nor deferred, and preloaded fonts.
+  */
+  PRIORITY_HIGH,
+  /** Needed soon: async and deferred scripts, and most other preloads. */
+  PRIORITY_MEDIUM,
+  /** Images, which can be shown when they arrive. */
+  PRIORITY_LOW,
+  PRIORITY_COUNT,
+};
+
+struct FetchRequest {
+  /** The URL as written in the document, which may be relative. */
+  std::wstring url;
+  FetchType type = FETCH_OTHER;
+  FetchPriority priority = PRIORITY_LOW;
+};
+
+/**
+  The subresources a document is found to need, for a loader to fetch in order
+  of priority, and in the order they were found within a priority. Each URL is
+  only queued once, even after it was taken out again.
+
+  A scanner on one thread can fill the queue while a loader on another one
+  empties it.
+*/
+class FetchQueue {
+public:
+  /** Queues a request, unless its URL was queued before. */
+  bool push(FetchRequest request);
+  /** Takes out the most urgent request, or returns false if there is none. */
+  bool pop(FetchRequest &request);
+
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+  /** Drops all requests, and forgets which URLs were queued. */
+  void clear();
+
+private:
+  mutable std::mutex m_mutex;
+  std::deque<FetchRequest> m_requests[PRIORITY_COUNT];
+  std::unordered_set<std::wstring> m_seen;
+};
+
+} // namespace LibHTML
+
+#endif
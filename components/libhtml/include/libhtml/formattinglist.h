@@ -0,0 +1,82 @@
+#ifndef LIBHTML_FORMATTINGLIST_H
+#define LIBHTML_FORMATTINGLIST_H
+
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include "libhtml/elementstack.h"
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+namespace LibHTML {
+
+/**
+  https://html.spec.whatwg.org/multipage/parsing.html#list-of-active-formatting-elements
+
+  Every entry remembers where its element was last seen on the stack of open
+  elements, so asking whether an entry is still open is a single comparison
+  unless the stack was rearranged below it since. Entries are addressed by
+  index, which stays valid until an entry before it is inserted or erased.
+*/
+class FormattingList {
+public:
+  static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+  struct Entry {
+    /** The element, or nullptr for a marker. */
+    LibDOM::RefPtr<LibDOM::Element> element;
+    /** See ElementStack::find(). */
+    mutable size_t stackPosition;
+
+    bool isMarker() const { return element == nullptr; }
+  };
+
+  /**
+    https://html.spec.whatwg.org/multipage/parsing.html#push-onto-the-list-of-active-formatting-elements
+
+    `stackPosition` is where the element is on the stack of open elements.
+    With a `limit`, the list holds at most that many elements after its last
+    marker, and the earliest of them is removed to make room for another one.
+    Returns whether that happened.
+  */
+  bool push(LibDOM::RefPtr<LibDOM::Element> element, size_t stackPosition,
+            size_t limit = 0);
+  void insertMarker();
+  /** https://html.spec.whatwg.org/multipage/parsing.html#clear-the-list-of-active-formatting-elements-up-to-the-last-marker */
+  void clearUpToLastMarker();
+
+  void insert(size_t index, LibDOM::RefPtr<LibDOM::Element> element,
+              size_t stackPosition = 0);
+  void replace(size_t index, LibDOM::RefPtr<LibDOM::Element> element,
+               size_t stackPosition = 0);
+  void erase(size_t index);
+  void clear();
+
+  const Entry &operator[](size_t index) const { return m_entries[index]; }
+  size_t size() const { return m_entries.size(); }
+  bool empty() const { return m_entries.empty(); }
+
+  bool contains(const LibDOM::RefPtr<LibDOM::Element> &element) const;
+  /** The index of an element in the list, or NOT_FOUND. */
+  size_t find(const LibDOM::RefPtr<LibDOM::Element> &element) const;
+  /**
+    The index of the last element with the given name after the last marker,
+    or NOT_FOUND.
+  */
+  size_t findAfterLastMarker(LibDOM::Atom name) const;
+  /**
+    Where the element of an entry is on the stack of open elements, as its
+    index + 1, or 0 if it isn't open.
+  */
+  size_t stackPosition(size_t index, const ElementStack &stack) const;
+
+private:
+  std::vector<Entry> m_entries;
+  /** The elements in the list, so that contains() doesn't have to search. */
+  std::unordered_set<const LibDOM::Element *> m_members;
+};
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef LIBHTML_INPUTSTREAM_H
+#define LIBHTML_INPUTSTREAM_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace LibHTML {
+
+/**
+  The tokenizer's input: UTF-8 chunks, read in place as they arrive.
+
+  Sometimes the end of a chunk comes before the tokenizer can decide what to
+  do: a character is cut in two, or it is looking ahead for a keyword like
+  "DOCTYPE". The few bytes that are left are then copied into a small
+  carry-over buffer, which the next chunk tops up before the stream moves on
+  to the rest of that chunk. Nothing else is ever copied.
+*/
+class InputStream {
+public:
+  /** The longest lookahead the tokenizer can ask for. */
+  static const size_t MAX_LOOKAHEAD = 7;
+
+  void reset();
+  /**
+    Hands over the next chunk, dropping whatever was left of the previous one.
+    It has to stay valid until hasInput() returns false.
+  */
+  void feed(const char *input, size_t size);
+  /** Marks the end of the input, which consume() then returns as EOF. */
+  void finish();
+  bool isFinished() const { return m_finished; }
+
+  /** Whether there is anything to consume before the next feed(). */
+  bool hasInput() {
+    // only the last few bytes of a chunk need any special handling
+    return m_position + MAX_CARRY <= m_size || prepare();
+  }
+
+  /** Consumes the next character, or EOF once the input is finished. */
+  wchar_t consume() {
+    m_characterStart = m_position;
+    if (m_position < m_size &&
+        static_cast<unsigned char>(m_data[m_position]) < 0x80)
+      return m_data[m_position++];
+    return consumeSlow();
+  }
+  /** Goes back to before the character consume() last returned. */
+  void reconsume() { m_position = m_characterStart; }
+
+  /**
+    Whether the tokenizer has to wait before looking `length` bytes ahead:
+    fewer are left and more input may still come. The rest of the input is
+    then carried over, and hasInput() returns false until there's more.
+  */
+  bool needsMore(size_t length);
+  /** Whether the input ahead starts with `s`. Doesn't consume anything. */
+  bool startsWith(std::string_view s, bool ignoreCase = false);
+  /** Consumes `length` bytes that startsWith() has already looked at. */
+  void skip(size_t length);
+
+  /**
+    Consumes the plain text that follows the character consume() last
+    returned, up to the next '<', '&' (if requested), U+0000 or '\r'. Returns
+    the UTF-8 of the whole run including that character. It stops short of a
+    character cut off by the end of the chunk.
+  */
+  std::string_view consumeTextRun(bool stopAtAmpersand);
+
+  /** Whether the next byte is a '\n' in the input at hand. */
+  bool lineFeedFollows() const {
+    return m_position < m_size && m_data[m_position] == '\n';
+  }
+  /**
+    Used after a '\r': drops a '\n' at the start of the next chunk, if the
+    current one ends right here.
+  */
+  void skipLineFeed();
+
+  size_t position() const { return m_position; }
+
+private:
+  /** Room for the lookahead plus the rest of a multibyte character. */
+  static const size_t MAX_CARRY = MAX_LOOKAHEAD + 4;
+
+  wchar_t consumeSlow();
+  bool prepare();
+  void start(const char *data, size_t size);
+  /**
+    Saves what is left of the input in m_carry and tops it up with `wanted`
+    bytes from the next chunk once that is there.
+  */
+  void carryOver(size_t wanted);
+  /**
+    Moves bytes from m_chunk to m_carry until m_carryWanted are there, and
+    waits for the next chunk if m_chunk runs out first.
+  */
+  void fillCarry();
+
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+  size_t m_position = 0;
+  size_t m_characterStart = 0;
+  bool m_finished = false;
+  bool m_waiting = false;
+  bool m_skipLineFeed = false;
+
+  // While m_data is m_carry, m_chunk is the rest of the chunk after it.
+  char m_carry[MAX_CARRY];
+  size_t m_carrySize = 0;
+  size_t m_carryWanted = 0;
+  const char *m_chunk = nullptr;
+  size_t m_chunkSize = 0;
+};
+
+} // namespace LibHTML
+
+#endif
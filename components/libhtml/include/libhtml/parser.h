@@ -2,19 +2,25 @@
 #define LIBHTML_PARSER_H
 
 #include "libdom.h"
+#include "libdom/atom.h"
 #include "libdom/element.h"
 #include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/elementstack.h"
+#include "libhtml/formattinglist.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/status.h"
 #include "libhtml/tokenizer.h"
 #include "libhtml/tokens.h"
+#include <chrono>
 #include <cstddef>
-#include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace LibHTML {
 
-#define NS_HTML L"http://www.w3.org/1999/xhtml"
-
 enum ParserMode {
   UNDEFINED_MODE,
   INITIAL,
@@ -42,101 +48,268 @@ enum ParserMode {
   AFTER_AFTER_FRAMESET,
 };
 
+/** What the parser does when the input needs something it doesn't implement. */
+enum RecoveryMode {
+  /** Stop parsing there, keeping the document built so far. */
+  ABORT_ON_UNSUPPORTED,
+  /** Skip the token it can't handle and carry on with the rest. */
+  BEST_EFFORT,
+};
+
+/**
+  How much work the parser may do before it returns PARSE_PAUSED, so that a
+  host can get back to its event loop in between. Tokens that were started
+  are always finished, and the tree is complete up to the last of them.
+*/
+struct ParseBudget {
+  /** The most tokens to handle, or 0 for no limit. */
+  size_t tokens = 0;
+  /** When to pause at the latest. The clock is only read every few tokens. */
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+};
+
 class Parser {
 public:
   Parser();
 
   void reset();
-  void parse(const char *text, size_t textLen);
-  void parse(const wchar_t *text, size_t textLen);
+  /**
+    Parses the next chunk of UTF-8 input in place. Once parsing has stopped or
+    been aborted, any further input is ignored.
+  */
+  ParseStatus parse(const char *text, size_t textLen);
+  /**
+    Parses wide input by converting it to UTF-8 first. An EOF character in the
+    input works like calling finish().
+  */
+  ParseStatus parse(const wchar_t *text, size_t textLen);
+  /**
+    Tells the parser that there is no more input. Once the document is
+    complete, this returns PARSE_STOPPED.
+  */
+  ParseStatus finish();
+  /**
+    Like parse() and finish(), but returns PARSE_PAUSED once `budget` is used
+    up. The chunk then has to stay valid until resume() has finished it, and
+    passing in another chunk finishes this one first, without a budget.
+  */
+  ParseStatus parse(const char *text, size_t textLen,
+                    const ParseBudget &budget);
+  ParseStatus finish(const ParseBudget &budget);
+  /**
+    Carries on where parsing paused, with a new budget. Without anything left
+    over, this just returns how parsing stands.
+  */
+  ParseStatus resume(const ParseBudget &budget);
+  /**
+    Parses a whole document of UTF-8 input, the way parse() and finish() do,
+    with the tokenizer running ahead on a worker thread. Worth it for large
+    documents on machines with a core to spare.
+  */
+  ParseStatus parsePipelined(const char *text, size_t textLen);
+  /**
+    https://html.spec.whatwg.org/multipage/parsing.html#parsing-html-fragments
+
+    Parses UTF-8 markup the way it would be parsed as the contents of
+    `context`, for innerHTML and the like, and appends the nodes it makes up to
+    `nodes`. The parser is reset first, and left alone otherwise: document
+    isn't touched, and a document of the parser's own, which is reused from one
+    fragment to the next, becomes the nodes' ownerDocument.
+  */
+  ParseStatus parseFragment(LibDOM::Element &context, const char *text,
+                            size_t textLen,
+                            std::vector<LibDOM::RefPtr<LibDOM::Node>> &nodes);
+
+  /**
+    The first thing in the input that the parser doesn't implement, or nullptr.
+    In BEST_EFFORT mode, parsing carried on past it.
+  */
+  const char *error() const { return m_error; }
 
-  std::shared_ptr<LibDOM::Document> document;
+  /**
+    Limits what the parser builds out of the documents it parses from now on.
+    There are none unless they are set.
+  */
+  void setLimits(const ParserLimits &limits);
+  const ParserLimits &limits() const { return m_limits; }
+  /** How often the limits cut the document short since the last reset(). */
+  LimitCounters limitCounters() const;
+
+  LibDOM::RefPtr<LibDOM::Document> document;
+  RecoveryMode recoveryMode = ABORT_ON_UNSUPPORTED;
+  /**
+    Where the parser writes warnings about the input, or nullptr to keep quiet.
+    Parsers on different threads need different streams.
+  */
+  std::wostream *warnings = nullptr;
 
 private:
-  void process(std::unique_ptr<Token> token);
+  /**
+    Feeds the tokens of the current chunk to the tree builder, until the chunk
+    or the budget runs out.
+  */
+  ParseStatus runTokenizer(const ParseBudget &budget = ParseBudget());
+  ParseStatus process(Token &token);
+  ParseStatus status() const;
+  /**
+    Ends the input once the tree builder has made as many nodes as maxNodes
+    allows, by handing it an end-of-file token.
+  */
+  void checkNodeLimit();
+  /**
+    Records that the input needs something that isn't implemented yet, and
+    aborts parsing unless in BEST_EFFORT mode. The caller then ignores the
+    token it was handling.
+  */
+  void unsupported(const char *what);
 
-  void initialInsertion(std::unique_ptr<Token> token);
-  void beforeHtml(std::unique_ptr<Token> token);
-  void beforeHead(std::unique_ptr<Token> token);
-  void inHead(std::unique_ptr<Token> token);
-  void afterHead(std::unique_ptr<Token> token);
-  void inBody(std::unique_ptr<Token> token);
-  void text(std::unique_ptr<Token> token);
+  void initialInsertion(Token &token);
+  void beforeHtml(Token &token);
+  void beforeHead(Token &token);
+  void inHead(Token &token);
+  void afterHead(Token &token);
+  void inBody(Token &token);
+  void text(Token &token);
+  void afterBody(Token &token);
+  void afterAfterBody(Token &token);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#reset-the-insertion-mode-appropriately */
   void resetInsertionModeAppropriately();
 
+  /** Whether the stack of open elements is as deep as maxDepth allows. */
+  bool atDepthLimit() const;
+  /**
+    https://html.spec.whatwg.org/multipage/parsing.html#appropriate-place-for-inserting-a-node
+
+    Without foster parenting, this is the current node, except at the depth
+    limit: then it is the element the current node would be in, so that new
+    nodes go next to it instead of deeper.
+  */
+  const LibDOM::RefPtr<LibDOM::Element> &insertionParent() const;
+
+  /** https://html.spec.whatwg.org/multipage/parsing.html#push-onto-the-list-of-active-formatting-elements */
+  void
+  pushActiveFormattingElement(const LibDOM::RefPtr<LibDOM::Element> &element);
+
   /** https://html.spec.whatwg.org/multipage/parsing.html#reconstruct-the-active-formatting-elements */
   void reconstructActiveFormattingElements();
 
-  /** https://html.spec.whatwg.org/multipage/parsing.html#insert-a-character */
-  void insertCharacter(std::unique_ptr<CharacterToken> token);
+  /**
+    https://html.spec.whatwg.org/multipage/parsing.html#insert-a-character
+
+    The characters are collected in m_pendingText, and only become part of the
+    tree when flushPendingText() is called.
+  */
+  void insertCharacter(std::wstring_view data);
+  /**
+    Appends the pending characters to the Text node at the end of their
+    parent, or to a new one. Anything that inserts nodes has to call this
+    first, so that the characters stay in front of them.
+  */
+  void flushPendingText();
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#insert-a-comment */
-  void insertComment(std::unique_ptr<Token> token,
-                     std::shared_ptr<LibDOM::Node> position);
+  void insertComment(Token &token, LibDOM::RefPtr<LibDOM::Node> position);
 
   /** https://dom.spec.whatwg.org/#concept-create-element */
-  std::shared_ptr<LibDOM::HTMLElement> createElement(std::wstring localName,
-                                                     std::wstring ns,
-                                                     std::wstring prefix = L"");
+  LibDOM::RefPtr<LibDOM::HTMLElement>
+  createElement(LibDOM::Atom localName, LibDOM::Atom ns,
+                LibDOM::Atom prefix = LibDOM::NULL_ATOM);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#create-an-element-for-the-token */
-  std::shared_ptr<LibDOM::Element>
-  createElementForToken(TagToken *token, std::wstring ns,
-                        std::shared_ptr<LibDOM::Node> intendedParent);
+  LibDOM::RefPtr<LibDOM::Element>
+  createElementForToken(const Token &token, LibDOM::Atom ns,
+                        LibDOM::RefPtr<LibDOM::Node> intendedParent);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#insert-a-foreign-element */
-  std::shared_ptr<LibDOM::Element>
-  insertForeignElement(TagToken *token, std::wstring ns,
+  LibDOM::RefPtr<LibDOM::Element>
+  insertForeignElement(const Token &token, LibDOM::Atom ns,
                        bool onlyAddToElementStack);
 
+  /**
+    Switches the tokenizer to another state for the tokens after the current
+    one. When parsing pipelined, the switch is recorded instead, to be checked
+    against the one the tokenizer made on its own.
+  */
+  void switchTokenizer(TokenizerState state);
+
   /** https://html.spec.whatwg.org/multipage/parsing.html#generic-raw-text-element-parsing-algorithm */
-  void genericRawTextParse(std::unique_ptr<TagToken> token);
+  void genericRawTextParse(Token &token);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#generic-rcdata-element-parsing-algorithm */
-  void genericRcdataParse(std::unique_ptr<TagToken> token);
+  void genericRcdataParse(Token &token);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#stop-parsing */
   void stopParsing();
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#generate-implied-end-tags */
   void generateImpliedEndTags();
-  void generateImpliedEndTagsExceptFor(std::wstring tagName);
+  void generateImpliedEndTagsExceptFor(LibDOM::Atom tagName);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#close-a-p-element */
   void closePElem();
 
-  /** https://html.spec.whatwg.org/multipage/parsing.html#push-onto-the-list-of-active-formatting-elements */
-  void pushOntoActiveFormattingElems(std::shared_ptr<LibDOM::Element> node);
-
-  /** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-scope */
-  bool isInScope(std::shared_ptr<LibDOM::Element> targetNode);
-  bool isInButtonScope(std::shared_ptr<LibDOM::Element> targetNode);
-  bool stackHasInScope(std::wstring tagName);
-  bool stackHasInButtonScope(std::wstring tagName);
+  /**
+    Creates an element for the token that an element in the list of active
+    formatting elements was created for. The attributes of the token are all
+    on the element, and nothing else could have changed them.
+  */
+  LibDOM::RefPtr<LibDOM::Element> recreateFormattingElement(
+      const LibDOM::RefPtr<LibDOM::Element> &element);
 
   /** https://html.spec.whatwg.org/multipage/parsing.html#adoption-agency-algorithm
 
     why is it named the "adoption agency" algo???
+
+    Returns false if the token has to be handled like any other end tag
+    instead.
   */
-  void adoptionAgency(TagToken *token);
+  bool adoptionAgency(Token &token);
 
-  void popStackUntil(std::wstring tagName);
+  void popStackUntil(LibDOM::Atom tagName);
 
   Tokenizer m_tokenizer;
+  /** Reused by parse(const wchar_t *) to hold the UTF-8 input. */
+  std::string m_utf8Buffer;
   ParserMode m_insertionMode = INITIAL;
   ParserMode m_originalInsertionMode = UNDEFINED_MODE;
   /** Stack of open elements */
-  std::vector<std::shared_ptr<LibDOM::Element>> m_nodeStack;
-  std::vector<std::shared_ptr<LibDOM::Element>> m_activeFormattingElems;
+  ElementStack m_nodeStack;
+  FormattingList m_activeFormattingElems;
 
-  std::shared_ptr<LibDOM::Element> m_headElementPointer = nullptr;
-  std::shared_ptr<LibDOM::Element> m_formElementPointer = nullptr;
+  /**
+    Characters that were inserted into m_pendingTextParent but not added to
+    its children yet. A run of text usually arrives as several character
+    tokens, which all go to the same place, so the run is collected here and
+    added to the tree at once.
+  */
+  std::wstring m_pendingText;
+  LibDOM::RefPtr<LibDOM::Node> m_pendingTextParent = nullptr;
+
+  LibDOM::RefPtr<LibDOM::Element> m_headElementPointer = nullptr;
+  LibDOM::RefPtr<LibDOM::Element> m_formElementPointer = nullptr;
+
+  /** https://html.spec.whatwg.org/multipage/parsing.html#concept-frag-parse-context */
+  LibDOM::Element *m_fragmentContext = nullptr;
+  LibDOM::RefPtr<LibDOM::Document> m_fragmentDocument;
 
   bool m_scriptingFlag = false;
   bool m_framesetOk = true;
+  /** The state switchTokenizer() was last called with, see parsePipelined(). */
+  TokenizerState m_switchedTo = UNDEFINED_STATE;
+
   bool m_isParsing = true;
+  bool m_aborted = false;
+  const char *m_error = nullptr;
+  /** Whether the current chunk has tokens left after a budget ran out. */
+  bool m_paused = false;
+
+  ParserLimits m_limits;
+  /** The counters of the tree builder; the tokenizer keeps its own. */
+  LimitCounters m_counters;
+  size_t m_nodeCount = 0;
+  size_t m_bytesParsed = 0;
 };
 
 } // namespace LibHTML
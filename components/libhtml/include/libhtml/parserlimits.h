@@ -0,0 +1,57 @@
+#ifndef LIBHTML_PARSERLIMITS_H
+#define LIBHTML_PARSERLIMITS_H
+
+#include <cstddef>
+
+namespace LibHTML {
+
+/**
+  How much a parser builds out of a document at most, so that a hostile one
+  can't use up the memory or the time of whatever parses it. Each limit is
+  dealt with the way a parse error would be, and a limit of 0 means there is
+  none, which is the default for all of them.
+*/
+struct ParserLimits {
+  /**
+    How deep the tree can get. Once the stack of open elements is this deep,
+    new elements go next to the current node instead of into it, as they do
+    in browsers, and the tree stays flat however deep the markup nests. The
+    list of active formatting elements is held to the same length after its
+    last marker, by forgetting the earliest entries, like the Noah's Ark
+    clause does. Blink's limit is 512.
+  */
+  size_t maxDepth = 0;
+  /** How many attributes a tag keeps. Any more are dropped. */
+  size_t maxAttributes = 0;
+  /**
+    How long a string in a token gets: a tag or attribute name, an attribute
+    value, a comment or a DOCTYPE. What's over is cut off.
+  */
+  size_t maxTokenSize = 0;
+  /**
+    How many nodes the tree builder makes. Once it has made this many, the
+    input ends there, and the tree is finished up as at the end of a file.
+  */
+  size_t maxNodes = 0;
+  /** How many bytes of input are parsed. The input ends after the last one. */
+  size_t maxBytes = 0;
+};
+
+/** How often the limits of a parser cut a document short, and where. */
+struct LimitCounters {
+  /** Elements that went next to the current node, for maxDepth. */
+  size_t clampedElements = 0;
+  /** Entries taken out of the list of active formatting elements. */
+  size_t droppedFormattingElements = 0;
+  size_t droppedAttributes = 0;
+  /** Characters cut off the strings of tokens. */
+  size_t droppedCharacters = 0;
+  /** Whether the input was ended early for maxNodes. */
+  bool nodeLimitReached = false;
+  /** Whether the input was ended early for maxBytes. */
+  bool byteLimitReached = false;
+};
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef LIBHTML_PARSERPOOL_H
+#define LIBHTML_PARSERPOOL_H
+
+#include "libdom.h"
+#include "libhtml/parser.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/status.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace LibHTML {
+
+/**
+  Parses many documents at once, each with its own Parser, on a fixed set of
+  worker threads.
+
+  Every call to parse() deals the documents out to the workers in contiguous
+  runs. A worker takes documents from the front of its own run, and once that
+  is empty, steals from the back of the others, so a few large documents don't
+  hold up the whole batch.
+*/
+class ParserPool {
+public:
+  struct Result {
+    /** Nothing on the worker holds on to it once parse() returns. */
+    LibDOM::RefPtr<LibDOM::Document> document;
+    /** What finish() returned, or PARSE_ABORTED. */
+    ParseStatus status = PARSE_OK;
+    /** See Parser::error(). */
+    const char *error = nullptr;
+    /** See Parser::limitCounters(). */
+    LimitCounters limitCounters;
+  };
+
+  /** With no thread count, uses one thread per core. */
+  explicit ParserPool(size_t threadCount = 0);
+  ~ParserPool();
+  ParserPool(const ParserPool &) = delete;
+  ParserPool &operator=(const ParserPool &) = delete;
+
+  /**
+    Parses each of the UTF-8 `documents`, and returns their results in the same
+    order once all of them are done. The documents only have to stay valid
+    until then. Calls from several threads take turns.
+  */
+  std::vector<Result> parse(const std::vector<std::string_view> &documents);
+
+  size_t threadCount() const { return m_threads.size(); }
+
+  RecoveryMode recoveryMode = ABORT_ON_UNSUPPORTED;
+  /** See Parser::setLimits(). They apply to each document on its own. */
+  ParserLimits limits;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+  };
+
+  void work(size_t worker);
+  /** Takes the next document for `worker`, stealing it if need be. */
+  bool take(size_t worker, size_t &job);
+  void finishJob();
+
+  std::vector<std::thread> m_threads;
+  std::vector<std::unique_ptr<Queue>> m_queues;
+
+  /** Lets one parse() run at a time. */
+  std::mutex m_parseMutex;
+
+  // the batch being parsed, guarded by m_mutex
+  std::mutex m_mutex;
+  std::condition_variable m_started;
+  std::condition_variable m_finished;
+  size_t m_batch = 0;
+  size_t m_remaining = 0;
+  bool m_stopping = false;
+  const std::vector<std::string_view> *m_documents = nullptr;
+  std::vector<Result> *m_results = nullptr;
+};
+
+} // namespace LibHTML
+
+#endif
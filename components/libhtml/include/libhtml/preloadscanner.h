@@ -0,0 +1,63 @@
+#ifndef LIBHTML_PRELOADSCANNER_H
+#define LIBHTML_PRELOADSCANNER_H
+
+#include "libhtml/fetchqueue.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokens.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace LibHTML {
+
+/**
+  Looks through a document ahead of the parser for the subresources it will
+  need, so that a loader can start fetching them before the tree builder gets
+  there: stylesheets, scripts, images and preloads.
+
+  It runs a tokenizer of its own, with no tree builder behind it. It makes the
+  state switches that the tree builder would make for text-only elements like
+  script and style, so that their contents aren't mistaken for markup, but it
+  doesn't know about anything else the tree builder does. What it finds is a
+  guess at what the document needs.
+*/
+class PreloadScanner {
+public:
+  /** `scripting` is whether scripts run, which decides what noscript holds. */
+  explicit PreloadScanner(FetchQueue &queue, bool scripting = false);
+
+  /**
+    Scans the next chunk of UTF-8 input. It only has to stay valid for the
+    call, apart from a partial token at its end, as with Tokenizer::feed().
+  */
+  void scan(const char *input, size_t size);
+  /** Scans what is left once there is no more input. */
+  void finish();
+
+  /** The href of the first base element, to resolve relative URLs against. */
+  const std::wstring &baseURL() const { return m_baseURL; }
+
+private:
+  void run();
+  void startTag(const Token &token);
+  void request(std::wstring_view url, FetchType type, FetchPriority priority);
+
+  FetchQueue &m_queue;
+  bool m_scripting;
+  Tokenizer m_tokenizer;
+  std::wstring m_baseURL;
+  bool m_sawBase = false;
+};
+
+/**
+  https://html.spec.whatwg.org/multipage/images.html#parsing-a-srcset-attribute
+
+  Picks the URL a display at 1x would use out of a srcset attribute: the first
+  candidate without descriptors or with a 1x one, or else the first candidate.
+  Returns an empty view if there are no candidates.
+*/
+std::wstring_view pickSrcsetCandidate(std::wstring_view srcset);
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef LIBHTML_SCANNER_H
+#define LIBHTML_SCANNER_H
+
+#include <cstddef>
+
+namespace LibHTML {
+
+enum ScannerImpl : int {
+  SCANNER_SCALAR,
+  SCANNER_SSE2,
+  SCANNER_AVX2,
+};
+
+/**
+  Returns the offset of the first byte in the UTF-8 `data` that ends a run of
+  plain text in the data, RCDATA, RAWTEXT and script data states: '<', '&'
+  (only if `stopAtAmpersand` is set), U+0000 or '\r'. Returns `length` if there
+  is none.
+
+  The implementation is picked at runtime based on what the CPU supports.
+*/
+size_t findTextSentinel(const char *data, size_t length,
+                        bool stopAtAmpersand);
+
+/** The implementation findTextSentinel() currently uses. */
+ScannerImpl scannerImpl();
+
+/**
+  Forces findTextSentinel() to use the given implementation. Returns false and
+  changes nothing if the CPU doesn't support it. Meant for tests and benchmarks.
+*/
+bool setScannerImpl(ScannerImpl impl);
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef LIBHTML_SPSCRING_H
+#define LIBHTML_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace LibHTML {
+
+/**
+  A fixed ring of slots that one thread fills and another one empties, without
+  taking locks. Slots are filled and emptied in place, so whatever they own is
+  reused rather than reallocated as they go round.
+
+  Either side asks for its next slot and gets nullptr if it has to wait; the
+  waiting is up to the caller.
+*/
+template <typename T, size_t N> class SPSCRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0,
+                "the capacity has to be a power of two");
+
+public:
+  /** Producer: the slot to fill next, or nullptr if the ring is full. */
+  T *back() {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == N)
+      return nullptr;
+    return &m_slots[tail & (N - 1)];
+  }
+  /** Producer: hands the slot from back() over to the consumer. */
+  void push() {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+  }
+
+  /** Consumer: the oldest filled slot, or nullptr if the ring is empty. */
+  T *front() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+      return nullptr;
+    return &m_slots[head & (N - 1)];
+  }
+  /** Consumer: gives the slot from front() back to the producer. */
+  void pop() {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+  }
+
+  /** Empties the ring. Neither side may be using it meanwhile. */
+  void clear() {
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  T m_slots[N];
+  // the two sides write to different cache lines
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef LIBHTML_STATUS_H
+#define LIBHTML_STATUS_H
+
+namespace LibHTML {
+
+/** How far the tokenizer or the parser got with the input it was given. */
+enum ParseStatus {
+  /** All of the input was used up, and more can follow. */
+  PARSE_OK,
+  /** Parsing was stopped on purpose, such as at the end of the document. */
+  PARSE_STOPPED,
+  /**
+    Parsing was given up at something that isn't implemented yet. Whatever was
+    built up to that point is kept, and error() says what the problem was.
+  */
+  PARSE_ABORTED,
+  /**
+    The budget the parser was given ran out before the input did. The parser
+    keeps the rest of the input, and resume() carries on with it.
+  */
+  PARSE_PAUSED,
+};
+
+} // namespace LibHTML
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef LIBHTML_TAGSETS_H
+#define LIBHTML_TAGSETS_H
+
+#include "libdom/atom.h"
+#include <cstddef>
+#include <initializer_list>
+
+namespace LibHTML {
+
+/**
+  A set of element names, built at compile time. Only known atoms can be
+  members, and as those are small consecutive numbers, the set is a bit map
+  indexed by atom, so a lookup is a single bit test.
+*/
+class TagSet {
+public:
+  constexpr TagSet(std::initializer_list<LibDOM::Atom> atoms) : m_bits() {
+    for (auto atom : atoms)
+      m_bits[atom / 64] |= 1ull << (atom % 64);
+  }
+
+  constexpr bool contains(LibDOM::Atom atom) const {
+    return atom < LibDOM::Atoms::KNOWN_ATOM_COUNT &&
+           (m_bits[atom / 64] >> (atom % 64)) & 1;
+  }
+
+  constexpr TagSet operator|(const TagSet &other) const {
+    TagSet set = *this;
+    for (size_t i = 0; i < WORDS; i++)
+      set.m_bits[i] |= other.m_bits[i];
+    return set;
+  }
+
+private:
+  static const size_t WORDS = (LibDOM::Atoms::KNOWN_ATOM_COUNT + 63) / 64;
+  unsigned long long m_bits[WORDS];
+};
+
+// The element categories of the tree builder. They only hold HTML elements for
+// now; the MathML and SVG members can be added once elements in those
+// namespaces are.
+// FIXME: check the namespace along with the name once there is foreign content
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#special */
+constexpr TagSet SPECIAL_ELEMENTS = {
+    LibDOM::Atoms::ATOM_address,    LibDOM::Atoms::ATOM_applet,
+    LibDOM::Atoms::ATOM_area,       LibDOM::Atoms::ATOM_article,
+    LibDOM::Atoms::ATOM_aside,      LibDOM::Atoms::ATOM_base,
+    LibDOM::Atoms::ATOM_basefont,   LibDOM::Atoms::ATOM_bgsound,
+    LibDOM::Atoms::ATOM_blockquote, LibDOM::Atoms::ATOM_body,
+    LibDOM::Atoms::ATOM_br,         LibDOM::Atoms::ATOM_button,
+    LibDOM::Atoms::ATOM_caption,    LibDOM::Atoms::ATOM_center,
+    LibDOM::Atoms::ATOM_col,        LibDOM::Atoms::ATOM_colgroup,
+    LibDOM::Atoms::ATOM_dd,         LibDOM::Atoms::ATOM_details,
+    LibDOM::Atoms::ATOM_dir,        LibDOM::Atoms::ATOM_div,
+    LibDOM::Atoms::ATOM_dl,         LibDOM::Atoms::ATOM_dt,
+    LibDOM::Atoms::ATOM_embed,      LibDOM::Atoms::ATOM_fieldset,
+    LibDOM::Atoms::ATOM_figcaption, LibDOM::Atoms::ATOM_figure,
+    LibDOM::Atoms::ATOM_footer,     LibDOM::Atoms::ATOM_form,
+    LibDOM::Atoms::ATOM_frame,      LibDOM::Atoms::ATOM_frameset,
+    LibDOM::Atoms::ATOM_h1,         LibDOM::Atoms::ATOM_h2,
+    LibDOM::Atoms::ATOM_h3,         LibDOM::Atoms::ATOM_h4,
+    LibDOM::Atoms::ATOM_h5,         LibDOM::Atoms::ATOM_h6,
+    LibDOM::Atoms::ATOM_head,       LibDOM::Atoms::ATOM_header,
+    LibDOM::Atoms::ATOM_hgroup,     LibDOM::Atoms::ATOM_hr,
+    LibDOM::Atoms::ATOM_html,       LibDOM::Atoms::ATOM_iframe,
+    LibDOM::Atoms::ATOM_img,        LibDOM::Atoms::ATOM_input,
+    LibDOM::Atoms::ATOM_keygen,     LibDOM::Atoms::ATOM_li,
+    LibDOM::Atoms::ATOM_link,       LibDOM::Atoms::ATOM_listing,
+    LibDOM::Atoms::ATOM_main,       LibDOM::Atoms::ATOM_marquee,
+    LibDOM::Atoms::ATOM_menu,       LibDOM::Atoms::ATOM_meta,
+    LibDOM::Atoms::ATOM_nav,        LibDOM::Atoms::ATOM_noembed,
+    LibDOM::Atoms::ATOM_noframes,   LibDOM::Atoms::ATOM_noscript,
+    LibDOM::Atoms::ATOM_object,     LibDOM::Atoms::ATOM_ol,
+    LibDOM::Atoms::ATOM_p,          LibDOM::Atoms::ATOM_param,
+    LibDOM::Atoms::ATOM_plaintext,  LibDOM::Atoms::ATOM_pre,
+    LibDOM::Atoms::ATOM_script,     LibDOM::Atoms::ATOM_search,
+    LibDOM::Atoms::ATOM_section,    LibDOM::Atoms::ATOM_select,
+    LibDOM::Atoms::ATOM_source,     LibDOM::Atoms::ATOM_style,
+    LibDOM::Atoms::ATOM_summary,    LibDOM::Atoms::ATOM_table,
+    LibDOM::Atoms::ATOM_tbody,      LibDOM::Atoms::ATOM_td,
+    LibDOM::Atoms::ATOM_template,   LibDOM::Atoms::ATOM_textarea,
+    LibDOM::Atoms::ATOM_tfoot,      LibDOM::Atoms::ATOM_th,
+    LibDOM::Atoms::ATOM_thead,      LibDOM::Atoms::ATOM_title,
+    LibDOM::Atoms::ATOM_tr,         LibDOM::Atoms::ATOM_track,
+    LibDOM::Atoms::ATOM_ul,         LibDOM::Atoms::ATOM_wbr,
+    LibDOM::Atoms::ATOM_xmp,
+};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#formatting */
+constexpr TagSet FORMATTING_ELEMENTS = {
+    LibDOM::Atoms::ATOM_a,      LibDOM::Atoms::ATOM_b,
+    LibDOM::Atoms::ATOM_big,    LibDOM::Atoms::ATOM_code,
+    LibDOM::Atoms::ATOM_em,     LibDOM::Atoms::ATOM_font,
+    LibDOM::Atoms::ATOM_i,      LibDOM::Atoms::ATOM_nobr,
+    LibDOM::Atoms::ATOM_s,      LibDOM::Atoms::ATOM_small,
+    LibDOM::Atoms::ATOM_strike, LibDOM::Atoms::ATOM_strong,
+    LibDOM::Atoms::ATOM_tt,     LibDOM::Atoms::ATOM_u,
+};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#generate-implied-end-tags */
+constexpr TagSet IMPLIED_END_TAG_ELEMENTS = {
+    LibDOM::Atoms::ATOM_dd,     LibDOM::Atoms::ATOM_dt,
+    LibDOM::Atoms::ATOM_li,     LibDOM::Atoms::ATOM_optgroup,
+    LibDOM::Atoms::ATOM_option, LibDOM::Atoms::ATOM_p,
+    LibDOM::Atoms::ATOM_rb,     LibDOM::Atoms::ATOM_rp,
+    LibDOM::Atoms::ATOM_rt,     LibDOM::Atoms::ATOM_rtc,
+};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-scope */
+constexpr TagSet SCOPE_BOUNDARIES = {
+    LibDOM::Atoms::ATOM_applet,  LibDOM::Atoms::ATOM_caption,
+    LibDOM::Atoms::ATOM_html,    LibDOM::Atoms::ATOM_table,
+    LibDOM::Atoms::ATOM_td,      LibDOM::Atoms::ATOM_th,
+    LibDOM::Atoms::ATOM_marquee, LibDOM::Atoms::ATOM_object,
+    LibDOM::Atoms::ATOM_template,
+};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-list-item-scope */
+constexpr TagSet LIST_ITEM_SCOPE_BOUNDARIES =
+    SCOPE_BOUNDARIES | TagSet{LibDOM::Atoms::ATOM_ol, LibDOM::Atoms::ATOM_ul};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-button-scope */
+constexpr TagSet BUTTON_SCOPE_BOUNDARIES =
+    SCOPE_BOUNDARIES | TagSet{LibDOM::Atoms::ATOM_button};
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-table-scope */
+constexpr TagSet TABLE_SCOPE_BOUNDARIES = {
+    LibDOM::Atoms::ATOM_html,
+    LibDOM::Atoms::ATOM_table,
+    LibDOM::Atoms::ATOM_template,
+};
+
+} // namespace LibHTML
+
+#endif
@@ -1,11 +1,15 @@
 #ifndef LIBHTML_TOKENIZER_H
 #define LIBHTML_TOKENIZER_H
 
+#include "libdom/atom.h"
+#include "libhtml/inputstream.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/status.h"
 #include "libhtml/tokens.h"
 #include <cstddef>
-#include <functional>
-#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace LibHTML {
@@ -58,14 +62,133 @@ enum TokenizerState : int {
   AFTER_DOCTYPE_NAME,
 };
 
-typedef std::function<void(std::unique_ptr<Token>)> OnEmitFunction;
+/**
+  The state the tree builder switches the tokenizer to after a start tag in the
+  "in head" and "in body" insertion modes, or UNDEFINED_STATE if it doesn't.
+  For whatever tokenizes a document without a tree builder to do that.
+*/
+TokenizerState textStateAfter(LibDOM::Atom tagName, bool scripting);
+
+/**
+  Backing storage for the strings of the token being built. Everything goes
+  into one buffer that keeps its capacity when it is reset, so once it has
+  grown to fit the largest token seen, building tokens doesn't allocate.
+*/
+class TokenArena {
+public:
+  struct Span {
+    size_t start = 0;
+    size_t length = 0;
+  };
+
+  void reset();
+  Span begin();
+  /**
+    Appends to a span, as far as it fits in the longest a span may get. Only
+    the most recently started span can grow. Returns whether the character
+    fit, and for a string, how many of its characters did.
+  */
+  bool append(Span &span, wchar_t c);
+  size_t append(Span &span, std::wstring_view s);
+  /** Drops a span and all spans after it. */
+  void rewind(Span span);
+  std::wstring_view view(Span span);
+
+  /** The longest a span may get, or 0 for no limit. */
+  void setMaxLength(size_t maxLength) { m_maxLength = maxLength; }
+  /** How many characters didn't fit in their spans, until resetDropped(). */
+  size_t dropped() const { return m_dropped; }
+  void resetDropped() { m_dropped = 0; }
+
+private:
+  std::wstring m_chars;
+  size_t m_maxLength = 0;
+  size_t m_dropped = 0;
+};
 
 class Tokenizer {
 public:
   Tokenizer() = default;
   ~Tokenizer() = default;
 
-  void process(const wchar_t *input, size_t size, OnEmitFunction onEmit);
+  /** Gets the tokenizer ready for a new document. */
+  void reset();
+
+  /**
+    Hands the tokenizer its next chunk of UTF-8 input. The input isn't copied,
+    so it has to stay valid until next() returns nullptr. Chunks can end in the
+    middle of a character; the tokenizer keeps the partial sequence and
+    finishes it with the next chunk.
+  */
+  void feed(const char *input, size_t size);
+
+  /**
+    Marks the end of the input: once the current chunk is used up, next()
+    produces the end-of-file token instead of asking for more.
+  */
+  void finish();
+
+  /**
+    Returns the next token, or nullptr if the tokenizer needs more input or
+    has got to a state that isn't implemented, which error() tells apart.
+
+    The token stays valid until the next call. Changes to currentState take
+    effect from the token after it, which is what lets the tree builder switch
+    the tokenizer into the RCDATA, RAWTEXT and script data states.
+  */
+  Token *next();
+
+  /**
+    Tokenizes a chunk of input, calling `sink(Token &)` for every token. The
+    sink's type is known at compile time, so it can be inlined into the loop.
+
+    A sink that returns bool can stop tokenizing by returning false, which
+    leaves the rest of the chunk to next().
+  */
+  template <typename Sink>
+  ParseStatus process(const char *input, size_t size, Sink &&sink) {
+    feed(input, size);
+    while (Token *token = next()) {
+      if constexpr (std::is_same_v<decltype(sink(*token)), bool>) {
+        if (!sink(*token))
+          return PARSE_STOPPED;
+      } else {
+        sink(*token);
+      }
+    }
+    return m_error == nullptr ? PARSE_OK : PARSE_ABORTED;
+  }
+
+  /** Where the tokenizer has got to in the current chunk, in bytes. */
+  size_t position() const { return m_input.position(); }
+  /**
+    Sets the start tag that end tags are matched against in the RCDATA,
+    RAWTEXT and script data states, for a tokenizer that starts in the middle
+    of a document.
+  */
+  void setLastStartTag(LibDOM::Atom tagName) {
+    m_lastStartTagEmitted = tagName;
+  }
+
+  /**
+    Applies the maxAttributes and maxTokenSize limits to the tokens from now
+    on. The other limits are up to the tree builder.
+  */
+  void setLimits(const ParserLimits &limits);
+  /** Attributes dropped for maxAttributes since the last reset(). */
+  size_t droppedAttributes() const { return m_droppedAttributes; }
+  /** Characters cut off for maxTokenSize since the last reset(). */
+  size_t droppedCharacters() const { return m_arena.dropped(); }
+
+  /** What the tokenizer couldn't handle, or nullptr if nothing. */
+  const char *error() const { return m_error; }
+  /**
+    Clears the error and carries on in the text state it was in, if the error
+    was in the text of an element like <title> or <script>, since the tree
+    builder waits for that element's end tag, and otherwise in the data state,
+    which is the best guess at where the input continues.
+  */
+  void recover();
 
   TokenizerState currentState = DATA;
   TokenizerState returnState = UNDEFINED_STATE;
@@ -74,19 +197,67 @@ private:
   void stateTick();
   void consume();
   void consume(size_t howMany);
-  void emit(std::unique_ptr<Token> token);
-  void create(std::unique_ptr<Token> token);
+  void emit(Token &token);
+  void emitCharacters(std::wstring_view data);
+  void emitEOF();
+  /** Emits the current character and every following one up to the next
+      '<', '&' (if requested), U+0000, '\r' or EOF as a single character run.
+   */
+  void emitTextRun(bool stopAtAmpersand);
+  /** Handles a '\r' consumed in one of the text states. */
+  void emitNewline();
+  void create(TokenType type);
   void emitCurrent();
-  OnEmitFunction m_onEmit;
+  void appendToName(wchar_t c);
+  void appendToName(std::wstring_view s);
+  void appendToData(wchar_t c);
+  void appendToData(std::wstring_view s);
+  void startAttribute();
+  void appendToAttributeName(wchar_t c);
+  void appendToAttributeName(std::wstring_view s);
+  void appendToAttributeValue(wchar_t c);
+  void appendToAttributeValue(std::wstring_view s);
+  bool isAppropriateEndTag();
+  void flushCharacterReference();
 
-  const wchar_t *m_input = nullptr;
-  size_t m_inputSize = 0;
-  size_t m_inputPtr = 0;
+  InputStream m_input;
+  const char *m_error = nullptr;
   wchar_t m_currentChar = 0;
+  /** The decoded text of the last character run. It only ever grows. */
+  std::vector<wchar_t> m_textBuffer;
   std::wstring m_tempBuffer = L"";
-  std::wstring m_lastStartTagEmitted = L"";
+  /** Where matching a named character reference has got to in the trie. */
+  size_t m_entityNode = 0;
+  /** The longest reference matched so far, and its length in m_tempBuffer. */
+  size_t m_entityMatchNode = 0;
+  size_t m_entityMatchLength = 0;
+  LibDOM::Atom m_lastStartTagEmitted = LibDOM::NULL_ATOM;
+
+  // names are hashed as they are appended, so that looking up their atoms
+  // doesn't need another pass over them
+  struct AttributeSpans {
+    TokenArena::Span name;
+    TokenArena::Span value;
+    unsigned int nameHash;
+  };
+
+  Token m_currentToken;
+  TokenArena m_arena;
+  TokenArena::Span m_nameSpan;
+  unsigned int m_nameHash = LibDOM::ATOM_HASH_SEED;
+  TokenArena::Span m_dataSpan;
+  std::vector<AttributeSpans> m_attributeSpans;
+  size_t m_maxAttributes = 0;
+  size_t m_droppedAttributes = 0;
 
-  std::unique_ptr<Token> m_currentToken;
+  // a single state tick emits at most two tokens; they wait here for next()
+  static const size_t MAX_PENDING_TOKENS = 2;
+  Token *m_pendingTokens[MAX_PENDING_TOKENS] = {};
+  size_t m_pendingCount = 0;
+  size_t m_pendingRead = 0;
+  Token m_characterTokens[MAX_PENDING_TOKENS] = {Token(CHARACTER),
+                                                 Token(CHARACTER)};
+  Token m_eofToken{END_OF_FILE};
 };
 
 } // namespace LibHTML
@@ -0,0 +1,111 @@
+#ifndef LIBHTML_TOKENPIPELINE_H
+#define LIBHTML_TOKENPIPELINE_H
+
+#include "libdom/atom.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/spscring.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokens.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LibHTML {
+
+/**
+  Runs a tokenizer over a whole document on a worker thread, ahead of the tree
+  builder, and hands its tokens over in batches through an SPSCRing.
+
+  The tree builder switches the tokenizer into another state after some start
+  tags, which the worker can't wait for. It makes the switch that the tree
+  builder makes for the tag in nearly every insertion mode, and records it
+  with the token. If the tree builder decides otherwise, it calls restart(),
+  and the tokens that the worker produced after that token are dropped.
+*/
+class TokenPipeline {
+public:
+  struct Entry {
+    Token token;
+    /** Where the token ends in the input. */
+    size_t end = 0;
+    /** The state the worker switched to after the token, if it did. */
+    TokenizerState switchedTo = UNDEFINED_STATE;
+    /** What the limits cut off the token, see Tokenizer::setLimits(). */
+    size_t droppedAttributes = 0;
+    size_t droppedCharacters = 0;
+  };
+
+  struct Batch {
+    /** Only the first `size` entries are in use; the rest are kept around. */
+    std::vector<Entry> entries;
+    size_t size = 0;
+    /** The strings of the tokens. It never grows while it holds any. */
+    std::wstring chars;
+    /** A tokenizer error that came right after the entries, or nullptr. */
+    const char *error = nullptr;
+  };
+
+  /**
+    The input has to stay valid while the pipeline exists. With `recover`, the
+    worker carries on after tokenizer errors instead of stopping at the first.
+  */
+  TokenPipeline(const char *input, size_t size, bool scripting, bool recover,
+                const ParserLimits &limits = ParserLimits());
+  ~TokenPipeline();
+
+  /** Starts the worker at the start of the input. */
+  void start(TokenizerState state);
+  /**
+    Drops all tokens that haven't been popped, and starts the worker over at
+    `offset`, in `state`, as if `lastStartTag` was the last start tag emitted.
+  */
+  void restart(size_t offset, TokenizerState state, LibDOM::Atom lastStartTag);
+
+  /**
+    Waits for the next batch, and returns nullptr once the worker has stopped
+    and all its batches are popped.
+  */
+  Batch *next();
+  /** Hands the batch from next() back to the worker. */
+  void pop();
+
+  size_t restarts() const { return m_restarts; }
+
+private:
+  static const size_t BATCH_COUNT = 16;
+  static const size_t BATCH_TOKENS = 256;
+  static const size_t BATCH_CHARS = 16384;
+
+  void stop();
+  /** Hands the batch from emptyBatch() over to the tree builder. */
+  void push();
+  void run(size_t offset, TokenizerState state, LibDOM::Atom lastStartTag);
+  /** Waits for an empty batch, or returns nullptr if the worker is stopped. */
+  Batch *emptyBatch();
+  /** Waits until `ready` returns true, spinning briefly before sleeping. */
+  template <typename F> void waitUntil(F ready);
+  /** Wakes up the other side after a batch was pushed or popped. */
+  void notify();
+
+  const char *m_input;
+  size_t m_size;
+  bool m_scripting;
+  bool m_recover;
+  ParserLimits m_limits;
+
+  SPSCRing<Batch, BATCH_COUNT> m_ring;
+  std::thread m_worker;
+  std::atomic<bool> m_stopping{false};
+  std::atomic<bool> m_finished{false};
+  std::mutex m_mutex;
+  std::condition_variable m_changed;
+  size_t m_restarts = 0;
+};
+
+} // namespace LibHTML
+
+#endif
@@ -1,7 +1,8 @@
 #ifndef LIBHTML_TOKENS_H
 #define LIBHTML_TOKENS_H
 
-#include <string>
+#include "libdom/atom.h"
+#include <string_view>
 #include <vector>
 
 namespace LibHTML {
@@ -16,82 +17,46 @@ enum TokenType : int {
   DOCTYPE_TOKEN,
 };
 
-class Token {
-public:
-  Token() = default;
-  virtual ~Token() = default;
-  virtual TokenType type();
-};
-
-class CharacterToken : public Token {
-public:
-  CharacterToken(wchar_t c);
-  TokenType type();
-  wchar_t character();
-
-private:
-  wchar_t m_c;
+struct Attribute {
+  LibDOM::Atom atom;
+  std::wstring_view name;
+  std::wstring_view value;
 };
 
-class EOFToken : public Token {
-public:
-  EOFToken() = default;
-  TokenType type();
-};
+/**
+  A token, tagged with its type.
 
-typedef struct {
-  std::wstring name;
-  std::wstring value;
-} Attribute;
+  The tokenizer reuses its tokens in place, and their strings point into the
+  tokenizer's input or into buffers it owns. A token, and every view taken from
+  it, is only valid until the tokenizer emits the next one.
+*/
+struct Token {
+  Token() = default;
+  explicit Token(TokenType type) : type(type) {}
 
-class TagToken : public Token {
-public:
-  TagToken(TokenType type);
-  TokenType type();
+  TokenType type = UNDEFINED_TOKEN;
 
-  std::wstring name();
-  void appendName(wchar_t c);
-  void appendName(const std::wstring name);
-  void setName(const std::wstring name);
+  /** CHARACTER: the run of characters. COMMENT: the comment's data. */
+  std::wstring_view data;
+  /** CHARACTER: whether every character in the run is ASCII whitespace. */
+  bool isWhitespace = false;
 
+  /** START_TAG, END_TAG: the tag name. DOCTYPE_TOKEN: the DOCTYPE name. */
+  std::wstring_view name;
+  /** START_TAG, END_TAG: the atom of the tag name. */
+  LibDOM::Atom atom = LibDOM::NULL_ATOM;
   bool selfClosing = false;
-  std::vector<Attribute> attributes = {};
+  std::vector<Attribute> attributes;
 
-private:
-  std::wstring m_name = L"";
-  TokenType m_type;
-};
-
-class CommentToken : public Token {
-public:
-  CommentToken() = default;
-  CommentToken(std::wstring data);
-  TokenType type();
-
-  std::wstring data();
-  void appendData(wchar_t c);
+  /** DOCTYPE_TOKEN */
+  bool forceQuirks = false;
 
-private:
-  std::wstring m_data = L"";
+  static Token characters(std::wstring_view data);
+  static Token tag(TokenType type, LibDOM::Atom atom);
 };
 
-class DoctypeToken : public Token {
-public:
-  DoctypeToken() = default;
-  DoctypeToken(wchar_t c);
-  DoctypeToken(std::wstring name);
-  TokenType type();
-
-  std::wstring name();
-  void appendName(wchar_t c);
-  void appendName(const std::wstring name);
-  bool forceQuirks();
-  void setForceQuirks(bool v);
-
-private:
-  std::wstring m_name = L"";
-  bool m_forceQuirks = false;
-};
+bool isHTMLWhitespace(wchar_t c);
+bool isHTMLWhitespace(std::wstring_view data);
 
 } // namespace LibHTML
 
@@ -0,0 +1,38 @@
+#ifndef LIBHTML_UTF8_H
+#define LIBHTML_UTF8_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace LibHTML {
+
+/**
+  Decodes the multibyte UTF-8 sequence at the start of `input` and stores the
+  number of bytes it took in `length`. Invalid sequences decode to U+FFFD one
+  maximal subpart at a time, the way the WHATWG decoder does it.
+
+  https://encoding.spec.whatwg.org/#utf-8-decoder
+*/
+wchar_t decodeUTF8Sequence(const char *input, size_t size, size_t &length);
+
+/**
+  Returns how many bytes at the end of `input` are the valid start of a
+  multibyte sequence that is cut off, i.e. bytes that the next chunk of input
+  could still complete. Returns 0 if the input ends on a character boundary.
+*/
+size_t incompleteUTF8Suffix(const char *input, size_t size);
+
+/**
+  Decodes `size` bytes of UTF-8 into `output`, which needs room for `size`
+  characters, and returns how many characters it wrote. Runs of ASCII are
+  widened in bulk without going through the decoder.
+*/
+size_t decodeUTF8(const char *input, size_t size, wchar_t *output);
+
+/** Appends the UTF-8 encoding of `input` to `output`. */
+void encodeUTF8(std::wstring_view input, std::string &output);
+
+} // namespace LibHTML
+
+#endif
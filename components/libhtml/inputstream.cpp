@@ -0,0 +1,168 @@
+#include "libhtml/inputstream.h"
+#include "libhtml/scanner.h"
+#include "libhtml/utf8.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <string.h>
+#include <string_view>
+#include <strings.h>
+
+namespace LibHTML {
+
+void InputStream::reset() {
+  m_data = nullptr;
+  m_size = 0;
+  m_position = 0;
+  m_characterStart = 0;
+  m_finished = false;
+  m_waiting = false;
+  m_skipLineFeed = false;
+  m_carrySize = 0;
+  m_carryWanted = 0;
+  m_chunk = nullptr;
+  m_chunkSize = 0;
+}
+
+void InputStream::feed(const char *input, size_t size) {
+  m_waiting = false;
+  if (m_data == m_carry && m_position < m_size) {
+    // finish what was carried over before reading the new chunk
+    m_carrySize = m_size - m_position;
+    memmove(m_carry, &m_carry[m_position], m_carrySize);
+    m_chunk = input;
+    m_chunkSize = size;
+    fillCarry();
+    return;
+  }
+  m_carrySize = 0;
+  m_chunk = nullptr;
+  start(input, size);
+}
+
+void InputStream::finish() {
+  m_finished = true;
+  m_waiting = false;
+}
+
+bool InputStream::needsMore(size_t length) {
+  assert(length <= MAX_LOOKAHEAD);
+  if (m_finished || m_position > m_size || m_size - m_position >= length)
+    return false;
+  carryOver(length);
+  return m_waiting;
+}
+
+bool InputStream::startsWith(std::string_view s, bool ignoreCase) {
+  if (m_position > m_size || m_size - m_position < s.size())
+    return false;
+  const char *data = &m_data[m_position];
+  return ignoreCase ? strncasecmp(data, s.data(), s.size()) == 0
+                    : memcmp(data, s.data(), s.size()) == 0;
+}
+
+void InputStream::skip(size_t length) {
+  assert(m_position + length <= m_size);
+  m_position += length;
+}
+
+std::string_view InputStream::consumeTextRun(bool stopAtAmpersand) {
+  size_t start = m_characterStart;
+  m_position += findTextSentinel(&m_data[m_position], m_size - m_position,
+                                 stopAtAmpersand);
+  if (m_position == m_size && !m_finished)
+    m_position -= incompleteUTF8Suffix(&m_data[start], m_position - start);
+  return {&m_data[start], m_position - start};
+}
+
+void InputStream::skipLineFeed() {
+  if (m_position >= m_size)
+    m_skipLineFeed = true;
+}
+
+wchar_t InputStream::consumeSlow() {
+  if (m_position >= m_size) {
+    // only reached once the input is finished
+    m_position++;
+    return EOF;
+  }
+  size_t length;
+  wchar_t c =
+      decodeUTF8Sequence(&m_data[m_position], m_size - m_position, length);
+  m_position += length;
+  return c;
+}
+
+bool InputStream::prepare() {
+  if (m_waiting)
+    return false;
+
+  if (m_position >= m_size && m_chunk != nullptr) {
+    // done with the carried over bytes
+    const char *chunk = m_chunk;
+    m_chunk = nullptr;
+    m_carrySize = 0;
+    start(chunk, m_chunkSize);
+  }
+
+  if (!m_finished && m_position < m_size) {
+    size_t left = m_size - m_position;
+    if (left < 4 && incompleteUTF8Suffix(&m_data[m_position], left) == left) {
+      // the chunk ends in the middle of a character
+      carryOver(0);
+      return prepare();
+    }
+  }
+
+  // once the input is finished its end is one more thing to consume
+  return m_position < m_size + (m_finished ? 1 : 0);
+}
+
+void InputStream::start(const char *data, size_t size) {
+  m_data = data;
+  m_size = size;
+  m_position = 0;
+
+  if (m_skipLineFeed) {
+    // the previous chunk ended in the middle of a "\r\n" pair
+    m_skipLineFeed = false;
+    if (m_size > 0 && m_data[0] == '\n')
+      m_position = 1;
+  }
+}
+
+void InputStream::carryOver(size_t wanted) {
+  size_t left = m_size - m_position;
+  memmove(m_carry, &m_data[m_position], left);
+  m_carrySize = left;
+  m_carryWanted = wanted;
+
+  if (m_chunk != nullptr && m_chunkSize > 0) {
+    // still carrying bytes over, and the chunk after them has what we need
+    fillCarry();
+    return;
+  }
+  m_chunk = nullptr;
+  m_data = m_carry;
+  m_size = m_carrySize;
+  m_position = 0;
+  m_waiting = true;
+}
+
+void InputStream::fillCarry() {
+  while (m_chunkSize > 0 && m_carrySize < MAX_CARRY &&
+         (m_carrySize < m_carryWanted ||
+          incompleteUTF8Suffix(m_carry, m_carrySize) > 0)) {
+    m_carry[m_carrySize++] = *m_chunk++;
+    m_chunkSize--;
+  }
+  start(m_carry, m_carrySize);
+  if (m_carrySize < m_carryWanted) {
+    // the chunk ran out before the lookahead did, so wait for the next one
+    m_chunk = nullptr;
+    m_chunkSize = 0;
+    m_waiting = true;
+  }
+}
+
+} // namespace LibHTML
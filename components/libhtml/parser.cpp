@@ -1,99 +1,351 @@
 #include "libhtml/parser.h"
 #include "libdom.h"
+#include "libdom/atom.h"
 #include "libdom/comment.h"
 #include "libdom/element.h"
 #include "libdom/node.h"
+#include "libdom/refptr.h"
 #include "libdom/text.h"
-#include "libhtml/exceptions.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/status.h"
+#include "libhtml/tagsets.h"
 #include "libhtml/tokenizer.h"
+#include "libhtml/tokenpipeline.h"
 #include "libhtml/tokens.h"
+#include "libhtml/utf8.h"
 #include <algorithm>
 #include <cassert>
 #include <cctype>
-#include <codecvt>
 #include <cstddef>
-#include <cwchar>
+#include <cstdio>
 #include <exception>
-#include <iostream>
-#include <locale>
-#include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-#define REPROCESS process(std::move(token))
-#define CONVERT_TO(type, ptr)                                                  \
-  std::unique_ptr<type>(reinterpret_cast<type *>(ptr.release()))
+#define REPROCESS process(token)
 
 #define CURRENT_NODE (m_nodeStack.back())
 
 #define INSERT_HTML_ELEMENT(token)                                             \
-  insertForeignElement((token).get(), NS_HTML, false)
-
-#define IS_ONE_OF(name, names)                                                 \
-  (std::find_if(names.begin(), names.end(), [name](std::wstring otherName) {   \
-     return otherName == name;                                                 \
-   }) != names.end())
+  insertForeignElement((token), HTML_NAMESPACE, false)
 
 namespace LibHTML {
 
-Parser::Parser() : document(std::make_shared<LibDOM::Document>()) {}
+using namespace LibDOM::Atoms;
+
+// the names that some of the insertion modes handle together
+
+static constexpr TagSet HEAD_ELEMENTS = {
+    ATOM_base, ATOM_basefont, ATOM_bgsound, ATOM_link, ATOM_meta, ATOM_noframes,
+    ATOM_script, ATOM_style, ATOM_template, ATOM_title,
+};
+
+static constexpr TagSet HEADINGS = {
+    ATOM_h1, ATOM_h2, ATOM_h3, ATOM_h4, ATOM_h5, ATOM_h6,
+};
+
+/** Start tags that close a p element in button scope before they open. */
+static constexpr TagSet BLOCK_START_TAGS = {
+    ATOM_address, ATOM_article, ATOM_aside, ATOM_blockquote, ATOM_center,
+    ATOM_details, ATOM_dialog, ATOM_dir, ATOM_div, ATOM_dl, ATOM_fieldset,
+    ATOM_figcaption, ATOM_figure, ATOM_footer, ATOM_header, ATOM_hgroup,
+    ATOM_main, ATOM_menu, ATOM_nav, ATOM_ol, ATOM_p, ATOM_search, ATOM_section,
+    ATOM_summary, ATOM_ul,
+};
+
+/** End tags that pop up to the matching element if it's in scope. */
+static constexpr TagSet BLOCK_END_TAGS = {
+    ATOM_address, ATOM_article, ATOM_aside, ATOM_blockquote, ATOM_button,
+    ATOM_center, ATOM_details, ATOM_dialog, ATOM_dir, ATOM_div, ATOM_dl,
+    ATOM_fieldset, ATOM_figcaption, ATOM_figure, ATOM_footer, ATOM_header,
+    ATOM_hgroup, ATOM_listing, ATOM_main, ATOM_menu, ATOM_nav, ATOM_ol,
+    ATOM_pre, ATOM_search, ATOM_section, ATOM_summary, ATOM_ul,
+};
+
+/** Start tags that are ignored in body. */
+static constexpr TagSet TABLE_PARTS = {
+    ATOM_caption, ATOM_col, ATOM_colgroup, ATOM_frame, ATOM_head, ATOM_tbody,
+    ATOM_td, ATOM_tfoot, ATOM_th, ATOM_thead, ATOM_tr,
+};
+
+/** Returns what is left of a character run after its leading whitespace. */
+static std::wstring_view stripLeadingWhitespace(std::wstring_view data) {
+  size_t i = 0;
+  while (i < data.size() && isHTMLWhitespace(data[i]))
+    i++;
+  return data.substr(i);
+}
+
+Parser::Parser() : document(LibDOM::Document::create()) {}
 
 void Parser::reset() {
   m_insertionMode = INITIAL;
   m_nodeStack.clear();
-  m_tokenizer.currentState = DATA;
+  m_tokenizer.reset();
   m_activeFormattingElems.clear();
+  m_pendingText.clear();
+  m_pendingTextParent = nullptr;
   m_headElementPointer = nullptr;
   m_formElementPointer = nullptr;
+  m_fragmentContext = nullptr;
   m_framesetOk = true;
+  m_isParsing = true;
+  m_aborted = false;
+  m_error = nullptr;
+  m_paused = false;
+  m_counters = LimitCounters();
+  m_nodeCount = 0;
+  m_bytesParsed = 0;
+}
+
+void Parser::setLimits(const ParserLimits &limits) {
+  m_limits = limits;
+  m_tokenizer.setLimits(limits);
+}
+
+LimitCounters Parser::limitCounters() const {
+  auto counters = m_counters;
+  counters.droppedAttributes += m_tokenizer.droppedAttributes();
+  counters.droppedCharacters += m_tokenizer.droppedCharacters();
+  return counters;
+}
+
+ParseStatus Parser::parse(const char *text, size_t textLen) {
+  return parse(text, textLen, ParseBudget());
+}
+
+ParseStatus Parser::parse(const char *text, size_t textLen,
+                          const ParseBudget &budget) {
+  // the tokenizer can only take the next chunk once it is done with this one
+  if (m_paused)
+    runTokenizer();
+  if (status() != PARSE_OK)
+    return status();
+  if (m_limits.maxBytes != 0 && textLen > m_limits.maxBytes - m_bytesParsed) {
+    textLen = m_limits.maxBytes - m_bytesParsed;
+    m_counters.byteLimitReached = true;
+  }
+  m_bytesParsed += textLen;
+  m_tokenizer.feed(text, textLen);
+  // the input ends with the last byte within the limit
+  if (m_counters.byteLimitReached)
+    m_tokenizer.finish();
+  return runTokenizer(budget);
+}
+
+ParseStatus Parser::parse(const wchar_t *text, size_t textLen) {
+  std::wstring_view input(text, textLen);
+  size_t eof = input.find(static_cast<wchar_t>(EOF));
+  m_utf8Buffer.clear();
+  encodeUTF8(input.substr(0, eof), m_utf8Buffer);
+  auto result = parse(m_utf8Buffer.data(), m_utf8Buffer.size());
+  if (eof != std::wstring_view::npos)
+    return finish();
+  return result;
+}
+
+ParseStatus Parser::finish() { return finish(ParseBudget()); }
+
+ParseStatus Parser::finish(const ParseBudget &budget) {
+  if (status() != PARSE_OK)
+    return status();
+  // whatever is left of the current chunk comes before the end of the input
+  m_tokenizer.finish();
+  return runTokenizer(budget);
+}
+
+ParseStatus Parser::resume(const ParseBudget &budget) {
+  if (!m_paused)
+    return status();
+  return runTokenizer(budget);
+}
+
+ParseStatus Parser::parsePipelined(const char *text, size_t textLen) {
+  if (status() != PARSE_OK)
+    return status();
+  if (m_limits.maxBytes != 0 && textLen > m_limits.maxBytes - m_bytesParsed) {
+    textLen = m_limits.maxBytes - m_bytesParsed;
+    m_counters.byteLimitReached = true;
+  }
+  m_bytesParsed += textLen;
+
+  TokenPipeline pipeline(text, textLen, m_scriptingFlag,
+                         recoveryMode == BEST_EFFORT, m_limits);
+  pipeline.start(m_tokenizer.currentState);
+  LibDOM::Atom lastStartTag = LibDOM::NULL_ATOM;
+  while (status() == PARSE_OK) {
+    auto *batch = pipeline.next();
+    if (batch == nullptr)
+      break;
+
+    bool restarted = false;
+    for (size_t i = 0; i < batch->size && status() == PARSE_OK; i++) {
+      auto &entry = batch->entries[i];
+      if (entry.token.type == START_TAG)
+        lastStartTag = entry.token.atom;
+      m_counters.droppedAttributes += entry.droppedAttributes;
+      m_counters.droppedCharacters += entry.droppedCharacters;
+      m_switchedTo = UNDEFINED_STATE;
+      process(entry.token);
+      checkNodeLimit();
+      if (m_switchedTo != entry.switchedTo && status() == PARSE_OK) {
+        // the worker guessed wrong, so the tokens after this one are too
+        pipeline.restart(entry.end,
+                         m_switchedTo == UNDEFINED_STATE ? DATA : m_switchedTo,
+                         lastStartTag);
+        restarted = true;
+        break;
+      }
+    }
+    if (restarted)
+      continue;
+    if (batch->error != nullptr)
+      unsupported(batch->error);
+    pipeline.pop();
+  }
+  flushPendingText();
+  return status();
 }
 
-void Parser::parse(const char *text, size_t textLen) {
-  // convert string to wstring
-  std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-  std::wstring utf16Text = converter.from_bytes(std::string(text, textLen));
+ParseStatus
+Parser::parseFragment(LibDOM::Element &context, const char *text,
+                      size_t textLen,
+                      std::vector<LibDOM::RefPtr<LibDOM::Node>> &nodes) {
+  if (m_fragmentDocument == nullptr)
+    m_fragmentDocument = LibDOM::Document::create();
+  auto mainDocument = std::move(document);
+  document = m_fragmentDocument;
+  document->mode = context.ownerDocument != nullptr
+                       ? context.ownerDocument->mode
+                       : std::string("no-quirks");
+  reset();
+  m_fragmentContext = &context;
+
+  if (context.namespaceURI == HTML_NAMESPACE) {
+    TokenizerState state = textStateAfter(context.localName, m_scriptingFlag);
+    if (state != UNDEFINED_STATE)
+      m_tokenizer.currentState = state;
+  }
+
+  auto root = createElement(ATOM_html, HTML_NAMESPACE);
+  document->appendChild(root);
+  m_nodeStack.push_back(root);
+  resetInsertionModeAppropriately();
+
+  // a form around the context keeps forms in the fragment from nesting
+  for (LibDOM::Node *node = &context; node != nullptr;
+       node = node->parentNode) {
+    if (node->nodeType != LibDOM::Node::ELEMENT_NODE)
+      continue;
+    auto *element = static_cast<LibDOM::Element *>(node);
+    if (element->localName == ATOM_form &&
+        element->namespaceURI == HTML_NAMESPACE) {
+      m_formElementPointer = element;
+      break;
+    }
+  }
+
+  parse(text, textLen);
+  ParseStatus result = finish();
 
-  m_tokenizer.process(utf16Text.c_str(), utf16Text.length(),
-                      [this](std::unique_ptr<Token> token) {
-                        this->process(std::move(token));
-                      });
+  while (root->hasChildNodes())
+    nodes.push_back(root->removeChild(root->firstChild()));
+  // leave the fragment document empty for the next fragment
+  while (document->hasChildNodes())
+    document->removeChild(document->lastChild());
+  m_fragmentContext = nullptr;
+  m_formElementPointer = nullptr;
+  document = std::move(mainDocument);
+  return result;
 }
 
-void Parser::parse(const wchar_t *text, size_t textLen) {
-  try {
-    m_tokenizer.process(text, textLen, [this](std::unique_ptr<Token> token) {
-      if (!m_isParsing)
-        throw 0;
-      this->process(std::move(token));
-    });
-  } catch (int &a) {
+ParseStatus Parser::runTokenizer(const ParseBudget &budget) {
+  // reading the clock costs about as much as a short token, so only do it
+  // every few tokens
+  static const size_t CLOCK_INTERVAL = 32;
+  bool timed = budget.deadline != std::chrono::steady_clock::time_point::max();
+  m_paused = false;
+  for (size_t count = 0;; count++) {
+    if ((budget.tokens != 0 && count == budget.tokens) ||
+        (timed && count % CLOCK_INTERVAL == CLOCK_INTERVAL - 1 &&
+         std::chrono::steady_clock::now() >= budget.deadline)) {
+      m_paused = true;
+      break;
+    }
+    Token *token = m_tokenizer.next();
+    if (token == nullptr) {
+      if (m_tokenizer.error() == nullptr)
+        break;
+      unsupported(m_tokenizer.error());
+      if (m_aborted)
+        break;
+      m_tokenizer.recover();
+      continue;
+    }
+    process(*token);
+    checkNodeLimit();
+    if (status() != PARSE_OK)
+      break;
+  }
+  // the tree is complete up to the last token whenever parse() returns
+  flushPendingText();
+  if (m_paused && status() == PARSE_OK)
+    return PARSE_PAUSED;
+  m_paused = false;
+  return status();
+}
+
+ParseStatus Parser::status() const {
+  if (m_aborted)
+    return PARSE_ABORTED;
+  return m_isParsing ? PARSE_OK : PARSE_STOPPED;
+}
+
+void Parser::checkNodeLimit() {
+  if (m_limits.maxNodes == 0 || m_nodeCount < m_limits.maxNodes ||
+      status() != PARSE_OK)
     return;
+  // the few nodes that finishing the tree can take are let through
+  m_counters.nodeLimitReached = true;
+  Token eof(END_OF_FILE);
+  process(eof);
+}
+
+void Parser::unsupported(const char *what) {
+  if (m_error == nullptr) {
+    m_error = what;
+    if (warnings != nullptr)
+      *warnings << "WARNING: unsupported markup: " << what << "\n";
   }
+  if (recoveryMode != BEST_EFFORT)
+    m_aborted = true;
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#the-initial-insertion-mode */
-void Parser::initialInsertion(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (isspace(charToken->character())) {
+void Parser::initialInsertion(Token &token) {
+  if (token.type == CHARACTER) {
+    if (token.isWhitespace) {
       return;
     }
-    token = std::move(charToken);
+    auto rest = stripLeadingWhitespace(token.data);
+    token.data = rest;
   }
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), document);
+  if (token.type == COMMENT) {
+    insertComment(token, document);
     return;
   }
 
-  if (token->type() == DOCTYPE_TOKEN) {
-    auto docToken = CONVERT_TO(DoctypeToken, token);
-    auto docType = std::make_shared<LibDOM::DocumentType>();
-    docType->name = docToken->name();
+  if (token.type == DOCTYPE_TOKEN) {
+    auto docType = document->createNode<LibDOM::DocumentType>();
+    m_nodeCount++;
+    docType->name = token.name;
     document->appendChild(docType);
     if (!document->parserCannotChangeMode &&
-        (docToken->forceQuirks() || docToken->name() != L"html")) {
+        (token.forceQuirks || token.name != L"html")) {
       document->mode = "quirks";
     }
     m_insertionMode = BEFORE_HTML;
@@ -108,47 +360,43 @@ void Parser::initialInsertion(std::unique_ptr<Token> token) {
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#the-before-html-insertion-mode */
-void Parser::beforeHtml(std::unique_ptr<Token> token) {
-  if (token->type() == DOCTYPE_TOKEN)
+void Parser::beforeHtml(Token &token) {
+  if (token.type == DOCTYPE_TOKEN)
     return;
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), document);
+  if (token.type == COMMENT) {
+    insertComment(token, document);
     return;
   }
 
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (isspace(charToken->character())) {
+  if (token.type == CHARACTER) {
+    if (token.isWhitespace) {
       return;
     }
-    token = std::move(charToken);
+    auto rest = stripLeadingWhitespace(token.data);
+    token.data = rest;
   }
 
-  if (token->type() == START_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html") {
-      auto elem = createElementForToken(tagToken.get(), NS_HTML, document);
+  if (token.type == START_TAG) {
+    if (token.atom == ATOM_html) {
+      auto elem = createElementForToken(token, HTML_NAMESPACE, document);
       document->appendChild(elem);
       m_nodeStack.push_back(elem);
       m_insertionMode = BEFORE_HEAD;
       return;
     }
-    token = std::move(tagToken);
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html" || tagToken->name() == L"head" ||
-        tagToken->name() == L"body" || tagToken->name() == L"br") {
-      token = std::move(tagToken);
+  if (token.type == END_TAG) {
+    if (token.atom == ATOM_html || token.atom == ATOM_head ||
+        token.atom == ATOM_body || token.atom == ATOM_br) {
       goto anythingElse;
     }
     return;
   }
 
 anythingElse:
-  auto elem = createElement(L"html", NS_HTML);
+  auto elem = createElement(ATOM_html, HTML_NAMESPACE);
   document->appendChild(elem);
   m_nodeStack.push_back(elem);
   m_insertionMode = BEFORE_HEAD;
@@ -156,155 +404,148 @@ anythingElse:
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#the-before-head-insertion-mode */
-void Parser::beforeHead(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (isspace(charToken->character())) {
+void Parser::beforeHead(Token &token) {
+  if (token.type == CHARACTER) {
+    if (token.isWhitespace) {
       return;
     }
-    token = std::move(charToken);
+    auto rest = stripLeadingWhitespace(token.data);
+    token.data = rest;
   }
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), CURRENT_NODE);
+  if (token.type == COMMENT) {
+    insertComment(token, CURRENT_NODE);
     return;
   }
 
-  if (token->type() == DOCTYPE_TOKEN)
+  if (token.type == DOCTYPE_TOKEN)
     return;
 
-  if (token->type() == START_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html") {
-      inBody(std::move(tagToken));
+  if (token.type == START_TAG) {
+    if (token.atom == ATOM_html) {
+      inBody(token);
       return;
     }
 
-    if (tagToken->name() == L"head") {
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_head) {
+      auto elem = INSERT_HTML_ELEMENT(token);
       m_headElementPointer = elem;
       m_insertionMode = IN_HEAD;
-      document->head = elem;
       return;
     }
-    token = std::move(tagToken);
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html" || tagToken->name() == L"head" ||
-        tagToken->name() == L"body" || tagToken->name() == L"br") {
-      token = std::move(tagToken);
+  if (token.type == END_TAG) {
+    if (token.atom == ATOM_html || token.atom == ATOM_head ||
+        token.atom == ATOM_body || token.atom == ATOM_br) {
       goto anythingElse;
     }
     return;
   }
 
 anythingElse:
-  auto tagToken = std::make_shared<TagToken>(START_TAG);
-  tagToken->appendName(L"head");
-  auto elem = INSERT_HTML_ELEMENT(tagToken);
+  auto elem = INSERT_HTML_ELEMENT(Token::tag(START_TAG, ATOM_head));
   m_headElementPointer = elem;
   m_insertionMode = IN_HEAD;
-  document->head = elem;
   REPROCESS;
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#parsing-main-inhead */
-void Parser::inHead(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (isspace(charToken->character())) {
-      insertCharacter(std::move(charToken));
+void Parser::inHead(Token &token) {
+  if (token.type == CHARACTER) {
+    if (token.isWhitespace) {
+      insertCharacter(token.data);
       return;
     }
-    token = std::move(charToken);
+    auto data = token.data;
+    auto rest = stripLeadingWhitespace(data);
+    if (rest.size() != data.size())
+      insertCharacter(data.substr(0, data.size() - rest.size()));
+    token.data = rest;
   }
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), CURRENT_NODE);
+  if (token.type == COMMENT) {
+    insertComment(token, CURRENT_NODE);
     return;
   }
 
-  if (token->type() == DOCTYPE_TOKEN)
+  if (token.type == DOCTYPE_TOKEN)
     return;
 
-  if (token->type() == START_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html") {
-      inBody(std::move(tagToken));
+  if (token.type == START_TAG) {
+    if (token.atom == ATOM_html) {
+      inBody(token);
       return;
     }
 
-    if (tagToken->name() == L"template") {
-      throw StringException("TODO: in head: template end tag");
+    if (token.atom == ATOM_template) {
+      unsupported("TODO: in head: template end tag");
+      return;
     }
 
-    if (tagToken->name() == L"base" || tagToken->name() == L"basefont" ||
-        tagToken->name() == L"bgsound" || tagToken->name() == L"link") {
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_base || token.atom == ATOM_basefont ||
+        token.atom == ATOM_bgsound || token.atom == ATOM_link) {
+      auto elem = INSERT_HTML_ELEMENT(token);
       m_nodeStack.pop_back();
       return;
     }
 
-    if (tagToken->name() == L"meta") {
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_meta) {
+      auto elem = INSERT_HTML_ELEMENT(token);
       m_nodeStack.pop_back();
       // FIXME: proper charset/content-type encoding handling
       return;
     }
 
-    if (tagToken->name() == L"title") {
-      genericRcdataParse(std::move(tagToken));
+    if (token.atom == ATOM_title) {
+      genericRcdataParse(token);
       return;
     }
 
-    if (tagToken->name() == L"noframes" || tagToken->name() == L"style" ||
-        (tagToken->name() == L"noscript" && m_scriptingFlag)) {
-      genericRawTextParse(std::move(tagToken));
+    if (token.atom == ATOM_noframes || token.atom == ATOM_style ||
+        (token.atom == ATOM_noscript && m_scriptingFlag)) {
+      genericRawTextParse(token);
       return;
     }
 
-    if (tagToken->name() == L"noscript" && !m_scriptingFlag) {
-      INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_noscript && !m_scriptingFlag) {
+      INSERT_HTML_ELEMENT(token);
       m_insertionMode = IN_HEAD_NOSCRIPT;
       return;
     }
 
-    if (tagToken->name() == L"script") {
+    if (token.atom == ATOM_script) {
       auto location = CURRENT_NODE;
-      auto elem = createElementForToken(tagToken.get(), NS_HTML, location);
+      auto elem = createElementForToken(token, HTML_NAMESPACE, location);
       // FIXME: Set the element's parser document to the Document, and set the
       // element's force async to false.
       location->appendChild(elem);
       m_nodeStack.push_back(elem);
-      m_tokenizer.currentState = SCRIPT_DATA;
+      switchTokenizer(SCRIPT_DATA);
       m_originalInsertionMode = m_insertionMode;
       m_insertionMode = TEXT;
       return;
     }
 
-    if (tagToken->name() == L"head") {
+    if (token.atom == ATOM_head) {
       return;
     }
-    token = std::move(tagToken);
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"head") {
+  if (token.type == END_TAG) {
+    if (token.atom == ATOM_head) {
       m_nodeStack.pop_back();
       m_insertionMode = AFTER_HEAD;
       return;
     }
 
-    if (tagToken->name() == L"template") {
-      throw StringException("TODO: in head: template end tag");
+    if (token.atom == ATOM_template) {
+      unsupported("TODO: in head: template end tag");
+      return;
     }
 
-    if (tagToken->name() == L"body" || tagToken->name() == L"html" ||
-        tagToken->name() == L"br") {
-      token = std::move(tagToken);
+    if (token.atom == ATOM_body || token.atom == ATOM_html ||
+        token.atom == ATOM_br) {
       goto anythingElse;
     }
     return;
@@ -317,344 +558,331 @@ anythingElse:
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#the-after-head-insertion-mode */
-void Parser::afterHead(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (isspace(charToken->character())) {
-      insertCharacter(std::move(charToken));
+void Parser::afterHead(Token &token) {
+  if (token.type == CHARACTER) {
+    if (token.isWhitespace) {
+      insertCharacter(token.data);
       return;
     }
-    token = std::move(charToken);
+    auto data = token.data;
+    auto rest = stripLeadingWhitespace(data);
+    if (rest.size() != data.size())
+      insertCharacter(data.substr(0, data.size() - rest.size()));
+    token.data = rest;
   }
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), CURRENT_NODE);
+  if (token.type == COMMENT) {
+    insertComment(token, CURRENT_NODE);
     return;
   }
 
-  if (token->type() == DOCTYPE_TOKEN)
+  if (token.type == DOCTYPE_TOKEN)
     return;
 
-  if (token->type() == START_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html") {
-      inBody(std::move(tagToken));
+  if (token.type == START_TAG) {
+    if (token.atom == ATOM_html) {
+      inBody(token);
       return;
     }
-    if (tagToken->name() == L"body") {
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_body) {
+      auto elem = INSERT_HTML_ELEMENT(token);
       m_framesetOk = false;
       m_insertionMode = IN_BODY;
-      document->body = elem;
       return;
     }
-    if (tagToken->name() == L"frameset") {
-      INSERT_HTML_ELEMENT(tagToken);
+    if (token.atom == ATOM_frameset) {
+      INSERT_HTML_ELEMENT(token);
       m_insertionMode = IN_FRAMESET;
       return;
     }
-    const std::vector<std::wstring> names = {
-        L"base",     L"basefont", L"bgsound", L"link",     L"meta",
-        L"noframes", L"script",   L"style",   L"template", L"title"};
-    auto name = tagToken->name();
-    if (IS_ONE_OF(name, names)) {
-      throw StringException("TODO: Process the token using the rules for the "
-                            "\"in head\" insertion mode.");
+    auto name = token.atom;
+    if (HEAD_ELEMENTS.contains(name)) {
+      unsupported("TODO: Process the token using the rules for the "
+                  "\"in head\" insertion mode.");
+      return;
     }
-    if (name == L"head")
+    if (name == ATOM_head)
       return;
-    token = std::move(tagToken);
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"body" || tagToken->name() == L"html" ||
-        tagToken->name() == L"br") {
-      token = std::move(tagToken);
+  if (token.type == END_TAG) {
+    if (token.atom == ATOM_body || token.atom == ATOM_html ||
+        token.atom == ATOM_br) {
       goto anythingElse;
     }
     return;
   }
 
 anythingElse:
-  auto tagToken = std::unique_ptr<TagToken>(new TagToken(START_TAG));
-  tagToken->appendName(L"body");
-  auto elem = INSERT_HTML_ELEMENT(tagToken);
+  auto elem = INSERT_HTML_ELEMENT(Token::tag(START_TAG, ATOM_body));
   m_insertionMode = IN_BODY;
-  document->body = elem;
   REPROCESS;
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#parsing-main-inbody */
-void Parser::inBody(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    if (charToken->character() == 0) {
-      return;
-    }
-    if (isspace(charToken->character())) {
-      reconstructActiveFormattingElements();
-      insertCharacter(std::move(charToken));
+void Parser::inBody(Token &token) {
+  if (token.type == CHARACTER) {
+    auto data = token.data;
+    // the tokenizer never puts U+0000 into a run with other characters
+    if (data.size() == 1 && data[0] == 0) {
       return;
     }
     reconstructActiveFormattingElements();
-    insertCharacter(std::move(charToken));
-    m_framesetOk = false;
+    insertCharacter(data);
+    if (!token.isWhitespace)
+      m_framesetOk = false;
     return;
   }
 
-  if (token->type() == COMMENT) {
-    insertComment(std::move(token), CURRENT_NODE);
+  if (token.type == COMMENT) {
+    insertComment(token, CURRENT_NODE);
     return;
   }
 
-  if (token->type() == DOCTYPE_TOKEN)
+  if (token.type == DOCTYPE_TOKEN)
     return;
 
-  if (token->type() == START_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"html") {
-      for (const auto &attr : tagToken->attributes) {
-        auto htmlElem = std::static_pointer_cast<LibDOM::HTMLHtmlElement>(
+  if (token.type == START_TAG) {
+    if (token.atom == ATOM_html) {
+      for (const auto &attr : token.attributes) {
+        auto htmlElem = LibDOM::static_pointer_cast<LibDOM::HTMLHtmlElement>(
             *m_nodeStack.begin());
-        if (htmlElem->hasAttribute(attr.name))
+        if (htmlElem->attributes.find(attr.atom, attr.name) != nullptr)
           continue;
-        htmlElem->setAttribute(attr.name, attr.value);
+        htmlElem->attributes.set(attr.atom, LibDOM::DOMString(attr.value),
+                                 attr.name);
       }
       return;
     }
 
-    const std::vector<std::wstring> names = {
-        L"base",     L"basefont", L"bgsound", L"link",     L"meta",
-        L"noframes", L"script",   L"style",   L"template", L"title"};
-    auto name = tagToken->name();
-    if (IS_ONE_OF(name, names)) {
-      inHead(std::move(tagToken));
+    auto name = token.atom;
+    if (HEAD_ELEMENTS.contains(name)) {
+      inHead(token);
       return;
     }
 
-    const std::vector<std::wstring> names2 = {
-        L"address",  L"article",    L"aside",   L"blockquote", L"center",
-        L"details",  L"dialog",     L"dir",     L"div",        L"dl",
-        L"fieldset", L"figcaption", L"figure",  L"footer",     L"header",
-        L"hgroup",   L"main",       L"menu",    L"nav",        L"ol",
-        L"p",        L"search",     L"section", L"summary",    L"ul"};
-    if (IS_ONE_OF(name, names2)) {
-      if (stackHasInButtonScope(L"p"))
+    if (BLOCK_START_TAGS.contains(name)) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       return;
     }
 
-    const std::vector<std::wstring> names3 = {L"h1", L"h2", L"h3",
-                                              L"h4", L"h5", L"h6"};
-    if (IS_ONE_OF(name, names3)) {
-      if (stackHasInButtonScope(L"p"))
+    if (HEADINGS.contains(name)) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      auto currentNodeName = CURRENT_NODE->nodeName;
-      if (IS_ONE_OF(currentNodeName, names3)) {
+      if (HEADINGS.contains(CURRENT_NODE->localName)) {
         m_nodeStack.pop_back();
       }
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       return;
     }
 
-    if (name == L"pre" || name == L"listing") {
-      if (stackHasInButtonScope(L"p"))
+    if (name == ATOM_pre || name == ATOM_listing) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
 
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       // FIXME: If the next token is a U+000A LINE FEED (LF) character token,
       // then ignore that token and move on to the next one.
       m_framesetOk = false;
       return;
     }
 
-    if (name == L"form") {
+    if (name == ATOM_form) {
       if (m_formElementPointer != nullptr)
         return;
-      if (stackHasInButtonScope(L"p"))
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
+      auto elem = INSERT_HTML_ELEMENT(token);
       m_formElementPointer = elem;
       return;
     }
 
-    if (name == L"li") {
+    if (name == ATOM_li) {
       m_framesetOk = false;
-      throw StringException("todo: in body: li tag (too lazy)");
+      unsupported("todo: in body: li tag (too lazy)");
+      return;
     }
 
-    if (name == L"dd" || name == L"dt") {
+    if (name == ATOM_dd || name == ATOM_dt) {
       m_framesetOk = false;
-      throw StringException("todo: in body: dd/dt tag (too lazy)");
+      unsupported("todo: in body: dd/dt tag (too lazy)");
+      return;
     }
 
-    if (name == L"plaintext") {
-      if (stackHasInButtonScope(L"p"))
+    if (name == ATOM_plaintext) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      INSERT_HTML_ELEMENT(tagToken);
-      m_tokenizer.currentState = PLAINTEXT;
+      INSERT_HTML_ELEMENT(token);
+      switchTokenizer(PLAINTEXT);
       return;
     }
 
-    if (name == L"button") {
-      for (auto elem : m_nodeStack) {
-        if (elem->nodeName == L"button" && isInScope(elem)) {
-          generateImpliedEndTags();
-          popStackUntil(L"button");
-          break;
-        }
+    if (name == ATOM_button) {
+      if (m_nodeStack.hasInScope(ATOM_button)) {
+        generateImpliedEndTags();
+        popStackUntil(ATOM_button);
       }
 
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       m_framesetOk = false;
       return;
     }
 
-    if (name == L"body") {
-      if (m_nodeStack.size() == 1 || m_nodeStack[2]->nodeName != L"body")
+    if (name == ATOM_body) {
+      if (m_nodeStack.size() == 1 || m_nodeStack[1]->localName != ATOM_body)
         return;
 
       // TODO: html body element
       m_framesetOk = false;
-      auto body = std::static_pointer_cast<LibDOM::HTMLElement>(m_nodeStack[2]);
-      for (const auto &attr : tagToken->attributes) {
-        if (body->hasAttribute(attr.name))
+      auto body =
+          LibDOM::static_pointer_cast<LibDOM::HTMLElement>(m_nodeStack[1]);
+      for (const auto &attr : token.attributes) {
+        if (body->attributes.find(attr.atom, attr.name) != nullptr)
           continue;
-        body->setAttribute(attr.name, attr.value);
+        body->attributes.set(attr.atom, LibDOM::DOMString(attr.value),
+                             attr.name);
       }
       return;
     }
 
-    if (name == L"frameset") {
-      throw StringException("TODO: in body: frameset start tag");
+    if (name == ATOM_frameset) {
+      unsupported("TODO: in body: frameset start tag");
+      return;
     }
 
-    if (name == L"a") {
-      // FIXME: If the list of active formatting elements contains an a element
-      // between the end of the list and the last marker on the list (or the
-      // start of the list if there is no marker on the list), then this is a
-      // parse error; run the adoption agency algorithm for the token, then
-      // remove that element from the list of active formatting elements and the
-      // stack of open elements if the adoption agency algorithm didn't already
-      // remove it (it might not have if the element is not in table scope).
+    if (name == ATOM_a) {
+      size_t index = m_activeFormattingElems.findAfterLastMarker(ATOM_a);
+      if (index != FormattingList::NOT_FOUND) {
+        auto element = m_activeFormattingElems[index].element;
+        adoptionAgency(token);
+        // the adoption agency algorithm leaves the element alone if it isn't
+        // in scope
+        index = m_activeFormattingElems.find(element);
+        if (index != FormattingList::NOT_FOUND)
+          m_activeFormattingElems.erase(index);
+        size_t position = m_nodeStack.find(element);
+        if (position != 0)
+          m_nodeStack.erase(m_nodeStack.begin() + position - 1);
+      }
 
       reconstructActiveFormattingElements();
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
-      pushOntoActiveFormattingElems(elem);
+      auto elem = INSERT_HTML_ELEMENT(token);
+      pushActiveFormattingElement(elem);
       return;
     }
 
-    const std::vector<std::wstring> names4 = {
-        L"b", L"big",   L"code",   L"em",     L"font", L"i",
-        L"s", L"small", L"strike", L"strong", L"tt",   L"u"};
-    if (IS_ONE_OF(name, names4)) {
+    if (name == ATOM_nobr) {
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
+      if (m_nodeStack.hasInScope(ATOM_nobr)) {
+        adoptionAgency(token);
+        reconstructActiveFormattingElements();
+      }
+      auto elem = INSERT_HTML_ELEMENT(token);
+      pushActiveFormattingElement(elem);
       return;
     }
 
-    if (name == L"nobr") {
+    // a and nobr are handled above
+    if (FORMATTING_ELEMENTS.contains(name)) {
       reconstructActiveFormattingElements();
-      if (stackHasInScope(L"nobr")) {
-        adoptionAgency(tagToken.get());
-        reconstructActiveFormattingElements();
-      }
-      auto elem = INSERT_HTML_ELEMENT(tagToken);
-      pushOntoActiveFormattingElems(elem);
+      auto elem = INSERT_HTML_ELEMENT(token);
+      pushActiveFormattingElement(elem);
       return;
     }
 
-    if (name == L"applet" || name == L"marquee" || name == L"object") {
+    if (name == ATOM_applet || name == ATOM_marquee || name == ATOM_object) {
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
-      // FIXME: Insert a marker at the end of the list of active formatting
-      // elements.
+      INSERT_HTML_ELEMENT(token);
+      m_activeFormattingElems.insertMarker();
       m_framesetOk = false;
+      return;
     }
 
-    if (name == L"table") {
-      if (document->mode != "quirks" && stackHasInButtonScope(L"p"))
+    if (name == ATOM_table) {
+      if (document->mode != "quirks" &&
+          m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       m_framesetOk = false;
       m_insertionMode = IN_TABLE;
       return;
     }
 
-    if (name == L"area" || name == L"br" || name == L"embed" ||
-        name == L"img" || name == L"keygen" || name == L"wbr") {
+    if (name == ATOM_area || name == ATOM_br || name == ATOM_embed ||
+        name == ATOM_img || name == ATOM_keygen || name == ATOM_wbr) {
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       m_nodeStack.pop_back();
       m_framesetOk = false;
       return;
     }
 
-    if (name == L"input") {
+    if (name == ATOM_input) {
       reconstructActiveFormattingElements();
-      auto elem = std::static_pointer_cast<LibDOM::HTMLElement>(
-          INSERT_HTML_ELEMENT(tagToken));
+      auto elem = LibDOM::static_pointer_cast<LibDOM::HTMLElement>(
+          INSERT_HTML_ELEMENT(token));
       m_nodeStack.pop_back();
-      if (!elem->hasAttribute(L"type") ||
-          wcscasecmp(elem->getAttribute(L"type").c_str(), L"hidden") != 0) {
+      if (!elem->hasAttribute(ATOM_type) ||
+          !elem->getAttribute(ATOM_type).equalsIgnoringASCIICase(L"hidden")) {
         m_framesetOk = false;
       }
       return;
     }
 
-    if (name == L"hr") {
-      if (stackHasInButtonScope(L"p"))
+    if (name == ATOM_hr) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       m_nodeStack.pop_back();
       m_framesetOk = false;
       return;
     }
 
-    if (name == L"image") {
-      tagToken->setName(L"img");
-      process(std::move(tagToken));
+    if (name == ATOM_image) {
+      token.atom = ATOM_img;
+      token.name = LibDOM::atomName(ATOM_img);
+      process(token);
       return;
     }
 
-    if (name == L"textarea") {
-      INSERT_HTML_ELEMENT(tagToken);
+    if (name == ATOM_textarea) {
+      INSERT_HTML_ELEMENT(token);
       // FIXME: If the next token is a U+000A LINE FEED (LF) character token,
       // then ignore that token and move on to the next one. (Newlines at the
       // start of textarea elements are ignored as an authoring convenience.)
-      m_tokenizer.currentState = RCDATA;
+      switchTokenizer(RCDATA);
       m_originalInsertionMode = m_insertionMode;
       m_framesetOk = false;
       m_insertionMode = TEXT;
       return;
     }
 
-    if (name == L"xmp") {
-      if (stackHasInButtonScope(L"p"))
+    if (name == ATOM_xmp) {
+      if (m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE))
         closePElem();
       reconstructActiveFormattingElements();
       m_framesetOk = false;
-      genericRawTextParse(std::move(tagToken));
+      genericRawTextParse(token);
       return;
     }
 
-    if (name == L"iframe") {
+    if (name == ATOM_iframe) {
       m_framesetOk = false;
-      genericRawTextParse(std::move(tagToken));
+      genericRawTextParse(token);
       return;
     }
 
-    if (name == L"noembed" || (name == L"noscript" && m_scriptingFlag)) {
-      genericRawTextParse(std::move(tagToken));
+    if (name == ATOM_noembed || (name == ATOM_noscript && m_scriptingFlag)) {
+      genericRawTextParse(token);
       return;
     }
 
-    if (name == L"select") {
+    if (name == ATOM_select) {
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       m_framesetOk = false;
       if (m_insertionMode == IN_TABLE || m_insertionMode == IN_CAPTION ||
           m_insertionMode == IN_TABLE_BODY || m_insertionMode == IN_ROW ||
@@ -665,176 +893,163 @@ void Parser::inBody(std::unique_ptr<Token> token) {
       return;
     }
 
-    if (name == L"optgroup" || name == L"option") {
-      if (CURRENT_NODE->nodeName == L"option")
+    if (name == ATOM_optgroup || name == ATOM_option) {
+      if (CURRENT_NODE->localName == ATOM_option)
         m_nodeStack.pop_back();
       reconstructActiveFormattingElements();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       return;
     }
 
-    if (name == L"rb" || name == L"rtc") {
-      if (stackHasInScope(L"ruby"))
+    if (name == ATOM_rb || name == ATOM_rtc) {
+      if (m_nodeStack.hasInScope(ATOM_ruby))
         generateImpliedEndTags();
-      INSERT_HTML_ELEMENT(tagToken);
+      INSERT_HTML_ELEMENT(token);
       return;
     }
 
-    if (name == L"rp" || name == L"rt") {
-      if (stackHasInScope(L"ruby"))
-        generateImpliedEndTagsExceptFor(L"rtc");
-      INSERT_HTML_ELEMENT(tagToken);
+    if (name == ATOM_rp || name == ATOM_rt) {
+      if (m_nodeStack.hasInScope(ATOM_ruby))
+        generateImpliedEndTagsExceptFor(ATOM_rtc);
+      INSERT_HTML_ELEMENT(token);
       return;
     }
 
-    if (name == L"math") {
-      throw StringException("TODO: in body: MathML support");
+    if (name == ATOM_math) {
+      unsupported("TODO: in body: MathML support");
+      return;
     }
 
-    if (name == L"SVG") {
-      throw StringException("TODO: in body: SVG support");
+    if (name == ATOM_svg) {
+      unsupported("TODO: in body: SVG support");
+      return;
     }
 
-    const std::vector<std::wstring> names5 = {
-        L"caption", L"col",   L"colgroup", L"frame", L"head", L"tbody",
-        L"td",      L"tfoot", L"th",       L"thead", L"tr"};
-    if (IS_ONE_OF(name, names5)) {
+    if (TABLE_PARTS.contains(name)) {
       return;
     }
 
     reconstructActiveFormattingElements();
-    INSERT_HTML_ELEMENT(tagToken);
+    INSERT_HTML_ELEMENT(token);
     return;
   }
 
-  if (token->type() == END_OF_FILE) {
+  if (token.type == END_OF_FILE) {
     stopParsing();
     return;
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
-    if (tagToken->name() == L"body") {
-      if (std::find_if(m_nodeStack.begin(), m_nodeStack.end(),
-                       [](std::shared_ptr<LibDOM::Node> node) {
-                         return node->nodeName == L"body";
-                       }) == m_nodeStack.end()) {
+  if (token.type == END_TAG) {
+    if (token.atom == ATOM_body) {
+      if (!m_nodeStack.hasInScope(ATOM_body))
         return;
-      }
       m_insertionMode = AFTER_BODY;
       return;
     }
 
-    if (tagToken->name() == L"html") {
-      if (std::find_if(m_nodeStack.begin(), m_nodeStack.end(),
-                       [](std::shared_ptr<LibDOM::Node> node) {
-                         return node->nodeName == L"body";
-                       }) == m_nodeStack.end()) {
+    if (token.atom == ATOM_html) {
+      if (!m_nodeStack.hasInScope(ATOM_body))
         return;
-      }
       m_insertionMode = AFTER_BODY;
-      token = std::move(tagToken);
       REPROCESS;
       return;
     }
 
-    auto name = tagToken->name();
-    const std::vector<std::wstring> names = {
-        L"address", L"article",  L"aside",      L"blockquote", L"button",
-        L"center",  L"details",  L"dialog",     L"dir",        L"div",
-        L"dl",      L"fieldset", L"figcaption", L"figure",     L"footer",
-        L"header",  L"hgroup",   L"listing",    L"main",       L"menu",
-        L"nav",     L"ol",       L"pre",        L"search",     L"section",
-        L"summary", L"ul",
-    };
-    if (IS_ONE_OF(name, names)) {
-      if (!stackHasInScope(name))
+    auto name = token.atom;
+    if (BLOCK_END_TAGS.contains(name)) {
+      if (!m_nodeStack.hasInScope(name))
         return;
       generateImpliedEndTags();
       popStackUntil(name);
       return;
     }
 
-    if (name == L"form") {
+    if (name == ATOM_form) {
       auto node = m_formElementPointer;
       m_formElementPointer = nullptr;
-      if (node == nullptr
-          /* FIXME: or node stack does not have <node> in scope */)
+      if (node == nullptr || !m_nodeStack.hasInScope(node))
         return;
       generateImpliedEndTags();
-      m_nodeStack.erase(
-          std::find(m_nodeStack.begin(), m_nodeStack.end(), node));
+      m_nodeStack.erase(m_nodeStack.begin() + m_nodeStack.find(node) - 1);
       return;
     }
 
-    if (name == L"p") {
-      if (!stackHasInButtonScope(L"p")) {
-        auto newTagToken = std::make_shared<TagToken>(START_TAG);
-        newTagToken->appendName(L"p");
-        INSERT_HTML_ELEMENT(newTagToken);
+    if (name == ATOM_p) {
+      if (!m_nodeStack.hasInScope(ATOM_p, BUTTON_SCOPE)) {
+        INSERT_HTML_ELEMENT(Token::tag(START_TAG, ATOM_p));
       }
       closePElem();
       return;
     }
 
-    if (name == L"li") {
+    if (name == ATOM_li) {
       // FIXME: If the stack of open elements does not have an li element in
       // list item scope, then this is a parse error; ignore the token.
-      generateImpliedEndTagsExceptFor(L"li");
-      throw StringException("TODO: in body: li end tag (too lazy)");
+      generateImpliedEndTagsExceptFor(ATOM_li);
+      unsupported("TODO: in body: li end tag (too lazy)");
+      return;
     }
 
-    if (name == L"dd" || name == L"dt") {
-      if (!stackHasInScope(name))
+    if (name == ATOM_dd || name == ATOM_dt) {
+      if (!m_nodeStack.hasInScope(name))
         return;
       generateImpliedEndTagsExceptFor(name);
-      throw StringException("TODO: in body: dd/dt end tags (too lazy)");
+      unsupported("TODO: in body: dd/dt end tags (too lazy)");
+      return;
     }
 
-    const std::vector<std::wstring> names2 = {L"h1", L"h2", L"h3",
-                                              L"h4", L"h5", L"h6"};
-    if (IS_ONE_OF(name, names2)) {
-      if (!stackHasInScope(name))
+    if (HEADINGS.contains(name)) {
+      if (!m_nodeStack.hasInScope(name))
         return;
       generateImpliedEndTags();
       while (true) {
-        auto name = CURRENT_NODE->nodeName;
+        auto name = CURRENT_NODE->localName;
         m_nodeStack.pop_back();
-        if (IS_ONE_OF(name, names2))
+        if (HEADINGS.contains(name))
           break;
       }
       return;
     }
 
-    const std::vector<std::wstring> names4 = {
-        L"a",    L"b", L"big",   L"code",   L"em",     L"font", L"i",
-        L"nobr", L"s", L"small", L"strike", L"strong", L"tt",   L"u",
-    };
-    if (IS_ONE_OF(name, names4)) {
-      adoptionAgency(tagToken.get());
+    // if there is no formatting element to adopt, the tag is handled like any
+    // other end tag below
+    if (FORMATTING_ELEMENTS.contains(name) && adoptionAgency(token))
       return;
-    }
 
-    if (name == L"applet" || name == L"marquee" || name == L"object") {
-      if (!stackHasInScope(name))
+    if (name == ATOM_applet || name == ATOM_marquee || name == ATOM_object) {
+      if (!m_nodeStack.hasInScope(name))
         return;
       generateImpliedEndTags();
-      throw StringException("TODO: in body: marquee end tag (too lazy)");
+      popStackUntil(name);
+      m_activeFormattingElems.clearUpToLastMarker();
+      return;
     }
 
-    auto node = CURRENT_NODE;
-  loop:
-    if (node->nodeName == tagToken->name()) {
-      generateImpliedEndTagsExceptFor(tagToken->name());
-      while (CURRENT_NODE != node)
-        m_nodeStack.pop_back();
-      m_nodeStack.pop_back();
+    // any other end tag closes the nearest open element with its name, unless
+    // a special element comes before it, in which case "this is a parse error;
+    // ignore the token, and return."
+    if (name == LibDOM::UNINTERNED_ATOM) {
+      // names without an atom of their own all share one, so the stack can't
+      // tell them apart and they are compared as strings
+      for (size_t position = m_nodeStack.size(); position > 0; position--) {
+        const auto &node = m_nodeStack[position - 1];
+        if (node->localName == name &&
+            node->uninternedLocalName == token.name) {
+          generateImpliedEndTags();
+          while (m_nodeStack.size() >= position)
+            m_nodeStack.pop_back();
+          return;
+        }
+        if (SPECIAL_ELEMENTS.contains(node->localName))
+          return;
+      }
       return;
     }
-    // FIXME: Otherwise, if node is in the special category, then this is a
-    // parse error; ignore the token, and return.
-    node = m_nodeStack.end()[-2];
-    goto loop;
+    if (!m_nodeStack.hasInScope(name, SPECIAL_SCOPE))
+      return;
+    generateImpliedEndTagsExceptFor(name);
+    popStackUntil(name);
+    return;
   }
 
   assert(!"unreachable");
@@ -842,22 +1057,20 @@ void Parser::inBody(std::unique_ptr<Token> token) {
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#parsing-main-incdata
  */
-void Parser::text(std::unique_ptr<Token> token) {
-  if (token->type() == CHARACTER) {
-    auto charToken = CONVERT_TO(CharacterToken, token);
-    insertCharacter(std::move(charToken));
+void Parser::text(Token &token) {
+  if (token.type == CHARACTER) {
+    insertCharacter(token.data);
     return;
   }
 
-  if (token->type() == END_OF_FILE) {
+  if (token.type == END_OF_FILE) {
     m_nodeStack.pop_back();
     m_insertionMode = m_originalInsertionMode;
     REPROCESS;
     return;
   }
 
-  if (token->type() == END_TAG) {
-    auto tagToken = CONVERT_TO(TagToken, token);
+  if (token.type == END_TAG) {
     // FIXME: special script handling
     m_nodeStack.pop_back();
     m_insertionMode = m_originalInsertionMode;
@@ -867,15 +1080,75 @@ void Parser::text(std::unique_ptr<Token> token) {
   assert(!"should be unreachable");
 }
 
+/** https://html.spec.whatwg.org/multipage/parsing.html#parsing-main-afterbody */
+void Parser::afterBody(Token &token) {
+  if (token.type == CHARACTER && token.isWhitespace) {
+    inBody(token);
+    return;
+  }
+
+  if (token.type == COMMENT) {
+    insertComment(token, m_nodeStack[0]);
+    return;
+  }
+
+  if (token.type == DOCTYPE_TOKEN)
+    return;
+
+  if (token.type == START_TAG && token.atom == ATOM_html) {
+    inBody(token);
+    return;
+  }
+
+  if (token.type == END_TAG && token.atom == ATOM_html) {
+    if (m_fragmentContext == nullptr)
+      m_insertionMode = AFTER_AFTER_BODY;
+    return;
+  }
+
+  if (token.type == END_OF_FILE) {
+    stopParsing();
+    return;
+  }
+
+  m_insertionMode = IN_BODY;
+  REPROCESS;
+}
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#the-after-after-body-insertion-mode */
+void Parser::afterAfterBody(Token &token) {
+  if (token.type == COMMENT) {
+    insertComment(token, document);
+    return;
+  }
+
+  if (token.type == DOCTYPE_TOKEN ||
+      (token.type == CHARACTER && token.isWhitespace) ||
+      (token.type == START_TAG && token.atom == ATOM_html)) {
+    inBody(token);
+    return;
+  }
+
+  if (token.type == END_OF_FILE) {
+    stopParsing();
+    return;
+  }
+
+  m_insertionMode = IN_BODY;
+  REPROCESS;
+}
+
 #define MODE(mode, func)                                                       \
   case mode:                                                                   \
-    func(std::move(token));                                                    \
+    func(token);                                                               \
     break;
 
-void Parser::process(std::unique_ptr<Token> token) {
-  assert(token != nullptr);
+ParseStatus Parser::process(Token &token) {
+  if (token.type != CHARACTER)
+    flushPendingText();
+
 #if 0
-  std::cout << "emitted token type=" << token->type()
+  std::cout << "emitted token type=" << token.type
             << ", mode=" << m_insertionMode << "\n";
 #endif
   switch (m_insertionMode) {
@@ -886,164 +1159,274 @@ void Parser::process(std::unique_ptr<Token> token) {
     MODE(AFTER_HEAD, afterHead)
     MODE(IN_BODY, inBody)
     MODE(TEXT, text)
-    case AFTER_BODY:
-      // FIXME: implement
-      break;
+    MODE(AFTER_BODY, afterBody)
+    MODE(AFTER_AFTER_BODY, afterAfterBody)
     default:
-      std::wcout << "unknown insertion mode encountered: " << m_insertionMode
-                 << std::endl;
-      throw StringException("unknown insertion mode encountered");
+      unsupported("unknown insertion mode encountered");
+      // the modes that are missing are mostly the table ones, and the in body
+      // rules make the most of their contents
+      if (!m_aborted)
+        inBody(token);
       break;
   }
+  return status();
 }
 
 #undef MODE
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#reset-the-insertion-mode-appropriately */
 void Parser::resetInsertionModeAppropriately() {
-  // TODO: Parser::resetInsertionModeAppropriately
-  throw StringException("TODO: Parser::resetInsertionModeAppropriately");
+  for (size_t i = m_nodeStack.size(); i-- > 0;) {
+    bool last = i == 0;
+    LibDOM::Element *node = m_nodeStack[i].get();
+    if (last && m_fragmentContext != nullptr)
+      node = m_fragmentContext;
+    if (node->namespaceURI != HTML_NAMESPACE) {
+      if (last)
+        break;
+      continue;
+    }
+
+    switch (node->localName) {
+      case ATOM_select:
+        if (!last) {
+          for (size_t j = i; j-- > 0;) {
+            auto ancestor = m_nodeStack[j]->localName;
+            if (ancestor == ATOM_template)
+              break;
+            if (ancestor == ATOM_table) {
+              m_insertionMode = IN_SELECT_IN_TABLE;
+              return;
+            }
+          }
+        }
+        m_insertionMode = IN_SELECT;
+        return;
+      case ATOM_td:
+      case ATOM_th:
+        if (last)
+          break;
+        m_insertionMode = IN_CELL;
+        return;
+      case ATOM_tr:
+        m_insertionMode = IN_ROW;
+        return;
+      case ATOM_tbody:
+      case ATOM_thead:
+      case ATOM_tfoot:
+        m_insertionMode = IN_TABLE_BODY;
+        return;
+      case ATOM_caption:
+        m_insertionMode = IN_CAPTION;
+        return;
+      case ATOM_colgroup:
+        m_insertionMode = IN_COLUMN_GROUP;
+        return;
+      case ATOM_table:
+        m_insertionMode = IN_TABLE;
+        return;
+      case ATOM_template:
+        // FIXME: the current template insertion mode, once there is a stack
+        // of them
+        m_insertionMode = IN_TEMPLATE;
+        return;
+      case ATOM_head:
+        if (last)
+          break;
+        m_insertionMode = IN_HEAD;
+        return;
+      case ATOM_body:
+        m_insertionMode = IN_BODY;
+        return;
+      case ATOM_frameset:
+        m_insertionMode = IN_FRAMESET;
+        return;
+      case ATOM_html:
+        m_insertionMode =
+            m_headElementPointer == nullptr ? BEFORE_HEAD : AFTER_HEAD;
+        return;
+      default:
+        break;
+    }
+    if (last)
+      break;
+  }
+  m_insertionMode = IN_BODY;
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#reconstruct-the-active-formatting-elements */
 void Parser::reconstructActiveFormattingElements() {
-  if (m_activeFormattingElems.empty())
-    return;
-  // FIXME: markers
-  if (std::find(m_nodeStack.begin(), m_nodeStack.end(),
-                m_activeFormattingElems.back()) != m_nodeStack.end()) {
-    return;
+  auto &list = m_activeFormattingElems;
+  // rewind to the last entry that is a marker or still open, then create the
+  // elements of all entries after it
+  size_t index = list.size();
+  while (index > 0 && !list[index - 1].isMarker() &&
+         list.stackPosition(index - 1, m_nodeStack) == 0)
+    index--;
+
+  if (index < list.size())
+    flushPendingText();
+  for (; index < list.size(); index++) {
+    auto newElem = recreateFormattingElement(list[index].element);
+    if (atDepthLimit())
+      m_counters.clampedElements++;
+    insertionParent()->appendChild(newElem);
+    m_nodeStack.push_back(newElem);
+    list.replace(index, newElem, m_nodeStack.size());
   }
+}
 
-  auto entry = m_activeFormattingElems.back();
-rewind:
-  if (entry == m_activeFormattingElems.begin()[0])
-    goto create;
-  entry = std::find(m_activeFormattingElems.begin(),
-                    m_activeFormattingElems.end(), entry)[-1];
-  if (std::find(m_nodeStack.begin(), m_nodeStack.end(), entry) !=
-      m_nodeStack.end())
-    goto rewind;
-
-advance:
-  entry = std::find(m_activeFormattingElems.begin(),
-                    m_activeFormattingElems.end(), entry)[1];
-create:
-  auto tagToken = std::make_shared<TagToken>(START_TAG);
-  tagToken->setName(entry->localName);
-  auto newElem = INSERT_HTML_ELEMENT(tagToken);
-  auto it = std::find(m_activeFormattingElems.begin(),
-                      m_activeFormattingElems.end(), entry);
-  *it = newElem;
-  if (newElem != m_activeFormattingElems.back())
-    goto advance;
+/**
+  The last character of the Text node that `node` ends with, or 0 if it doesn't
+  end with one.
+*/
+static wchar_t lastTextCharacter(const LibDOM::Node &node) {
+  auto *last = node.lastChild();
+  if (last == nullptr || last->nodeType != LibDOM::Node::TEXT_NODE)
+    return 0;
+  const auto &data = static_cast<const LibDOM::Text &>(*last).data;
+  return data.empty() ? 0 : data[data.length() - 1];
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#insert-a-character */
-void Parser::insertCharacter(std::unique_ptr<CharacterToken> token) {
-  auto data = token->character();
-  auto location = CURRENT_NODE;
+void Parser::insertCharacter(std::wstring_view data) {
+  const auto &location = insertionParent();
 
   if (location->nodeType == LibDOM::Node::DOCUMENT_NODE)
     return;
 
-  std::shared_ptr<LibDOM::Text> text;
-  if (!location->childNodes.empty() &&
-      location->childNodes.back()->nodeType == LibDOM::Node::TEXT_NODE) {
-    text = std::static_pointer_cast<LibDOM::Text>(location->childNodes.back());
-  } else {
-    if (isspace(token->character()))
-      return;
-    text = std::shared_ptr<LibDOM::Text>(new LibDOM::Text());
-    location->appendChild(text);
+  if (location != m_pendingTextParent) {
+    flushPendingText();
+    m_pendingTextParent = location;
   }
 
-  if (isspace(token->character())) {
-    if (text->data.back() == L' ')
-      return;
-    text->data += L' ';
+  // whitespace never starts a text node and is collapsed into one space
+  wchar_t last = m_pendingText.empty() ? lastTextCharacter(*location)
+                                       : m_pendingText.back();
+  for (wchar_t c : data) {
+    if (isHTMLWhitespace(c)) {
+      if (last == 0 || last == L' ')
+        continue;
+      c = L' ';
+    }
+    m_pendingText += c;
+    last = c;
+  }
+}
+
+void Parser::flushPendingText() {
+  if (m_pendingText.empty())
+    return;
+
+  auto *last = m_pendingTextParent->lastChild();
+  if (last != nullptr && last->nodeType == LibDOM::Node::TEXT_NODE) {
+    static_cast<LibDOM::Text &>(*last).data += m_pendingText;
   } else {
-    text->data += data;
+    m_pendingTextParent->appendChild(
+        document->createNode<LibDOM::Text>(std::move(m_pendingText)));
+    m_nodeCount++;
   }
+  m_pendingText.clear();
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#insert-a-comment */
-void Parser::insertComment(std::unique_ptr<Token> token,
-                           std::shared_ptr<LibDOM::Node> position) {
-  auto commentToken = CONVERT_TO(CommentToken, token);
-  auto adjustedPos = position == nullptr ? CURRENT_NODE : position;
-  auto comment = std::make_shared<LibDOM::Comment>();
-  comment->data = commentToken->data();
-  comment->ownerDocument = adjustedPos->ownerDocument;
+void Parser::insertComment(Token &token,
+                           LibDOM::RefPtr<LibDOM::Node> position) {
+  LibDOM::Node *adjustedPos =
+      position == nullptr ? CURRENT_NODE.get() : position.get();
+  auto comment = document->createNode<LibDOM::Comment>(token.data);
+  m_nodeCount++;
   adjustedPos->appendChild(comment);
 }
 
 #define LOCAL_DEF(ln, type)                                                    \
   if (localName == ln)                                                         \
-    elem = std::make_shared<type>();
+    elem = document->createNode<type>();
 
 /** https://dom.spec.whatwg.org/#concept-create-element */
-std::shared_ptr<LibDOM::HTMLElement>
-Parser::createElement(std::wstring localName, std::wstring ns,
-                      std::wstring prefix) {
-  std::shared_ptr<LibDOM::HTMLElement> elem = nullptr;
-
-  LOCAL_DEF(L"html", LibDOM::HTMLHtmlElement)
-  LOCAL_DEF(L"head", LibDOM::HTMLHeadElement)
-  if (elem == nullptr) {
-    std::wclog << L"WARNING: using default HTMLElement for localName "
-               << localName << L"\n";
-    elem = std::make_shared<LibDOM::HTMLElement>();
-  }
+LibDOM::RefPtr<LibDOM::HTMLElement>
+Parser::createElement(LibDOM::Atom localName, LibDOM::Atom ns,
+                      LibDOM::Atom prefix) {
+  LibDOM::RefPtr<LibDOM::HTMLElement> elem = nullptr;
+
+  LOCAL_DEF(ATOM_html, LibDOM::HTMLHtmlElement)
+  LOCAL_DEF(ATOM_head, LibDOM::HTMLHeadElement)
+  if (elem == nullptr)
+    elem = document->createNode<LibDOM::HTMLElement>();
 
   elem->namespaceURI = ns;
   elem->prefix = prefix;
   elem->localName = localName;
-  elem->nodeName = localName;
-  elem->ownerDocument = document;
+  m_nodeCount++;
   return elem;
 }
 
 #undef LOCAL_DEF
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#create-an-element-for-the-token */
-std::shared_ptr<LibDOM::Element>
-Parser::createElementForToken(TagToken *token, std::wstring ns,
-                              std::shared_ptr<LibDOM::Node> intendedParent) {
+LibDOM::RefPtr<LibDOM::Element>
+Parser::createElementForToken(const Token &token, LibDOM::Atom ns,
+                              LibDOM::RefPtr<LibDOM::Node> intendedParent) {
   (void)intendedParent;
-  auto elem = createElement(token->name(), ns);
-  for (const auto &attr : token->attributes) {
-    auto attribute = std::make_shared<LibDOM::Attr>();
-    attribute->name = attr.name;
-    attribute->value = attr.value;
-    elem->attributes.setNamedItem(attribute);
-  }
+  auto elem = createElement(token.atom, ns);
+  if (token.atom == LibDOM::UNINTERNED_ATOM)
+    elem->uninternedLocalName = token.name;
+  for (const auto &attr : token.attributes)
+    elem->attributes.set(attr.atom, LibDOM::DOMString(attr.value), attr.name);
   return elem;
 }
 
-std::shared_ptr<LibDOM::Element>
-Parser::insertForeignElement(TagToken *token, std::wstring ns,
+LibDOM::RefPtr<LibDOM::Element>
+Parser::insertForeignElement(const Token &token, LibDOM::Atom ns,
                              bool onlyAddToElementStack) {
-  auto insertLocation = CURRENT_NODE;
+  flushPendingText();
+  auto insertLocation = insertionParent();
   auto elem = createElementForToken(token, ns, insertLocation);
-  if (!onlyAddToElementStack)
+  if (!onlyAddToElementStack) {
+    if (atDepthLimit())
+      m_counters.clampedElements++;
     insertLocation->appendChild(elem);
+  }
   m_nodeStack.push_back(elem);
   return elem;
 }
 
+bool Parser::atDepthLimit() const {
+  return m_limits.maxDepth != 0 && m_nodeStack.size() >= m_limits.maxDepth;
+}
+
+const LibDOM::RefPtr<LibDOM::Element> &Parser::insertionParent() const {
+  if (!atDepthLimit())
+    return CURRENT_NODE;
+  // this is the parent of an element as deep as the limit allows, or an
+  // element that took the place of one, so what goes in it is never deeper
+  return m_nodeStack[std::max<size_t>(m_limits.maxDepth, 2) - 2];
+}
+
+void Parser::pushActiveFormattingElement(
+    const LibDOM::RefPtr<LibDOM::Element> &element) {
+  if (m_activeFormattingElems.push(element, m_nodeStack.size(),
+                                   m_limits.maxDepth))
+    m_counters.droppedFormattingElements++;
+}
+
+void Parser::switchTokenizer(TokenizerState state) {
+  m_tokenizer.currentState = state;
+  m_switchedTo = state;
+}
+
 /** https://html.spec.whatwg.org/multipage/parsing.html#generic-raw-text-element-parsing-algorithm */
-void Parser::genericRawTextParse(std::unique_ptr<TagToken> token) {
+void Parser::genericRawTextParse(Token &token) {
   INSERT_HTML_ELEMENT(token);
-  m_tokenizer.currentState = RAWTEXT;
+  switchTokenizer(RAWTEXT);
   m_originalInsertionMode = m_insertionMode;
   m_insertionMode = TEXT;
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#generic-rcdata-element-parsing-algorithm */
-void Parser::genericRcdataParse(std::unique_ptr<TagToken> token) {
+void Parser::genericRcdataParse(Token &token) {
   INSERT_HTML_ELEMENT(token);
-  m_tokenizer.currentState = RCDATA;
+  switchTokenizer(RCDATA);
   m_originalInsertionMode = m_insertionMode;
   m_insertionMode = TEXT;
 }
@@ -1054,35 +1437,26 @@ void Parser::stopParsing() {
   m_insertionMode = UNDEFINED_MODE;
   // update document readiness to interactive
   m_nodeStack.clear();
+  // nothing is inserted from here on, so the nodes the parser kept for that
+  // can go with the document
+  flushPendingText();
+  m_pendingTextParent = nullptr;
+  m_activeFormattingElems.clear();
+  m_headElementPointer = nullptr;
+  m_formElementPointer = nullptr;
   // do script stuff
 }
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#generate-implied-end-tags */
 void Parser::generateImpliedEndTags() {
-  const std::vector<std::wstring> endTags = {
-      L"dd", L"dt", L"li", L"optgroup", L"option",
-      L"p",  L"rb", L"rp", L"rt",       L"rtc"};
-  while (true) {
-    auto name = CURRENT_NODE->nodeName;
-    if (std::find(endTags.begin(), endTags.end(), name) == endTags.end())
-      return;
+  while (IMPLIED_END_TAG_ELEMENTS.contains(CURRENT_NODE->localName))
     m_nodeStack.pop_back();
-  }
 }
 
-void Parser::generateImpliedEndTagsExceptFor(std::wstring tagName) {
-  (void)tagName;
-  // TODO: Parser::generateImpliedEndTagsExceptFor
-  const std::vector<std::wstring> endTags = {
-      L"dd", L"dt", L"li", L"optgroup", L"option",
-      L"p",  L"rb", L"rp", L"rt",       L"rtc"};
+void Parser::generateImpliedEndTagsExceptFor(LibDOM::Atom tagName) {
   while (true) {
-    auto name = CURRENT_NODE->nodeName;
-    auto it = std::find_if(endTags.begin(), endTags.end(),
-                           [tagName, name](std::wstring otherName) {
-                             return tagName != otherName && name == otherName;
-                           });
-    if (it == endTags.end())
+    auto name = CURRENT_NODE->localName;
+    if (name == tagName || !IMPLIED_END_TAG_ELEMENTS.contains(name))
       return;
     m_nodeStack.pop_back();
   }
@@ -1090,153 +1464,150 @@ void Parser::generateImpliedEndTagsExceptFor(std::wstring tagName) {
 
 /** https://html.spec.whatwg.org/multipage/parsing.html#close-a-p-element */
 void Parser::closePElem() {
-  generateImpliedEndTagsExceptFor(L"p");
-  popStackUntil(L"p");
+  generateImpliedEndTagsExceptFor(ATOM_p);
+  popStackUntil(ATOM_p);
 }
 
-/** https://html.spec.whatwg.org/multipage/parsing.html#push-onto-the-list-of-active-formatting-elements */
-void Parser::pushOntoActiveFormattingElems(
-    std::shared_ptr<LibDOM::Element> node) {
-  (void)node;
-  // FIXME: markers
-  int count = 0;
-  auto it = m_activeFormattingElems.end();
-  for (const auto &item : m_activeFormattingElems) {
-    if (item->nodeName == node->nodeName &&
-        item->namespaceURI == node->namespaceURI
-        /* FIXME: attribute check */) {
-      count++;
-      if (count == 3) {
-        it = std::find(m_activeFormattingElems.begin(),
-                       m_activeFormattingElems.end(), item);
-        break;
-      }
-    }
-  }
-
-  if (it != m_activeFormattingElems.end()) {
-    m_activeFormattingElems.erase(it);
-  }
-
-  m_activeFormattingElems.push_back(node);
+LibDOM::RefPtr<LibDOM::Element>
+Parser::recreateFormattingElement(
+    const LibDOM::RefPtr<LibDOM::Element> &element) {
+  auto elem = createElement(element->localName, element->namespaceURI);
+  for (const auto &attribute : element->attributes)
+    elem->attributes.append(attribute);
+  return elem;
 }
 
-/** https://html.spec.whatwg.org/multipage/parsing.html#has-an-element-in-scope
+/** https://html.spec.whatwg.org/multipage/parsing.html#adoption-agency-algorithm
  */
-bool Parser::isInScope(std::shared_ptr<LibDOM::Element> targetNode) {
-  auto node = CURRENT_NODE;
-  const std::vector<std::wstring> scope = {
-      L"applet", L"caption", L"html",   L"table",    L"td",
-      L"th",     L"marquee", L"object", L"template",
-  };
-  // TODO: add MathML and SVG scopes
-step2:
-  if (node == targetNode)
-    return true;
-  auto name = node->nodeName;
-  if (IS_ONE_OF(name, scope))
-    return false;
-  node = std::find(m_nodeStack.begin(), m_nodeStack.end(), node)[-1];
-  goto step2;
-}
-
-bool Parser::isInButtonScope(std::shared_ptr<LibDOM::Element> targetNode) {
-  auto node = CURRENT_NODE;
-  const std::vector<std::wstring> scope = {
-      L"applet", L"caption", L"html",   L"table",    L"td",
-      L"th",     L"marquee", L"object", L"template", L"button",
-  };
-  // TODO: add MathML and SVG scopes
-step2:
-  if (node == targetNode)
+bool Parser::adoptionAgency(Token &token) {
+  auto &list = m_activeFormattingElems;
+  auto subject = token.atom;
+  if (CURRENT_NODE->localName == subject &&
+      CURRENT_NODE->namespaceURI == HTML_NAMESPACE &&
+      !list.contains(CURRENT_NODE)) {
+    m_nodeStack.pop_back();
     return true;
-  auto name = node->nodeName;
-  if (IS_ONE_OF(name, scope))
-    return false;
-  node = std::find(m_nodeStack.begin(), m_nodeStack.end(), node)[-1];
-  goto step2;
-}
-
-bool Parser::stackHasInScope(std::wstring tagName) {
-  for (auto elem : m_nodeStack) {
-    if (elem->nodeName == tagName && isInScope(elem)) {
-      return true;
-    }
   }
-  return false;
-}
 
-bool Parser::stackHasInButtonScope(std::wstring tagName) {
-  for (auto elem : m_nodeStack) {
-    if (elem->nodeName == tagName && isInButtonScope(elem)) {
+  // the loop bounds are the spec's, and keep the work that one misnested end
+  // tag can cause proportional to the elements it actually moves
+  for (int outerLoopCounter = 0; outerLoopCounter < 8; outerLoopCounter++) {
+    size_t formattingIndex = list.findAfterLastMarker(subject);
+    if (formattingIndex == FormattingList::NOT_FOUND)
+      return false;
+    auto formattingElement = list[formattingIndex].element;
+    size_t formattingPosition =
+        list.stackPosition(formattingIndex, m_nodeStack);
+    if (formattingPosition == 0) {
+      list.erase(formattingIndex);
       return true;
     }
-  }
-  return false;
-}
-
-/** https://html.spec.whatwg.org/multipage/parsing.html#adoption-agency-algorithm
- */
-void Parser::adoptionAgency(TagToken *token) {
-  auto subject = token->name();
-  auto it = std::find(m_activeFormattingElems.begin(),
-                      m_activeFormattingElems.end(), CURRENT_NODE);
-  if (CURRENT_NODE->localName == subject &&
-      CURRENT_NODE->namespaceURI == NS_HTML &&
-      it == m_activeFormattingElems.end()) {
-    m_nodeStack.pop_back();
-    return;
-  }
+    if (!m_nodeStack.hasInScope(formattingElement))
+      return true;
 
-  size_t outerLoopCounter = 0;
-  while (true) {
-    if (outerLoopCounter >= 8)
-      return;
-    outerLoopCounter++;
-    std::shared_ptr<LibDOM::Element> formattingElement;
-    // FIXME: markers
-    for (int i = m_activeFormattingElems.size() - 1; i >= 0; i--) {
-      if (m_activeFormattingElems[i]->localName == subject) {
-        formattingElement = m_activeFormattingElems[i];
+    // "Let furthestBlock be the topmost node in the stack of open elements
+    // that is lower in the stack than formattingElement, and is an element in
+    // the special category."
+    size_t furthestBlockPosition = 0;
+    for (size_t position = formattingPosition + 1;
+         position <= m_nodeStack.size(); position++) {
+      if (SPECIAL_ELEMENTS.contains(m_nodeStack[position - 1]->localName)) {
+        furthestBlockPosition = position;
         break;
       }
     }
-    if (std::find(m_nodeStack.begin(), m_nodeStack.end(), formattingElement) ==
-        m_nodeStack.end()) {
-      m_activeFormattingElems.erase(std::find(m_activeFormattingElems.begin(),
-                                              m_activeFormattingElems.end(),
-                                              formattingElement));
-      return;
-    } else if (!isInScope(formattingElement)) {
-      return;
+    if (furthestBlockPosition == 0) {
+      while (m_nodeStack.size() >= formattingPosition)
+        m_nodeStack.pop_back();
+      list.erase(formattingIndex);
+      return true;
     }
-    // FIXME: Let furthestBlock be the topmost node in the stack of open
-    // elements that is lower in the stack than formattingElement, and is an
-    // element in the special category. There might not be one.
-    // note: for now I'm assuming there is no furthest block
-    while (CURRENT_NODE != formattingElement)
+
+    auto commonAncestor = m_nodeStack[formattingPosition - 2];
+    auto furthestBlock = m_nodeStack[furthestBlockPosition - 1];
+    // where the new formatting element goes in the list, kept up to date as
+    // entries before it are erased
+    size_t bookmark = formattingIndex;
+
+    // the open elements from formattingElement down are taken off the stack
+    // and put back once they have been rearranged, rather than relinking the
+    // stack for every element the inner loop removes
+    std::vector<LibDOM::RefPtr<LibDOM::Element>> open(
+        m_nodeStack.begin() + formattingPosition - 1, m_nodeStack.end());
+    while (m_nodeStack.size() >= formattingPosition)
       m_nodeStack.pop_back();
-    m_nodeStack.pop_back();
+    size_t furthestBlockIndex = furthestBlockPosition - formattingPosition;
+
+    size_t nodeIndex = furthestBlockIndex;
+    auto lastNode = furthestBlock;
+    for (int innerLoopCounter = 1;; innerLoopCounter++) {
+      // formattingElement is at the start, so the element above a removed
+      // node is the one before where it was as well
+      nodeIndex--;
+      if (nodeIndex == 0)
+        break;
+      auto node = open[nodeIndex];
+      size_t entry = list.find(node);
+      if (innerLoopCounter > 3 && entry != FormattingList::NOT_FOUND) {
+        list.erase(entry);
+        if (entry < bookmark)
+          bookmark--;
+        entry = FormattingList::NOT_FOUND;
+      }
+      if (entry == FormattingList::NOT_FOUND) {
+        open.erase(open.begin() + nodeIndex);
+        furthestBlockIndex--;
+        continue;
+      }
+
+      node = recreateFormattingElement(node);
+      list.replace(entry, node);
+      open[nodeIndex] = node;
+      if (lastNode == furthestBlock)
+        bookmark = entry + 1;
+      node->appendChild(lastNode);
+      lastNode = node;
+    }
+
+    // FIXME: foster parent lastNode if commonAncestor is a table, tbody,
+    // tfoot, thead or tr element
+    commonAncestor->appendChild(lastNode);
+
+    auto newElem = recreateFormattingElement(formattingElement);
+    newElem->appendChildrenOf(*furthestBlock);
+    furthestBlock->appendChild(newElem);
+
+    size_t entry = list.find(formattingElement);
+    list.erase(entry);
+    if (entry < bookmark)
+      bookmark--;
+    list.insert(bookmark, newElem);
+
+    open.erase(open.begin());
+    furthestBlockIndex--;
+    open.insert(open.begin() + furthestBlockIndex + 1, newElem);
+    for (auto &element : open)
+      m_nodeStack.push_back(std::move(element));
   }
+  return true;
 }
 
-void Parser::popStackUntil(std::wstring tagName) {
+void Parser::popStackUntil(LibDOM::Atom tagName) {
   // check if tag is in stack before going nuclear
-  if (std::find_if(m_nodeStack.begin(), m_nodeStack.end(),
-                   [tagName](std::shared_ptr<LibDOM::Node> node) {
-                     return node->nodeName == tagName;
-                   }) == m_nodeStack.end()) {
-    std::wclog << "WARNING: attempted to pop '" << tagName
-               << "' from the stack but it's not there" << std::endl;
-    std::wclog << "stack view:\n";
+  if (!m_nodeStack.contains(tagName)) {
+    if (warnings == nullptr)
+      return;
+    *warnings << "WARNING: attempted to pop '" << LibDOM::atomName(tagName)
+              << "' from the stack but it's not there" << std::endl;
+    *warnings << "stack view:\n";
     for (const auto &item : m_nodeStack) {
-      std::wclog << " - " << item->internalName().c_str() << " "
-                 << item->nodeName << "\n";
+      *warnings << " - " << item->internalName().c_str() << " "
+                << item->nodeName().toWString() << "\n";
     }
     return;
   }
   while (true) {
-    auto name = CURRENT_NODE->nodeName;
+    auto name = CURRENT_NODE->localName;
     // if the current node is the element to pop until, pop it and return
     if (name == tagName) {
       m_nodeStack.pop_back();
@@ -0,0 +1,130 @@
+#include "libhtml/parserpool.h"
+#include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace LibHTML {
+
+ParserPool::ParserPool(size_t threadCount) {
+  if (threadCount == 0)
+    threadCount = std::thread::hardware_concurrency();
+  if (threadCount == 0)
+    threadCount = 1;
+  for (size_t i = 0; i < threadCount; i++)
+    m_queues.push_back(std::make_unique<Queue>());
+  for (size_t i = 0; i < threadCount; i++)
+    m_threads.emplace_back(&ParserPool::work, this, i);
+}
+
+ParserPool::~ParserPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_started.notify_all();
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+std::vector<ParserPool::Result>
+ParserPool::parse(const std::vector<std::string_view> &documents) {
+  std::vector<Result> results(documents.size());
+  if (documents.empty())
+    return results;
+
+  std::lock_guard<std::mutex> parseLock(m_parseMutex);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_documents = &documents;
+    m_results = &results;
+    m_remaining = documents.size();
+  }
+  // contiguous runs, so that workers only contend when they steal
+  size_t perQueue = (documents.size() + m_queues.size() - 1) / m_queues.size();
+  for (size_t i = 0; i < m_queues.size(); i++) {
+    std::lock_guard<std::mutex> lock(m_queues[i]->mutex);
+    for (size_t job = i * perQueue;
+         job < documents.size() && job < (i + 1) * perQueue; job++)
+      m_queues[i]->jobs.push_back(job);
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_batch++;
+  m_started.notify_all();
+  m_finished.wait(lock, [this] { return m_remaining == 0; });
+  m_documents = nullptr;
+  m_results = nullptr;
+  return results;
+}
+
+bool ParserPool::take(size_t worker, size_t &job) {
+  {
+    auto &own = *m_queues[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = own.jobs.front();
+      own.jobs.pop_front();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < m_queues.size(); i++) {
+    auto &victim = *m_queues[(worker + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      job = victim.jobs.back();
+      victim.jobs.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParserPool::finishJob() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (--m_remaining == 0)
+    m_finished.notify_all();
+}
+
+void ParserPool::work(size_t worker) {
+  size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_started.wait(lock, [&] { return m_stopping || m_batch != seen; });
+      if (m_stopping)
+        return;
+      seen = m_batch;
+    }
+
+    // the batch can't change before the job that was taken is finished, and
+    // taking it orders this after parse() set the batch up
+    size_t job;
+    while (take(worker, job)) {
+      // the parser holds on to some of the nodes, whose counts aren't atomic,
+      // so it has to be gone before the caller can have the document
+      {
+        auto input = (*m_documents)[job];
+        Parser parser;
+        parser.recoveryMode = recoveryMode;
+        parser.setLimits(limits);
+        ParseStatus status = parser.parse(input.data(), input.size());
+        if (status == PARSE_OK)
+          status = parser.finish();
+        auto &result = (*m_results)[job];
+        result.document = std::move(parser.document);
+        result.status = status;
+        result.error = parser.error();
+        result.limitCounters = parser.limitCounters();
+      }
+      finishJob();
+    }
+  }
+}
+
+} // namespace LibHTML
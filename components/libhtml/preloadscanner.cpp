@@ -0,0 +1,215 @@
+#include "libhtml/preloadscanner.h"
+#include "libdom/atom.h"
+#include "libhtml/fetchqueue.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokens.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace LibHTML {
+
+using namespace LibDOM::Atoms;
+
+static std::wstring_view trim(std::wstring_view s) {
+  while (!s.empty() && isHTMLWhitespace(s.front()))
+    s.remove_prefix(1);
+  while (!s.empty() && isHTMLWhitespace(s.back()))
+    s.remove_suffix(1);
+  return s;
+}
+
+static bool equalsIgnoringASCIICase(std::wstring_view s,
+                                    std::wstring_view lowercase) {
+  if (s.size() != lowercase.size())
+    return false;
+  for (size_t i = 0; i < s.size(); i++) {
+    wchar_t c = s[i];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    if (c != lowercase[i])
+      return false;
+  }
+  return true;
+}
+
+/** Whether a space separated list like rel holds `keyword`. */
+static bool hasKeyword(std::wstring_view list, std::wstring_view keyword) {
+  size_t start = 0;
+  while (start < list.size()) {
+    if (isHTMLWhitespace(list[start])) {
+      start++;
+      continue;
+    }
+    size_t end = start;
+    while (end < list.size() && !isHTMLWhitespace(list[end]))
+      end++;
+    if (equalsIgnoringASCIICase(list.substr(start, end - start), keyword))
+      return true;
+    start = end;
+  }
+  return false;
+}
+
+static const Attribute *findAttribute(const Token &token, LibDOM::Atom name) {
+  for (const auto &attr : token.attributes) {
+    if (attr.atom == name)
+      return &attr;
+  }
+  return nullptr;
+}
+
+std::wstring_view pickSrcsetCandidate(std::wstring_view srcset) {
+  std::wstring_view first;
+  size_t position = 0;
+  while (position < srcset.size()) {
+    // skip the whitespace and commas between candidates
+    while (position < srcset.size() &&
+           (isHTMLWhitespace(srcset[position]) || srcset[position] == ','))
+      position++;
+    if (position == srcset.size())
+      break;
+
+    size_t urlStart = position;
+    while (position < srcset.size() && !isHTMLWhitespace(srcset[position]))
+      position++;
+    auto url = srcset.substr(urlStart, position - urlStart);
+
+    // a URL that ends in commas has no descriptors
+    std::wstring_view descriptors;
+    if (url.back() == ',') {
+      while (!url.empty() && url.back() == ',')
+        url.remove_suffix(1);
+    } else {
+      size_t descriptorStart = position;
+      while (position < srcset.size() && srcset[position] != ',')
+        position++;
+      descriptors =
+          trim(srcset.substr(descriptorStart, position - descriptorStart));
+    }
+    if (url.empty())
+      continue;
+
+    if (descriptors.empty() || equalsIgnoringASCIICase(descriptors, L"1x"))
+      return url;
+    if (first.empty())
+      first = url;
+  }
+  return first;
+}
+
+PreloadScanner::PreloadScanner(FetchQueue &queue, bool scripting)
+    : m_queue(queue), m_scripting(scripting) {}
+
+void PreloadScanner::scan(const char *input, size_t size) {
+  m_tokenizer.feed(input, size);
+  run();
+}
+
+void PreloadScanner::finish() {
+  m_tokenizer.finish();
+  run();
+}
+
+void PreloadScanner::run() {
+  while (true) {
+    Token *token = m_tokenizer.next();
+    if (token == nullptr) {
+      // a guess is all that's needed, so carry on past what isn't supported
+      if (m_tokenizer.error() == nullptr)
+        break;
+      m_tokenizer.recover();
+      continue;
+    }
+    if (token->type != START_TAG)
+      continue;
+    startTag(*token);
+    TokenizerState state = textStateAfter(token->atom, m_scripting);
+    if (state != UNDEFINED_STATE)
+      m_tokenizer.currentState = state;
+  }
+}
+
+void PreloadScanner::request(std::wstring_view url, FetchType type,
+                             FetchPriority priority) {
+  url = trim(url);
+  if (url.empty())
+    return;
+  m_queue.push({std::wstring(url), type, priority});
+}
+
+void PreloadScanner::startTag(const Token &token) {
+  switch (token.atom) {
+    case ATOM_base: {
+      auto *href = findAttribute(token, ATOM_href);
+      if (href != nullptr && !m_sawBase) {
+        m_baseURL = trim(href->value);
+        m_sawBase = true;
+      }
+      break;
+    }
+
+    case ATOM_link: {
+      auto *rel = findAttribute(token, ATOM_rel);
+      auto *href = findAttribute(token, ATOM_href);
+      if (rel == nullptr || href == nullptr)
+        break;
+      if (hasKeyword(rel->value, L"stylesheet")) {
+        // alternate stylesheets aren't applied until chosen
+        if (!hasKeyword(rel->value, L"alternate"))
+          request(href->value, FETCH_STYLESHEET, PRIORITY_HIGH);
+        break;
+      }
+      if (!hasKeyword(rel->value, L"preload"))
+        break;
+      auto *as = findAttribute(token, ATOM_as);
+      std::wstring_view destination = as != nullptr ? trim(as->value) : L"";
+      if (equalsIgnoringASCIICase(destination, L"style"))
+        request(href->value, FETCH_STYLESHEET, PRIORITY_HIGH);
+      else if (equalsIgnoringASCIICase(destination, L"font"))
+        request(href->value, FETCH_FONT, PRIORITY_HIGH);
+      else if (equalsIgnoringASCIICase(destination, L"script"))
+        request(href->value, FETCH_SCRIPT, PRIORITY_MEDIUM);
+      else if (equalsIgnoringASCIICase(destination, L"image"))
+        request(href->value, FETCH_IMAGE, PRIORITY_LOW);
+      else
+        request(href->value, FETCH_OTHER, PRIORITY_MEDIUM);
+      break;
+    }
+
+    case ATOM_script: {
+      auto *src = findAttribute(token, ATOM_src);
+      if (src == nullptr)
+        break;
+      // module scripts are deferred unless they are async
+      auto *type = findAttribute(token, ATOM_type);
+      bool blocking =
+          findAttribute(token, ATOM_async) == nullptr &&
+          findAttribute(token, ATOM_defer) == nullptr &&
+          (type == nullptr ||
+           !equalsIgnoringASCIICase(trim(type->value), L"module"));
+      request(src->value, FETCH_SCRIPT,
+              blocking ? PRIORITY_HIGH : PRIORITY_MEDIUM);
+      break;
+    }
+
+    case ATOM_img: {
+      auto *srcset = findAttribute(token, ATOM_srcset);
+      std::wstring_view url;
+      if (srcset != nullptr)
+        url = pickSrcsetCandidate(srcset->value);
+      if (url.empty()) {
+        auto *src = findAttribute(token, ATOM_src);
+        if (src != nullptr)
+          url = src->value;
+      }
+      request(url, FETCH_IMAGE, PRIORITY_LOW);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+} // namespace LibHTML
@@ -0,0 +1,146 @@
+#include "libhtml/scanner.h"
+#include <atomic>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIBHTML_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace LibHTML {
+
+static size_t scanScalar(const char *data, size_t length,
+                         bool stopAtAmpersand) {
+  for (size_t i = 0; i < length; i++) {
+    char c = data[i];
+    if (c == '<' || c == 0 || c == '\r' || (stopAtAmpersand && c == '&'))
+      return i;
+  }
+  return length;
+}
+
+#ifdef LIBHTML_SCANNER_X86
+
+// The input is UTF-8, so each vector lane holds one byte. None of the
+// sentinels can show up inside a multibyte sequence, which only uses bytes
+// >= 0x80. When '&' isn't a sentinel we compare against '<' twice instead of
+// branching inside the loop.
+
+__attribute__((target("sse2"))) static size_t
+scanSSE2(const char *data, size_t length, bool stopAtAmpersand) {
+  const __m128i lt = _mm_set1_epi8('<');
+  const __m128i amp = _mm_set1_epi8(stopAtAmpersand ? '&' : '<');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(&data[i]));
+    __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chars, lt), _mm_cmpeq_epi8(chars, amp)),
+        _mm_or_si128(_mm_cmpeq_epi8(chars, cr), _mm_cmpeq_epi8(chars, zero)));
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0)
+      return i + __builtin_ctz(mask);
+  }
+  return i + scanScalar(&data[i], length - i, stopAtAmpersand);
+}
+
+__attribute__((target("avx2"))) static size_t
+scanAVX2(const char *data, size_t length, bool stopAtAmpersand) {
+  const __m256i lt = _mm256_set1_epi8('<');
+  const __m256i amp = _mm256_set1_epi8(stopAtAmpersand ? '&' : '<');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i zero = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i chars =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&data[i]));
+    __m256i hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chars, lt),
+                        _mm256_cmpeq_epi8(chars, amp)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chars, cr),
+                        _mm256_cmpeq_epi8(chars, zero)));
+    unsigned mask = _mm256_movemask_epi8(hits);
+    if (mask != 0)
+      return i + __builtin_ctz(mask);
+  }
+  return i + scanSSE2(&data[i], length - i, stopAtAmpersand);
+}
+
+#endif
+
+typedef size_t (*ScanFunction)(const char *, size_t, bool);
+
+static bool isSupported(ScannerImpl impl) {
+  switch (impl) {
+    case SCANNER_SCALAR:
+      return true;
+#ifdef LIBHTML_SCANNER_X86
+    case SCANNER_SSE2:
+      return __builtin_cpu_supports("sse2");
+    case SCANNER_AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+static ScanFunction functionFor(ScannerImpl impl) {
+  switch (impl) {
+#ifdef LIBHTML_SCANNER_X86
+    case SCANNER_SSE2:
+      return scanSSE2;
+    case SCANNER_AVX2:
+      return scanAVX2;
+#endif
+    default:
+      return scanScalar;
+  }
+}
+
+static ScannerImpl detectBestImpl() {
+#ifdef LIBHTML_SCANNER_X86
+  // we may run before the runtime has set up the CPU model
+  __builtin_cpu_init();
+#endif
+  if (isSupported(SCANNER_AVX2))
+    return SCANNER_AVX2;
+  if (isSupported(SCANNER_SSE2))
+    return SCANNER_SSE2;
+  return SCANNER_SCALAR;
+}
+
+// function-local statics so that the tokenizer can be used from other static
+// initializers, and atomics because tokenizers on other threads read them
+// while setScannerImpl() changes them
+static std::atomic<ScannerImpl> &currentImpl() {
+  static std::atomic<ScannerImpl> impl{detectBestImpl()};
+  return impl;
+}
+
+static std::atomic<ScanFunction> &currentScan() {
+  static std::atomic<ScanFunction> scan{functionFor(currentImpl().load())};
+  return scan;
+}
+
+size_t findTextSentinel(const char *data, size_t length,
+                        bool stopAtAmpersand) {
+  return currentScan().load(std::memory_order_relaxed)(data, length,
+                                                       stopAtAmpersand);
+}
+
+ScannerImpl scannerImpl() { return currentImpl().load(); }
+
+bool setScannerImpl(ScannerImpl impl) {
+  if (!isSupported(impl))
+    return false;
+  currentImpl().store(impl);
+  currentScan().store(functionFor(impl));
+  return true;
+}
+
+} // namespace LibHTML
@@ -0,0 +1,86 @@
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include "testing.h"
+#include <chrono>
+#include <string>
+
+// Parsing in slices, with the parser pausing whenever its budget runs out,
+// has to build the same document as parsing all of the input at once.
+
+/** Parses `document` in slices of `budget`, and counts the pauses. */
+static std::wstring parseSliced(const std::string &document,
+                                LibHTML::ParseBudget budget, size_t &pauses) {
+  LibHTML::Parser parser;
+  pauses = 0;
+  auto status = parser.parse(document.c_str(), document.size(), budget);
+  while (status == LibHTML::PARSE_PAUSED) {
+    pauses++;
+    status = parser.resume(budget);
+  }
+  if (status == LibHTML::PARSE_OK)
+    status = parser.finish(budget);
+  while (status == LibHTML::PARSE_PAUSED) {
+    pauses++;
+    status = parser.resume(budget);
+  }
+  check(status == LibHTML::PARSE_STOPPED, "sliced parsing gets to the end");
+  return serialize(*parser.document);
+}
+
+int main() {
+  std::string document = "<!DOCTYPE html><html><head><title>slices</title>"
+                         "</head><body>";
+  for (int i = 0; i < 1000; i++) {
+    document += "<p>a paragraph with <b>bold <i>and</b> misnested</i> text "
+                "&amp; a reference";
+  }
+
+  LibHTML::Parser whole;
+  whole.parse(document.c_str(), document.size());
+  whole.finish();
+  auto expected = serialize(*whole.document);
+
+  size_t pauses = 0;
+  LibHTML::ParseBudget tokens;
+  tokens.tokens = 10;
+  check(parseSliced(document, tokens, pauses) == expected,
+        "slices of ten tokens build the same document");
+  check(pauses > 1000, "the parser pauses after every ten tokens");
+
+  // a deadline that has already passed still lets a few tokens through, so
+  // that parsing gets somewhere
+  LibHTML::ParseBudget passed;
+  passed.deadline = std::chrono::steady_clock::now();
+  check(parseSliced(document, passed, pauses) == expected,
+        "slices with a passed deadline build the same document");
+  check(pauses > 0, "the parser pauses at a passed deadline");
+
+  LibHTML::ParseBudget unlimited;
+  check(parseSliced(document, unlimited, pauses) == expected && pauses == 0,
+        "no budget means no pauses");
+
+  // the next chunk finishes the paused one first
+  std::string first = "<!DOCTYPE html><p>one<p>two<p>three";
+  std::string second = "<p>four";
+  LibHTML::ParseBudget few;
+  few.tokens = 3;
+  LibHTML::Parser parser;
+  check(parser.parse(first.c_str(), first.size(), few) ==
+            LibHTML::PARSE_PAUSED,
+        "the parser pauses within a chunk");
+  check(parser.parse(second.c_str(), second.size()) == LibHTML::PARSE_OK,
+        "another chunk after a pause");
+  parser.finish();
+  LibHTML::Parser reference;
+  std::string joined = first + second;
+  reference.parse(joined.c_str(), joined.size());
+  reference.finish();
+  check(serialize(*parser.document) == serialize(*reference.document),
+        "the paused chunk comes before the next one");
+  check(parser.resume(few) == LibHTML::PARSE_STOPPED,
+        "resuming without anything left over");
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -1,5 +1,5 @@
 #include "libhtml/parser.h"
-#include <exception>
+#include "libhtml/status.h"
 #include <fstream>
 #include <iostream>
 
@@ -19,24 +19,17 @@ int main(int argc, char **argv) {
     size_t read = file.readsome(chunk, READ_CHUNK_SIZE);
     if (read == 0)
       break;
-    try {
-      parser.parse(chunk, read);
-    } catch (std::exception &exc) {
-      std::cout << "[TEST FAIL] An exception has occurred during LibHTML "
-                   "parsing of test case: "
-                << exc.what() << std::endl;
+    if (parser.parse(chunk, read) == LibHTML::PARSE_ABORTED) {
+      std::cout << "[TEST FAIL] LibHTML gave up parsing the test case: "
+                << parser.error() << std::endl;
       return -1;
     }
   }
 
   // let the parser know we're EOF'd now
-  const wchar_t eof[] = {EOF};
-  try {
-    parser.parse(eof, 1);
-  } catch (std::exception &exc) {
-    std::cout << "[TEST FAIL] An exception has occurred during LibHTML parsing "
-                 "of implied EOF: "
-              << exc.what() << std::endl;
+  if (parser.finish() == LibHTML::PARSE_ABORTED) {
+    std::cout << "[TEST FAIL] LibHTML gave up parsing at the implied EOF: "
+              << parser.error() << std::endl;
     return -1;
   }
 
@@ -0,0 +1,85 @@
+#include "libhtml/tokenizer.h"
+#include <iostream>
+#include <string>
+
+// Checks how named character references are expanded in text and in
+// attribute values, with the input in one piece and split into single bytes.
+
+struct TestCase {
+  const char *input;
+  const wchar_t *expected;
+};
+
+static const TestCase TEXT_CASES[] = {
+    {"fish &amp; chips", L"fish & chips"},
+    {"a&nbsp;b", L"a\u00a0b"},
+    {"1&mdash;2", L"1—2"},
+    {"&CounterClockwiseContourIntegral;", L"∳"},
+    {"&ngE;", L"≧̸"},
+    {"&fjlig;", L"fj"},
+    // without a semicolon, only the legacy names match
+    {"&amp &lt &copy", L"& < ©"},
+    {"&ampx", L"&x"},
+    // the longest name wins
+    {"&notin;", L"∉"},
+    {"&notit;", L"¬it;"},
+    {"&no;", L"&no;"},
+    {"&nosuchthing; &", L"&nosuchthing; &"},
+    {"&amp", L"&"},
+    {"&", L"&"},
+};
+
+// the value of the title attribute in <a title="...">
+static const TestCase ATTRIBUTE_CASES[] = {
+    {"R&amp;D", L"R&D"},
+    {"&copy 2024", L"© 2024"},
+    // for historical reasons, query strings are left alone
+    {"?a=1&copy=2", L"?a=1&copy=2"},
+    {"&notit;", L"&notit;"},
+    {"&notin;", L"∉"},
+};
+
+static std::wstring tokenize(const std::string &input, size_t chunkSize,
+                             bool attribute) {
+  LibHTML::Tokenizer tokenizer;
+  std::wstring result;
+  auto collect = [&](LibHTML::Token &token) {
+    if (token.type == LibHTML::CHARACTER && !attribute)
+      result += token.data;
+    if (token.type == LibHTML::START_TAG && attribute)
+      result += token.attributes.at(0).value;
+  };
+
+  std::string document = attribute ? "<a title=\"" + input + "\">" : input;
+  for (size_t start = 0; start < document.size(); start += chunkSize) {
+    tokenizer.process(&document[start],
+                      std::min(chunkSize, document.size() - start), collect);
+  }
+  tokenizer.finish();
+  while (LibHTML::Token *token = tokenizer.next())
+    collect(*token);
+  return result;
+}
+
+static int check(const TestCase &test, bool attribute) {
+  std::string input(test.input);
+  int failures = 0;
+  for (size_t chunkSize : {input.size() + 16, size_t(1)}) {
+    if (tokenize(input, chunkSize, attribute) != test.expected) {
+      std::cout << "[TEST FAIL] " << (attribute ? "attribute " : "text ")
+                << '"' << test.input << "\" with chunks of " << chunkSize
+                << " bytes\n";
+      failures++;
+    }
+  }
+  return failures;
+}
+
+int main() {
+  int failures = 0;
+  for (const auto &test : TEXT_CASES)
+    failures += check(test, false);
+  for (const auto &test : ATTRIBUTE_CASES)
+    failures += check(test, true);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include "libhtml/tokenizer.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Feeds a document to the tokenizer in chunks of every size from 1 to 8 bytes,
+// so that multibyte characters and the keywords the tokenizer looks ahead for
+// get split between chunks in every possible place, and checks that the tokens
+// come out the same as when the whole document is fed at once. A shorter one
+// is also split in three at every pair of offsets, which cuts a lookahead in
+// two while it is already being carried over from the chunk before.
+
+static const char *DOCUMENT = R"(<!DOCTYPE html>
+<!-- Überblick -->
+<html lang="de">
+<head><title>Größenänderung – ein Überblick</title></head>
+<body>
+<h1 title="Überschrift">Grüße aus Köln</h1>
+<p>Ελληνικά, русский, 日本語 and 🎉 all in one paragraph.</p>
+<p data-ü="ä">attribute names can be non-ASCII too</p>
+)"
+                              "<p>Broken: \xE2\x82 and \xF0\x9F\x8E then \xC3 at "
+                              "the end\xE2\x82";
+
+static const char *SHORT_DOCUMENT =
+    "<!--><!DOCTYPE html><!-- Ü --><p title=\"Köln\">日本 🎉 \xE2\x82</p>";
+
+// everything the tokens carry, run together so that it doesn't matter how
+// the character runs are split up
+static std::wstring tokenize(const std::string &input,
+                             const std::vector<size_t> &splits) {
+  LibHTML::Tokenizer tokenizer;
+  std::wstring result;
+  auto collect = [&result](LibHTML::Token &token) {
+    switch (token.type) {
+      case LibHTML::CHARACTER:
+        result += token.data;
+        break;
+      case LibHTML::START_TAG:
+      case LibHTML::END_TAG:
+        result += L"<";
+        result += token.name;
+        for (auto &attribute : token.attributes) {
+          result += L" ";
+          result += attribute.name;
+          result += L"=";
+          result += attribute.value;
+        }
+        result += L">";
+        break;
+      case LibHTML::COMMENT:
+        result += L"<!--";
+        result += token.data;
+        result += L"-->";
+        break;
+      case LibHTML::DOCTYPE_TOKEN:
+        result += L"<!DOCTYPE ";
+        result += token.name;
+        result += L">";
+        break;
+      default:
+        break;
+    }
+  };
+
+  size_t start = 0;
+  for (size_t split : splits) {
+    tokenizer.process(&input[start], split - start, collect);
+    start = split;
+  }
+  tokenizer.process(&input[start], input.size() - start, collect);
+  tokenizer.finish();
+  while (LibHTML::Token *token = tokenizer.next())
+    collect(*token);
+  return result;
+}
+
+int main() {
+  std::string input(DOCUMENT);
+  std::wstring expected = tokenize(input, {});
+
+  const std::wstring samples[] = {
+      L"<!DOCTYPE html>",
+      L"<!-- Überblick -->",
+      L"Grüße aus Köln",
+      L"日本語 and \U0001f389 all",
+      L"data-ü=ä",
+      // invalid and cut off sequences each turn into a single U+FFFD
+      L"Broken: � and � then � at the end�",
+  };
+  for (const auto &sample : samples) {
+    if (expected.find(sample) == std::wstring::npos) {
+      std::cout << "[TEST FAIL] the whole document didn't decode as expected\n";
+      return 1;
+    }
+  }
+
+  int failures = 0;
+  for (size_t chunkSize = 1; chunkSize <= 8; chunkSize++) {
+    std::vector<size_t> splits;
+    for (size_t split = chunkSize; split < input.size(); split += chunkSize)
+      splits.push_back(split);
+    if (tokenize(input, splits) != expected) {
+      std::cout << "[TEST FAIL] tokens differ with chunks of " << chunkSize
+                << " bytes\n";
+      failures++;
+    }
+  }
+
+  std::string shortInput(SHORT_DOCUMENT);
+  std::wstring shortExpected = tokenize(shortInput, {});
+  for (size_t first = 1; first < shortInput.size(); first++) {
+    for (size_t second = first; second < shortInput.size(); second++) {
+      if (tokenize(shortInput, {first, second}) != shortExpected) {
+        std::cout << "[TEST FAIL] tokens differ when split at " << first
+                  << " and " << second << "\n";
+        failures++;
+      }
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/refptr.h"
+#include "libhtml/elementstack.h"
+#include "testing.h"
+
+using namespace LibDOM::Atoms;
+
+static auto s_document = LibDOM::Document::create();
+
+static LibDOM::RefPtr<LibDOM::Element> element(LibDOM::Atom name) {
+  auto element = s_document->createNode<LibDOM::Element>();
+  element->localName = name;
+  return element;
+}
+
+int main() {
+  LibHTML::ElementStack stack;
+  check(!stack.hasInScope(ATOM_p), "nothing is in scope of an empty stack");
+
+  auto outerP = element(ATOM_p);
+  stack.push_back(element(ATOM_html));
+  stack.push_back(element(ATOM_body));
+  stack.push_back(outerP);
+  check(stack.hasInScope(ATOM_p), "p in scope");
+  check(stack.hasInScope(ATOM_p, LibHTML::BUTTON_SCOPE), "p in button scope");
+
+  stack.push_back(element(ATOM_button));
+  check(stack.hasInScope(ATOM_p),
+        "button isn't a boundary of the default scope");
+  check(!stack.hasInScope(ATOM_p, LibHTML::BUTTON_SCOPE),
+        "button is a boundary of the button scope");
+  check(stack.hasInScope(ATOM_button, LibHTML::BUTTON_SCOPE),
+        "a boundary is in its own scope");
+
+  auto table = element(ATOM_table);
+  stack.push_back(table);
+  auto innerP = element(ATOM_p);
+  stack.push_back(innerP);
+  check(stack.hasInScope(ATOM_p), "the inner p is in scope");
+  check(stack.hasInScope(innerP) && !stack.hasInScope(outerP),
+        "only the p above the table is in scope");
+  check(stack.contains(outerP) && stack.contains(ATOM_body), "contains");
+
+  stack.pop_back();
+  check(!stack.hasInScope(ATOM_p), "the table hides the outer p");
+  stack.pop_back();
+  check(stack.hasInScope(ATOM_p) && !stack.contains(table),
+        "popping the table uncovers the outer p");
+
+  // taking an element out of the middle relinks the ones above it
+  stack.push_back(table);
+  stack.erase(stack.begin() + 3);
+  check(stack.size() == 4 && stack.back() == table, "erase");
+  check(!stack.contains(ATOM_button) && !stack.hasInScope(ATOM_p),
+        "the table still hides the p after an erase");
+  stack.pop_back();
+  check(stack.hasInScope(ATOM_p, LibHTML::BUTTON_SCOPE),
+        "the button is gone after an erase");
+
+  // positions stay valid until something below them changes
+  auto b = element(ATOM_b);
+  stack.push_back(b);
+  size_t position = stack.find(b);
+  check(position == stack.size() && stack.find(b, position) == position,
+        "find");
+  stack.insert(stack.begin() + 2, element(ATOM_div));
+  check(stack.find(b, position) == position + 1,
+        "a stale position falls back to searching");
+  auto otherB = element(ATOM_b);
+  stack.replace(stack.begin() + position, otherB);
+  check(stack.find(b) == 0 && stack.find(otherB) == position + 1, "replace");
+  stack.pop_back();
+  stack.erase(stack.begin() + 2);
+
+  auto custom = element(LibDOM::atomize(L"my-element"));
+  stack.push_back(custom);
+  auto otherCustom = element(LibDOM::atomize(L"my-element"));
+  stack.push_back(otherCustom);
+  check(stack.hasInScope(custom->localName) && stack.find(custom) != 0 &&
+            stack.find(otherCustom) == stack.size(),
+        "names without known atoms");
+  stack.pop_back();
+  stack.pop_back();
+  check(!stack.contains(custom->localName) && stack.contains(ATOM_body),
+        "popping names without known atoms");
+
+  stack.clear();
+  check(stack.empty() && !stack.contains(ATOM_html), "clear");
+  return s_failures == 0 ? 0 : 1;
+}
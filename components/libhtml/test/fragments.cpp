@@ -0,0 +1,105 @@
+#include "libdom/atom.h"
+#include "libdom/document.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include "testing.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Fragments parsed as the contents of a context element, checked against the
+// nodes the HTML fragment parsing algorithm makes of them, with one parser
+// doing all of them.
+
+using namespace LibDOM::Atoms;
+
+static auto s_document = LibDOM::Document::create();
+
+static LibDOM::RefPtr<LibDOM::Element> element(LibDOM::Atom name) {
+  auto element = s_document->createNode<LibDOM::HTMLElement>();
+  element->namespaceURI = HTML_NAMESPACE;
+  element->localName = name;
+  return element;
+}
+
+static LibHTML::Parser s_parser;
+
+static void check(LibDOM::Element &context, const std::string &input,
+                  const wchar_t *expected) {
+  std::vector<LibDOM::RefPtr<LibDOM::Node>> nodes;
+  auto status =
+      s_parser.parseFragment(context, input.c_str(), input.size(), nodes);
+  std::wstring out;
+  for (const auto &node : nodes) {
+    serialize(*node, out);
+    if (node->parentNode != nullptr)
+      out += L" (still has a parent)";
+  }
+  if (status != LibHTML::PARSE_STOPPED || out != expected) {
+    fail(input.c_str());
+    std::wcerr << L"  expected " << expected << L"\n  got      " << out
+               << L"\n";
+  }
+}
+
+int main() {
+  auto document = LibDOM::Document::create();
+  s_parser.document = document;
+
+  auto body = element(ATOM_body);
+  auto div = element(ATOM_div);
+  check(*body, "<p>one<b>two</p>three",
+        L"<p>one<b>two</b></p><b>three</b>");
+  check(*div, "<div>a<p>b</div>c", L"<div>a<p>b</p></div>c");
+  check(*body, "<body class=x>x</body>y<html>", L"xy");
+
+  // the tokenizer starts out in the state the context's contents are in,
+  // without a start tag for end tags to match
+  check(*element(ATOM_textarea), "<b>&amp;</textarea>x", L"<b>&</textarea>x");
+  check(*element(ATOM_style), "a > b { }</style>", L"a > b { }</style>");
+  check(*element(ATOM_title), "<i>&lt;</i>", L"<i><</i>");
+
+  // an html context starts before the head
+  check(*element(ATOM_html), "<title>t</title><p>x",
+        L"<head><title>t</title></head><body><p>x</p></body>");
+
+  // forms don't nest, even with the outer one outside the fragment
+  auto form = element(ATOM_form);
+  form->appendChild(div);
+  check(*div, "<form><p>x</form>y", L"<p>xy</p>");
+  form->removeChild(div.get());
+  check(*div, "<form><p>x</form>y", L"<form><p>x</p></form>y");
+
+  // a cell is parsed in body, but a row needs an insertion mode that isn't
+  // supported yet
+  check(*element(ATOM_td), "<p>x", L"<p>x</p>");
+  std::vector<LibDOM::RefPtr<LibDOM::Node>> nodes;
+  check(s_parser.parseFragment(*element(ATOM_tr), "x", 1, nodes) ==
+            LibHTML::PARSE_ABORTED,
+        "a tr context needs the in row insertion mode");
+
+  // the parser's own document is left alone, and fragments don't build up in
+  // the one they are made in
+  nodes.clear();
+  for (int i = 0; i < 1000; i++)
+    s_parser.parseFragment(*body, "<p>x", 4, nodes);
+  check(s_parser.document == document && !document->hasChildNodes(),
+        "the parser's document isn't touched");
+  check(nodes.size() == 1000 && nodes.front()->ownerDocument != nullptr &&
+            nodes.front()->ownerDocument == nodes.back()->ownerDocument &&
+            !nodes.front()->ownerDocument->hasChildNodes(),
+        "the fragment document is reused and left empty");
+
+  // whole documents can still be parsed after fragments
+  s_parser.reset();
+  const std::string whole = "<!DOCTYPE html><p>x";
+  s_parser.parse(whole.c_str(), whole.size());
+  check(s_parser.finish() == LibHTML::PARSE_STOPPED &&
+            document->childNodes().length() == 2,
+        "a whole document after fragments");
+
+  return s_failures == 0 ? 0 : 1;
+}
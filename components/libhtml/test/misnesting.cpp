@@ -0,0 +1,83 @@
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "testing.h"
+#include <iostream>
+#include <string>
+
+// Misnested formatting elements, checked against the trees the adoption agency
+// algorithm and the reconstruction of active formatting elements build for
+// them. bench/misnestingRuns times adversarial runs of them.
+
+using namespace LibDOM::Atoms;
+
+static LibDOM::RefPtr<LibDOM::Node>
+findBody(const LibDOM::RefPtr<LibDOM::Node> &node) {
+  if (node->nodeType == LibDOM::Node::ELEMENT_NODE &&
+      static_cast<LibDOM::Element &>(*node).localName == ATOM_body)
+    return node;
+  for (const auto &child : node->childNodes()) {
+    if (auto body = findBody(child))
+      return body;
+  }
+  return nullptr;
+}
+
+static LibDOM::RefPtr<LibDOM::Node> parse(const std::string &body) {
+  std::string document = "<!DOCTYPE html><html><head></head><body>" + body;
+  LibHTML::Parser parser;
+  parser.parse(document.c_str(), document.size());
+  parser.finish();
+  return findBody(parser.document);
+}
+
+static void check(const char *input, const wchar_t *expected) {
+  auto body = parse(input);
+  std::wstring children;
+  for (const auto &child : body->childNodes())
+    serialize(*child, children);
+  if (children != expected) {
+    fail(input);
+    std::wcerr << L"  expected " << expected << L"\n  got      " << children
+               << L"\n";
+  }
+}
+
+int main() {
+  // no furthest block
+  check("<b>1<i>2</b>3</i>", L"<b>1<i>2</i></b><i>3</i>");
+  check("<p>1<b>2<i>3</b>4</i>5</p>", L"<p>1<b>2<i>3</i></b><i>4</i>5</p>");
+  check("<a>1<b>2</a>3</b>", L"<a>1<b>2</b></a><b>3</b>");
+
+  // a special element below the formatting element
+  check("<a><p></a></p>", L"<a></a><p><a></a></p>");
+  check("<a>1<p>2</a>3</p>", L"<a>1</a><p><a>2</a>3</p>");
+  check("<a>1<button>2</a>3</button>",
+        L"<a>1</a><button><a>2</a>3</button>");
+  check("<a>1<div>2<div>3</a>4</div>5</div>",
+        L"<a>1</a><div><a>2</a><div><a>3</a>4</div>5</div>");
+  check("<b>1<i>2<p>3</b>4", L"<b>1<i>2</i></b><i><p><b>3</b>4</p></i>");
+
+  // an a start tag closes the a before it
+  check("<a>1<a>2", L"<a>1</a><a>2</a>");
+  check("<a>1<p>2<a>3", L"<a>1</a><p><a>2</a><a>3</a></p>");
+
+  // end tags without a formatting element are handled like any other
+  check("<p>1</b>2</p>", L"<p>12</p>");
+  check("<span>1<b>2</span>3", L"<span>1<b>2</b></span><b>3</b>");
+
+  // Noah's Ark: only three of the same element are reconstructed
+  check("<p><b><b><b><b>1<p>2",
+        L"<p><b><b><b><b>1</b></b></b></b></p><p><b><b><b>2</b></b></b></p>");
+  check("<p><b class=x><b class=x><b><b class=x><b class=x>1<p>2",
+        L"<p><b><b><b><b><b>1</b></b></b></b></b></p>"
+        L"<p><b><b><b><b>2</b></b></b></b></p>");
+
+  // formatting elements don't leak out of a marker
+  check("<b><object><i>1</object>2", L"<b><object><i>1</i></object>2</b>");
+  check("<object><b>1</object>2", L"<object><b>1</b></object>2");
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include "libdom/document.h"
+#include "libdom/nodearena.h"
+#include "libdom/refptr.h"
+#include "libdom/text.h"
+#include "libhtml/parser.h"
+#include "testing.h"
+#include <string>
+
+// Parsing page after page into new documents, the way a long-running render
+// worker or the Qt shell does, must give back the memory of the pages that are
+// dropped, so that only the arena of the document in use is left. A finished
+// page is freed as soon as its document is dropped, without the parser being
+// reset first.
+
+#define PAGES 3000
+
+/**
+  Pages with a bit of everything the parser keeps pointers to. A complete page
+  ends with its body and html end tags; the others are left open, so the
+  parser still has elements open at the end.
+*/
+static std::string page(int seed, bool complete) {
+  std::string n = std::to_string(seed);
+  std::string page = "<!DOCTYPE html><html><head><title>Page " + n +
+                     "</title><meta charset=utf-8></head><body>";
+  for (int i = 0; i < 20; i++) {
+    page += "<form><p class=\"c" + n + "\">Text <b>bold <i>both</b> italic</i>"
+            " <a href=\"/" + n + "\">link</a><!-- comment --></p>";
+  }
+  if (complete)
+    page += "</body></html>\n";
+  else
+    page += "<ul><li>one<li>two<table><tr><td>cell";
+  return page;
+}
+
+int main() {
+  size_t before = LibDOM::NodeArena::totalBlockBytes();
+  LibHTML::Parser parser;
+  parser.recoveryMode = LibHTML::BEST_EFFORT;
+  bool stopped = true, freed = true;
+  for (int i = 0; i < PAGES; i++) {
+    bool complete = i % 2 == 0;
+    std::string input = page(i, complete);
+    parser.reset();
+    parser.document = LibDOM::Document::create();
+    parser.parse(input.c_str(), input.size());
+    // pages that are left unfinished are dropped by the next reset()
+    if (i % 3 == 0)
+      continue;
+    auto status = parser.finish();
+    if (!complete)
+      continue;
+    stopped = stopped && status == LibHTML::PARSE_STOPPED;
+    parser.document = LibDOM::Document::create();
+    freed = freed && LibDOM::NodeArena::totalBlockBytes() == before;
+  }
+  check(stopped, "a complete page stops the parser");
+  check(freed, "a finished page is freed when its document is dropped");
+  parser.reset();
+  parser.document = LibDOM::Document::create();
+  check(LibDOM::NodeArena::totalBlockBytes() == before,
+        "dropped pages are freed");
+
+  // a node that is still in use keeps its document's memory, but not the
+  // rest of the tree
+  std::string input = page(0, true);
+  parser.parse(input.c_str(), input.size());
+  parser.finish();
+  auto document = parser.document.get();
+  auto text = document->createNode<LibDOM::Text>(L"kept");
+  document->documentElement()->appendChild(text);
+  parser.document = LibDOM::Document::create();
+  check(text->parentNode == nullptr && text->ownerDocument == document &&
+            document->arena().liveCount() == 1,
+        "a dropped document frees all its nodes that aren't used");
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#include "libdom/atom.h"
+#include "libdom/comment.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libdom/text.h"
+#include "libhtml/parser.h"
+#include "libhtml/parserlimits.h"
+#include "libhtml/parserpool.h"
+#include "libhtml/status.h"
+#include "testing.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Hostile documents parsed with limits: each limit holds, is dealt with like
+// a parse error, and is counted when it cuts the document short.
+
+using namespace LibDOM::Atoms;
+
+static size_t depth(const LibDOM::Node &node) {
+  size_t deepest = 0;
+  for (const auto &child : node.childNodes())
+    deepest = std::max(deepest, depth(*child));
+  return deepest + 1;
+}
+
+static size_t countNodes(const LibDOM::Node &node) {
+  size_t count = 1;
+  for (const auto &child : node.childNodes())
+    count += countNodes(*child);
+  return count;
+}
+
+static LibDOM::Node *find(LibDOM::Node &node, unsigned short type) {
+  for (const auto &child : node.childNodes()) {
+    if (child->nodeType == type)
+      return child;
+    if (auto *found = find(*child, type))
+      return found;
+  }
+  return nullptr;
+}
+
+static std::string repeat(const std::string &s, size_t count) {
+  std::string out;
+  for (size_t i = 0; i < count; i++)
+    out += s;
+  return out;
+}
+
+static LibHTML::ParseStatus parse(LibHTML::Parser &parser,
+                                  const LibHTML::ParserLimits &limits,
+                                  const std::string &input) {
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  parser.setLimits(limits);
+  auto status = parser.parse(input.c_str(), input.size());
+  if (status == LibHTML::PARSE_OK)
+    status = parser.finish();
+  return status;
+}
+
+int main() {
+  LibHTML::Parser parser;
+
+  // deep nesting makes siblings past the depth limit, the way browsers clamp
+  LibHTML::ParserLimits shallow;
+  shallow.maxDepth = 16;
+  const std::string nested = repeat("<div>", 1000) + "x";
+  check(parse(parser, shallow, nested) == LibHTML::PARSE_STOPPED,
+        "deep nesting: parses");
+  // the document and the text take one level each
+  check(depth(*parser.document) <= shallow.maxDepth + 2,
+        "deep nesting: the tree is no deeper than the limit");
+  check(countNodes(*parser.document) == 1 + 3 + 1000 + 1,
+        "deep nesting: every element is kept");
+  check(parser.limitCounters().clampedElements > 900,
+        "deep nesting: clamped elements are counted");
+  parse(parser, LibHTML::ParserLimits(), nested);
+  check(depth(*parser.document) > 1000 &&
+            parser.limitCounters().clampedElements == 0,
+        "deep nesting: no limits by default");
+
+  // formatting elements that are never closed are forgotten past the limit,
+  // so reconstructing them makes a bounded number of elements
+  std::string unclosed = "<p>";
+  for (int i = 0; i < 1000; i++)
+    unclosed += "<b id=" + std::to_string(i) + ">";
+  unclosed += "</p>x";
+  check(parse(parser, shallow, unclosed) == LibHTML::PARSE_STOPPED,
+        "unclosed formatting elements: parses");
+  check(parser.limitCounters().droppedFormattingElements == 1000 - 16,
+        "unclosed formatting elements: dropped entries are counted");
+  check(depth(*parser.document) <= shallow.maxDepth + 2,
+        "unclosed formatting elements: reconstruction is bounded");
+
+  // attributes past the limit are dropped, like duplicate ones
+  LibHTML::ParserLimits fewAttributes;
+  fewAttributes.maxAttributes = 4;
+  std::string manyAttributes = "<p";
+  for (int i = 0; i < 100; i++)
+    manyAttributes += " a" + std::to_string(i) + "=" + std::to_string(i);
+  manyAttributes += ">x";
+  parse(parser, fewAttributes, manyAttributes);
+  auto *p = static_cast<LibDOM::Element *>(
+      find(*parser.document, LibDOM::Node::ELEMENT_NODE)
+          ->lastChild()
+          ->firstChild());
+  check(p->localName == ATOM_p && p->attributes.length() == 4,
+        "many attributes: the first ones are kept");
+  check(parser.limitCounters().droppedAttributes == 96,
+        "many attributes: dropped attributes are counted");
+
+  // long strings in tokens are cut off, and long names still atomize right
+  LibHTML::ParserLimits shortTokens;
+  shortTokens.maxTokenSize = 8;
+  const std::string longStrings = "<!--" + repeat("c", 1000) +
+                                  "--><p title=" + repeat("v", 100) +
+                                  " classabcdefgh=x>";
+  parse(parser, shortTokens, longStrings);
+  auto *comment = static_cast<LibDOM::Comment *>(
+      find(*parser.document, LibDOM::Node::COMMENT_NODE));
+  check(comment != nullptr && comment->data == std::wstring(8, L'c'),
+        "long comment: cut off at the limit");
+  check(parser.limitCounters().droppedCharacters == 992 + 92 + 5,
+        "long strings: dropped characters are counted");
+  p = static_cast<LibDOM::Element *>(
+      parser.document->lastChild()->lastChild()->firstChild());
+  check(p->attributes.getNamedItem(ATOM_title) != nullptr &&
+            p->attributes.getNamedItem(ATOM_title)->value() ==
+                std::wstring(8, L'v') &&
+            p->attributes.getNamedItem(ATOM_class) == nullptr,
+        "long attributes: values are cut off, names are cut to new names");
+  check(parse(parser, shortTokens, "<blockquote>x") == LibHTML::PARSE_STOPPED,
+        "long tag name: parses as a tag of the name it was cut to");
+
+  // past the node limit, the input ends there
+  LibHTML::ParserLimits fewNodes;
+  fewNodes.maxNodes = 100;
+  const std::string manyNodes = repeat("<p>x", 10000);
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  parser.setLimits(fewNodes);
+  check(parser.parse(manyNodes.c_str(), manyNodes.size()) ==
+            LibHTML::PARSE_STOPPED,
+        "many nodes: parsing stops at the limit");
+  check(countNodes(*parser.document) <= 100 + 1 &&
+            parser.limitCounters().nodeLimitReached,
+        "many nodes: the limit holds and is reported");
+
+  // past the byte limit, the input ends there too
+  LibHTML::ParserLimits fewBytes;
+  fewBytes.maxBytes = 10;
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  parser.setLimits(fewBytes);
+  parser.parse("<p>abc", 6);
+  check(parser.parse("defghijk", 8) == LibHTML::PARSE_STOPPED,
+        "many bytes: parsing stops at the limit");
+  auto *text = static_cast<LibDOM::Text *>(
+      find(*parser.document, LibDOM::Node::TEXT_NODE));
+  check(text != nullptr && text->data == L"abcdefg" &&
+            parser.limitCounters().byteLimitReached,
+        "many bytes: the input is cut off and that is reported");
+
+  // the same limits hold when the tokenizer runs on another thread
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  parser.setLimits(fewAttributes);
+  parser.parsePipelined(manyAttributes.c_str(), manyAttributes.size());
+  check(parser.limitCounters().droppedAttributes == 96,
+        "pipelined: dropped attributes are counted");
+
+  // and each document in a pool gets its own
+  LibHTML::ParserPool pool(2);
+  pool.limits = fewNodes;
+  auto results = pool.parse({manyNodes, "<p>x"});
+  check(results[0].status == LibHTML::PARSE_STOPPED &&
+            results[0].limitCounters.nodeLimitReached &&
+            !results[1].limitCounters.nodeLimitReached,
+        "pool: limits apply to each document");
+
+  parser.reset();
+  check(!parser.limitCounters().nodeLimitReached &&
+            parser.limitCounters().droppedAttributes == 0,
+        "reset() clears the counters");
+
+  // names that aren't known fill the atom table only up to its limit, and
+  // the elements and attributes named after that keep their names as strings
+  unsigned int filled = 0;
+  while (LibDOM::atomize(L"x-fill-" + std::to_wstring(filled)) !=
+         LibDOM::UNINTERNED_ATOM)
+    filled++;
+  LibHTML::Parser names;
+  std::string custom = "<body><x-outer data-outer=1><x-inner data-inner=2>t"
+                       "</x-other></x-outer>after";
+  names.parse(custom.c_str(), custom.size());
+  names.finish();
+  auto *outer = names.document->body()->firstChild();
+  check(serialize(*names.document->body(), true) ==
+                L"<body><x-outer data-outer=1><x-inner data-inner=2>\"t\""
+                L"</x-inner></x-outer>\"after\"</body>" &&
+            static_cast<LibDOM::Element *>(outer)->localName ==
+                LibDOM::UNINTERNED_ATOM,
+        "names past the atom table's limit");
+
+  return s_failures == 0 ? 0 : 1;
+}
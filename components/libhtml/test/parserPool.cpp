@@ -0,0 +1,88 @@
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "libhtml/parserpool.h"
+#include "libhtml/status.h"
+#include "testing.h"
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Parsers on different threads mustn't share any state, so parsing documents
+// concurrently has to give the same results as parsing them one after another.
+
+static std::vector<std::string> makeDocuments() {
+  const char *bodies[] = {
+      "<p>plain <b>bold</b> text",
+      "<p><b>1<i>2</b>3</i>4",
+      "<div><custom-element>x</custom-element><my-other-element>",
+      "<p>&amp; &notin; &#x41;",
+      "<textarea><p></textarea><p>after",
+      "<div>before</div><frameset><p>after</p>",
+  };
+  std::vector<std::string> documents;
+  for (size_t i = 0; i < 300; i++) {
+    std::string document = "<!DOCTYPE html><title>" + std::to_string(i) +
+                           "</title><body>";
+    // a few documents are much larger than the rest
+    size_t repeat = i % 50 == 0 ? 2000 : 1 + i % 7;
+    for (size_t j = 0; j < repeat; j++)
+      document += bodies[(i + j) % 6];
+    documents.push_back(document);
+  }
+  return documents;
+}
+
+int main() {
+  auto documents = makeDocuments();
+  std::vector<std::string_view> views(documents.begin(), documents.end());
+
+  std::vector<std::wstring> expected;
+  std::vector<LibHTML::ParseStatus> expectedStatus;
+  for (const auto &document : documents) {
+    LibHTML::Parser parser;
+    LibHTML::ParseStatus status =
+        parser.parse(document.c_str(), document.size());
+    if (status == LibHTML::PARSE_OK)
+      status = parser.finish();
+    expected.push_back(serialize(*parser.document));
+    expectedStatus.push_back(status);
+  }
+
+  LibHTML::ParserPool pool(4);
+  check(pool.threadCount() == 4, "the pool has the threads it was asked for");
+  check(pool.parse({}).empty(), "parsing no documents");
+
+  auto compare = [&](const std::vector<LibHTML::ParserPool::Result> &results,
+                     const char *what) {
+    bool same = results.size() == documents.size();
+    for (size_t i = 0; same && i < results.size(); i++) {
+      same = results[i].status == expectedStatus[i] &&
+             serialize(*results[i].document) == expected[i] &&
+             (results[i].error != nullptr) ==
+                 (results[i].status == LibHTML::PARSE_ABORTED);
+    }
+    check(same, what);
+  };
+  compare(pool.parse(views), "the pool builds the same documents");
+  compare(pool.parse(views), "a pool can be used again");
+
+  // calls from several threads take turns
+  std::vector<LibHTML::ParserPool::Result> first, second;
+  std::thread other([&] { first = pool.parse(views); });
+  second = pool.parse(views);
+  other.join();
+  compare(first, "parsing from two threads at once");
+  compare(second, "parsing from two threads at once");
+
+  // a pool with more threads than documents
+  LibHTML::ParserPool wide(8);
+  auto few = wide.parse({views[1], views[2]});
+  check(few.size() == 2 && serialize(*few[0].document) == expected[1] &&
+            serialize(*few[1].document) == expected[2],
+        "more threads than documents");
+
+  return s_failures == 0 ? 0 : 1;
+}
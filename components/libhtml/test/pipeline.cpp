@@ -0,0 +1,98 @@
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokenpipeline.h"
+#include "libhtml/tokens.h"
+#include "testing.h"
+#include <string>
+
+// Parsing with the tokenizer on a worker thread has to build the same document
+// as parsing on one thread, including where the tree builder switches the
+// tokenizer into a state the worker didn't expect.
+
+using namespace LibDOM::Atoms;
+
+static std::wstring parse(const std::string &document, bool pipelined,
+                          LibHTML::ParseStatus &status) {
+  LibHTML::Parser parser;
+  parser.recoveryMode = LibHTML::BEST_EFFORT;
+  if (pipelined) {
+    status = parser.parsePipelined(document.c_str(), document.size());
+  } else {
+    parser.parse(document.c_str(), document.size());
+    status = parser.finish();
+  }
+  return serialize(*parser.document, true);
+}
+
+static void checkSame(const std::string &document, const char *what) {
+  LibHTML::ParseStatus expected, got;
+  if (parse(document, false, expected) != parse(document, true, got) ||
+      expected != got)
+    fail(what);
+}
+
+int main() {
+  checkSame("<!DOCTYPE html><title>a <b> title</title><p>text",
+            "the worker switches to RCDATA after a title");
+  checkSame("<!DOCTYPE html><style>p > b { }</style><body><textarea><p>"
+            "</textarea><xmp><i></xmp>",
+            "the worker switches to RAWTEXT and RCDATA in the body");
+  checkSame("<!DOCTYPE html><body><plaintext><p></plaintext>",
+            "the worker switches to PLAINTEXT");
+  checkSame("<!DOCTYPE html><p>&amp; &lt;b&gt; &notin; &#x41; &nosemi",
+            "character references");
+  checkSame("<!DOCTYPE html><p><b class=x>1<i>2</b>3</i>4<a href=y>5<p>6</a>",
+            "misnested formatting elements");
+  checkSame("<!DOCTYPE html><div>before</div><frameset><p>after</p>",
+            "unsupported markup");
+  checkSame("<!DOCTYPE html><!-- a comment --><p>", "comments");
+
+  // a select doesn't let a textarea in, so the tokenizer stays in the data
+  // state and the worker has to start over after the tag
+  checkSame("<!DOCTYPE html><select><textarea><option>o</textarea></select>"
+            "<p>after",
+            "the tree builder doesn't make the expected switch");
+
+  // enough batches to go round the ring several times, with text that is
+  // bigger than a batch
+  std::string large = "<!DOCTYPE html><html><head><title>large</title></head>"
+                      "<body>";
+  for (int i = 0; i < 20000; i++) {
+    large += "<div class=\"item" + std::to_string(i) +
+             "\"><p>a paragraph with <b>bold</b> and &amp; text</div>\n";
+    if (i % 5000 == 0)
+      large += "<textarea>" + std::string(40000, 'x') + "</textarea>";
+  }
+  checkSame(large, "a large document");
+
+  // the worker expects RCDATA after the title; going back to the data state
+  // after it must give the tokens the tree builder would otherwise have got
+  const std::string input = "<title><b></title>x";
+  LibHTML::TokenPipeline pipeline(input.c_str(), input.size(), false, false);
+  pipeline.start(LibHTML::DATA);
+  auto *batch = pipeline.next();
+  check(batch != nullptr && batch->size > 0 &&
+            batch->entries[0].token.atom == ATOM_title &&
+            batch->entries[0].switchedTo == LibHTML::RCDATA,
+        "the worker records the switch after a title");
+  if (batch != nullptr && batch->size > 1) {
+    check(batch->entries[1].token.type == LibHTML::CHARACTER,
+          "the worker tokenizes a title as text");
+  }
+  if (batch != nullptr && batch->size > 0) {
+    pipeline.restart(batch->entries[0].end, LibHTML::DATA, ATOM_title);
+    batch = pipeline.next();
+    check(batch != nullptr && batch->size > 0 &&
+              batch->entries[0].token.type == LibHTML::START_TAG &&
+              batch->entries[0].token.atom == ATOM_b,
+          "a restart drops the tokens that came after the switch");
+    check(pipeline.restarts() == 1, "restarts are counted");
+  }
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "libhtml/fetchqueue.h"
+#include "libhtml/preloadscanner.h"
+#include "testing.h"
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// Scans a document for subresources ahead of the parser, and lets a loader
+// fetch them from a stand-in for an HTTP server in order of priority.
+
+/** Serves a fixed set of paths, the way a local HTTP server would. */
+struct StandInServer {
+  std::map<std::wstring, int> bodies;
+  std::vector<std::wstring> requests;
+
+  int get(const std::wstring &url) {
+    requests.push_back(url);
+    return bodies.count(url) != 0 ? 200 : 404;
+  }
+};
+
+static const std::vector<std::wstring> EXPECTED_FETCHES = {
+    // stylesheets, blocking scripts and fonts
+    L"fonts/body.woff2",
+    L"app.js",
+    L"style.css",
+    L"late.css",
+    // async and module scripts and other preloads
+    L"data.json",
+    L"analytics.js",
+    L"module.js",
+    // images, with noscript's content being markup without scripting
+    L"hero.jpg",
+    L"logo.png",
+    L"medium.png",
+    L"wide.png",
+    L"fallback.png",
+};
+
+/** Scans `input` in chunks of `chunkSize`, and fetches what was found. */
+static std::vector<std::wstring> scanAndFetch(const std::string &input,
+                                              size_t chunkSize,
+                                              std::wstring &base) {
+  LibHTML::FetchQueue queue;
+  LibHTML::PreloadScanner scanner(queue);
+  for (size_t start = 0; start < input.size(); start += chunkSize)
+    scanner.scan(&input[start], std::min(chunkSize, input.size() - start));
+  scanner.finish();
+  base = scanner.baseURL();
+
+  StandInServer server;
+  for (const auto &url : EXPECTED_FETCHES)
+    server.bodies[base + url] = 200;
+  LibHTML::FetchRequest request;
+  std::vector<std::wstring> fetched;
+  while (queue.pop(request)) {
+    if (server.get(base + request.url) == 200)
+      fetched.push_back(request.url);
+  }
+  check(server.requests.size() == fetched.size(),
+        "the loader only asks for what the document refers to");
+  return fetched;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::cout << "Usage: " << argv[0] << " <html>\n";
+    return 1;
+  }
+  std::ifstream file(argv[1]);
+  std::string input(std::istreambuf_iterator<char>(file), {});
+  check(!input.empty(), "the test document can be read");
+
+  for (size_t chunkSize : {input.size(), size_t(7), size_t(1)}) {
+    std::wstring base;
+    check(scanAndFetch(input, chunkSize, base) == EXPECTED_FETCHES,
+          "subresources are found and fetched in order of priority");
+    check(base == L"https://example.com/site/", "the base URL is found");
+  }
+
+  check(LibHTML::pickSrcsetCandidate(L" a.png 2x , b.png 1x") == L"b.png",
+        "srcset: the 1x candidate");
+  check(LibHTML::pickSrcsetCandidate(L"a.png, b.png 2x") == L"a.png",
+        "srcset: a URL ending in a comma has no descriptors");
+  check(LibHTML::pickSrcsetCandidate(L"a.png 100w, b.png 200w") == L"a.png",
+        "srcset: the first candidate without a 1x one");
+  check(LibHTML::pickSrcsetCandidate(L" , ").empty(),
+        "srcset: no candidates");
+
+  LibHTML::FetchQueue queue;
+  check(queue.push({L"a.png", LibHTML::FETCH_IMAGE, LibHTML::PRIORITY_LOW}) &&
+            !queue.push(
+                {L"a.png", LibHTML::FETCH_IMAGE, LibHTML::PRIORITY_HIGH}),
+        "a URL is only queued once");
+  LibHTML::FetchRequest request;
+  check(queue.pop(request) && queue.empty() &&
+            !queue.push({L"a.png", LibHTML::FETCH_IMAGE,
+                         LibHTML::PRIORITY_LOW}),
+        "a URL that was fetched isn't queued again");
+  queue.clear();
+  check(queue.push({L"a.png", LibHTML::FETCH_IMAGE, LibHTML::PRIORITY_LOW}),
+        "clear() forgets the URLs");
+
+  return s_failures == 0 ? 0 : 1;
+}
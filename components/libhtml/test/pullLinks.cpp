@@ -0,0 +1,66 @@
+#include "libdom/atom.h"
+#include "libhtml/tokenizer.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Pulls tokens straight out of the tokenizer, without building a DOM, to
+// collect every link in a document the way a crawler would.
+
+static const char *DOCUMENT = R"(<!DOCTYPE html>
+<html>
+<head>
+    <link rel="stylesheet" href="style.css">
+    <script src="app.js"></script>
+</head>
+<body>
+    <p>See <a href="/about">about</a> or <a href='/contact'>contact</a>.</p>
+    <img src=logo.png alt="logo">
+    <a name="anchor">no link here</a>
+    <a href="/café/naïve">accents</a>
+</body>
+</html>)";
+
+static const std::vector<std::wstring> EXPECTED_LINKS = {
+    L"style.css", L"app.js",           L"/about",
+    L"/contact",  L"logo.png", L"/caf\u00e9/na\u00efve",
+};
+
+// feeds the input one line at a time when `byLine` is set
+static std::vector<std::wstring> collectLinks(const std::string &input,
+                                              bool byLine) {
+  LibHTML::Tokenizer tokenizer;
+  std::vector<std::wstring> links;
+  size_t start = 0;
+  while (start < input.size()) {
+    size_t end = byLine ? input.find('\n', start) : std::string::npos;
+    end = end == std::string::npos ? input.size() : end + 1;
+    tokenizer.feed(&input[start], end - start);
+    start = end;
+    while (LibHTML::Token *token = tokenizer.next()) {
+      if (token->type != LibHTML::START_TAG)
+        continue;
+      for (auto &attribute : token->attributes) {
+        if (attribute.atom == LibDOM::Atoms::ATOM_href ||
+            attribute.atom == LibDOM::Atoms::ATOM_src)
+          links.emplace_back(attribute.value);
+      }
+    }
+  }
+  return links;
+}
+
+int main() {
+  std::string input(DOCUMENT);
+  int failures = 0;
+  for (bool byLine : {false, true}) {
+    auto links = collectLinks(input, byLine);
+    if (links != EXPECTED_LINKS) {
+      std::cout << "[TEST FAIL] found " << links.size() << " links instead of "
+                << EXPECTED_LINKS.size()
+                << (byLine ? " feeding lines\n" : " feeding the document\n");
+      failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "libdom/atom.h"
+#include "libdom/element.h"
+#include "libdom/node.h"
+#include "libdom/refptr.h"
+#include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokens.h"
+#include "testing.h"
+#include <string>
+
+// The parser reports what became of its input through return values: the end
+// of the document, and markup it doesn't support, which it either stops at or
+// skips, keeping the document it has built.
+
+using namespace LibDOM::Atoms;
+
+static bool hasElement(const LibDOM::RefPtr<LibDOM::Node> &node,
+                       LibDOM::Atom name) {
+  if (node->nodeType == LibDOM::Node::ELEMENT_NODE &&
+      LibDOM::static_pointer_cast<LibDOM::Element>(node)->localName == name)
+    return true;
+  for (const auto &child : node->childNodes()) {
+    if (hasElement(child, name))
+      return true;
+  }
+  return false;
+}
+
+int main() {
+  const std::string supported = "<!DOCTYPE html><p>fine</p>";
+  const std::string unsupported =
+      "<!DOCTYPE html><div>before</div><frameset><p>after</p>";
+
+  LibHTML::Parser parser;
+  check(parser.parse(supported.c_str(), supported.size()) ==
+            LibHTML::PARSE_OK,
+        "a chunk of supported markup parses");
+  check(parser.finish() == LibHTML::PARSE_STOPPED,
+        "parsing stops at the end of the document");
+  check(parser.error() == nullptr, "no error for supported markup");
+  check(parser.parse("<p>", 3) == LibHTML::PARSE_STOPPED,
+        "input after the end is ignored");
+
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  check(parser.parse(unsupported.c_str(), unsupported.size()) ==
+            LibHTML::PARSE_ABORTED,
+        "parsing is aborted at unsupported markup");
+  check(parser.error() != nullptr, "the error says what wasn't supported");
+  check(hasElement(parser.document, ATOM_div) &&
+            !hasElement(parser.document, ATOM_p),
+        "an aborted parse keeps the document up to the error");
+  check(parser.finish() == LibHTML::PARSE_ABORTED,
+        "an aborted parse stays aborted");
+
+  parser.document = LibDOM::Document::create();
+  parser.reset();
+  check(parser.error() == nullptr, "reset() clears the error");
+  parser.recoveryMode = LibHTML::BEST_EFFORT;
+  check(parser.parse(unsupported.c_str(), unsupported.size()) ==
+            LibHTML::PARSE_OK,
+        "best effort parsing carries on past unsupported markup");
+  check(parser.finish() == LibHTML::PARSE_STOPPED,
+        "best effort parsing gets to the end of the document");
+  check(parser.error() != nullptr, "best effort parsing still has the error");
+  check(hasElement(parser.document, ATOM_div) &&
+            hasElement(parser.document, ATOM_p),
+        "best effort parsing keeps what comes after the error");
+
+  // foreign content isn't supported yet, and says so
+  for (const std::string input : {"<p><svg><circle/></svg>", "<p><math>"}) {
+    LibHTML::Parser foreignParser;
+    check(foreignParser.parse(input.c_str(), input.size()) ==
+              LibHTML::PARSE_ABORTED,
+          "foreign content is unsupported markup");
+  }
+
+  // markup the tokenizer doesn't support in the text of a <title>, <textarea>
+  // or <script> leaves it in that text, where the tree builder expects it
+  for (const std::string input :
+       {"<title>&#65;<b>x</b></title><p>after", "<textarea>&#65;<b>",
+        "<script><!--x</script><p>after"}) {
+    for (bool pipelined : {false, true}) {
+      LibHTML::Parser textParser;
+      textParser.recoveryMode = LibHTML::BEST_EFFORT;
+      if (pipelined)
+        textParser.parsePipelined(input.c_str(), input.size());
+      else
+        textParser.parse(input.c_str(), input.size());
+      check(textParser.finish() == LibHTML::PARSE_STOPPED &&
+                textParser.error() != nullptr &&
+                !hasElement(textParser.document, ATOM_b) &&
+                hasElement(textParser.document, ATOM_p) ==
+                    (input.find("<p>") != std::string::npos),
+            "best effort parsing recovers in the text of an element");
+    }
+  }
+
+  // a sink returning false stops the tokenizer, which picks up from there
+  LibHTML::Tokenizer tokenizer;
+  const std::string tags = "<a><b><i>";
+  size_t count = 0;
+  check(tokenizer.process(tags.c_str(), tags.size(),
+                          [&](LibHTML::Token &) { return ++count < 2; }) ==
+            LibHTML::PARSE_STOPPED,
+        "a sink can stop the tokenizer");
+  LibHTML::Token *token = tokenizer.next();
+  check(count == 2 && token != nullptr && token->atom == ATOM_i,
+        "the tokenizer carries on where the sink stopped it");
+
+  return s_failures == 0 ? 0 : 1;
+}
@@ -9,8 +9,7 @@ int main() {
   parser.parse(s.c_str(), s.size());
 
   // let the parser know we're EOF'd now
-  const wchar_t eof[] = {EOF};
-  parser.parse(eof, 1);
+  parser.finish();
 
   return 0;
 }
@@ -0,0 +1,55 @@
+#include "libhtml/tokenizer.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+// Counts every allocation made while tokenizing, to check that a tokenizer that
+// has already seen a document doesn't allocate when it sees a similar one.
+
+static size_t s_allocations = 0;
+
+void *operator new(size_t size) {
+  s_allocations++;
+  void *ptr = malloc(size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+static const char *DOCUMENT = R"(<!DOCTYPE html>
+<html lang="en">
+<head>
+    <meta charset="UTF-8">
+    <title>Document</title>
+    <link rel="stylesheet" href="test.css" media=screen>
+</head>
+<body class='main'>
+    <h1 id="title" data-x="&">Hello, world!</h1>
+    <p>This is a test document.<br/></p>
+    <!-- this is a comment -->
+</body>
+</html>)";
+
+int main() {
+  LibHTML::Tokenizer tokenizer;
+  std::string input(DOCUMENT);
+  size_t tokens = 0;
+  auto onEmit = [&tokens](LibHTML::Token &) { tokens++; };
+
+  // the first run grows the tokenizer's buffers to fit
+  tokenizer.process(input.c_str(), input.size(), onEmit);
+
+  s_allocations = 0;
+  tokenizer.process(input.c_str(), input.size(), onEmit);
+  size_t allocations = s_allocations;
+
+  if (allocations != 0) {
+    std::cout << "[TEST FAIL] tokenizing " << tokens << " tokens made "
+              << allocations << " heap allocations\n";
+    return 1;
+  }
+  return 0;
+}
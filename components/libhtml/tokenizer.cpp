@@ -1,7 +1,9 @@
 #include "libhtml/tokenizer.h"
+#include "libdom/atom.h"
 #include "libhtml.h"
-#include "libhtml/exceptions.h"
+#include "libhtml/entities.h"
 #include "libhtml/tokens.h"
+#include "libhtml/utf8.h"
 #include <algorithm>
 #include <cassert>
 #include <cctype>
@@ -10,16 +12,11 @@
 #include <cwchar>
 #include <ios>
 #include <iostream>
-#include <memory>
-#include <string.h>
-#include <utility>
+#include <string_view>
 
 // helper macros
 #define IF_IS(x) if (m_currentChar == (x))
-#define RECONSUME m_inputPtr--
-#define CONVERT_TO(type, ptr)                                                  \
-  std::unique_ptr<type>(reinterpret_cast<type *>(ptr.release()))
-#define MOVE_TOKEN(ptr) m_currentToken = std::move(ptr)
+#define RECONSUME m_input.reconsume()
 #define CONSUMED_BY_ATTR                                                       \
   (returnState == ATTRIBUTE_VALUE_DOUBLE_QUOTE ||                              \
    returnState == ATTRIBUTE_VALUE_SINGLE_QUOTE ||                              \
@@ -27,23 +24,146 @@
 
 namespace LibHTML {
 
-void Tokenizer::process(const wchar_t *input, size_t size,
-                        OnEmitFunction onEmit) {
+static bool isASCIIAlphanumeric(wchar_t c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+         (c >= 'a' && c <= 'z');
+}
+
+TokenizerState textStateAfter(LibDOM::Atom tagName, bool scripting) {
+  using namespace LibDOM::Atoms;
+  switch (tagName) {
+    case ATOM_title:
+    case ATOM_textarea:
+      return RCDATA;
+    case ATOM_iframe:
+    case ATOM_noembed:
+    case ATOM_noframes:
+    case ATOM_style:
+    case ATOM_xmp:
+      return RAWTEXT;
+    case ATOM_noscript:
+      return scripting ? RAWTEXT : UNDEFINED_STATE;
+    case ATOM_plaintext:
+      return PLAINTEXT;
+    case ATOM_script:
+      return SCRIPT_DATA;
+    default:
+      return UNDEFINED_STATE;
+  }
+}
+
+void TokenArena::reset() { m_chars.clear(); }
+TokenArena::Span TokenArena::begin() { return {m_chars.size(), 0}; }
+bool TokenArena::append(Span &span, wchar_t c) {
+  if (m_maxLength != 0 && span.length >= m_maxLength) {
+    m_dropped++;
+    return false;
+  }
+  if (span.length == 0)
+    span.start = m_chars.size();
+  assert(span.start + span.length == m_chars.size());
+  m_chars += c;
+  span.length++;
+  return true;
+}
+size_t TokenArena::append(Span &span, std::wstring_view s) {
+  if (m_maxLength != 0 && span.length + s.size() > m_maxLength) {
+    size_t fits = m_maxLength - span.length;
+    m_dropped += s.size() - fits;
+    s = s.substr(0, fits);
+  }
+  if (span.length == 0)
+    span.start = m_chars.size();
+  assert(span.start + span.length == m_chars.size());
+  m_chars += s;
+  span.length += s.size();
+  return s.size();
+}
+void TokenArena::rewind(Span span) { m_chars.resize(span.start); }
+std::wstring_view TokenArena::view(Span span) {
+  return std::wstring_view(m_chars).substr(span.start, span.length);
+}
+
+void Tokenizer::reset() {
+  currentState = DATA;
+  returnState = UNDEFINED_STATE;
+  m_input.reset();
+  m_tempBuffer.clear();
+  m_lastStartTagEmitted = LibDOM::NULL_ATOM;
+  m_error = nullptr;
+  m_pendingCount = 0;
+  m_pendingRead = 0;
+  m_arena.resetDropped();
+  m_droppedAttributes = 0;
+}
+
+void Tokenizer::recover() {
+  m_error = nullptr;
+  m_tempBuffer.clear();
+  TokenizerState state = currentState;
+  if (state == CHARACTER_REFERENCE || state == NAMED_CHARACTER_REFERENCE ||
+      state == NUMERIC_CHARACTER_REFERENCE)
+    state = returnState;
+  returnState = UNDEFINED_STATE;
+  // the tree builder is waiting for the end tag of the element whose text
+  // this is, so stay in its text
+  switch (state) {
+  case RCDATA:
+  case RCDATA_LESS_THAN_SIGN:
+  case RCDATA_END_TAG_OPEN:
+  case RCDATA_END_TAG_NAME:
+    currentState = RCDATA;
+    break;
+  case RAWTEXT:
+  case RAWTEXT_LESS_THAN_SIGN:
+  case RAWTEXT_END_TAG_OPEN:
+  case RAWTEXT_END_TAG_NAME:
+    currentState = RAWTEXT;
+    break;
+  case SCRIPT_DATA:
+  case SCRIPT_DATA_LESS_THAN_SIGN:
+  case SCRIPT_DATA_END_TAG_OPEN:
+  case SCRIPT_DATA_END_TAG_NAME:
+  case SCRIPT_DATA_ESCAPE_START:
+    currentState = SCRIPT_DATA;
+    break;
+  default:
+    currentState = DATA;
+    break;
+  }
+}
+
+void Tokenizer::setLimits(const ParserLimits &limits) {
+  m_maxAttributes = limits.maxAttributes;
+  m_arena.setMaxLength(limits.maxTokenSize);
+}
+
+void Tokenizer::feed(const char *input, size_t size) {
+  m_pendingCount = 0;
+  m_pendingRead = 0;
+  m_input.feed(input, size);
+}
+
+void Tokenizer::finish() { m_input.finish(); }
+
+Token *Tokenizer::next() {
+  if (m_pendingRead < m_pendingCount)
+    return m_pendingTokens[m_pendingRead++];
+  m_pendingCount = 0;
+  m_pendingRead = 0;
+
   // Walk the m_input using the state machine described by the HTML spec
   // https://html.spec.whatwg.org/#tokenization
-  m_input = input;
-  m_inputSize = size;
-  m_inputPtr = 0;
-  m_onEmit = onEmit;
-
-  while (m_inputPtr < m_inputSize) {
+  while (m_error == nullptr && m_input.hasInput()) {
 #if 0
-    std::wcout << "state=" << currentState << " ptr=" << m_inputPtr << " ("
-               << m_input[m_inputPtr] << ")"
-               << " token=" << m_currentToken.get() << "\n";
+    std::wcout << "state=" << currentState << " pos=" << m_input.position()
+               << " token=" << m_currentToken.type << "\n";
 #endif
     stateTick();
+    if (m_pendingCount > 0)
+      return m_pendingTokens[m_pendingRead++];
   }
+  return nullptr;
 }
 
 void Tokenizer::stateTick() {
@@ -62,13 +182,16 @@ void Tokenizer::stateTick() {
         case 0:
           // "This is an unexpected-null-character parse error. Emit the current
           // m_input character as a character token."
-          emit(std::make_unique<CharacterToken>(m_currentChar));
+          emitCharacters(std::wstring_view(L"\0", 1));
+          break;
+        case '\r':
+          emitNewline();
           break;
         case EOF:
-          emit(std::make_unique<EOFToken>());
+          emitEOF();
           break;
         default:
-          emit(std::make_unique<CharacterToken>(m_currentChar));
+          emitTextRun(true);
       }
       break;
     }
@@ -86,15 +209,19 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS(0) {
-        emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'\ufffd')));
+        emitCharacters(L"\ufffd");
+        return;
+      }
+      IF_IS('\r') {
+        emitNewline();
         return;
       }
       IF_IS(EOF) {
-        emit(std::unique_ptr<EOFToken>(new EOFToken));
+        emitEOF();
         return;
       }
 
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(m_currentChar)));
+      emitTextRun(true);
       break;
     }
 
@@ -106,15 +233,19 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS(0) {
-        emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'\ufffd')));
+        emitCharacters(L"\ufffd");
+        return;
+      }
+      IF_IS('\r') {
+        emitNewline();
         return;
       }
       IF_IS(EOF) {
-        emit(std::unique_ptr<EOFToken>(new EOFToken));
+        emitEOF();
         return;
       }
 
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(m_currentChar)));
+      emitTextRun(false);
       break;
     }
 
@@ -126,14 +257,18 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS(0) {
-        emit(std::make_unique<CharacterToken>(L'\ufffd'));
+        emitCharacters(L"\ufffd");
+        return;
+      }
+      IF_IS('\r') {
+        emitNewline();
         return;
       }
       IF_IS(EOF) {
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      emit(std::make_unique<CharacterToken>(m_currentChar));
+      emitTextRun(false);
       break;
     }
 
@@ -149,7 +284,7 @@ void Tokenizer::stateTick() {
         return;
       }
       if (isalpha(m_currentChar)) {
-        create(std::make_unique<TagToken>(START_TAG));
+        create(START_TAG);
         RECONSUME;
         currentState = TAG_NAME;
         return;
@@ -158,7 +293,7 @@ void Tokenizer::stateTick() {
         // "This is an unexpected-question-mark-instead-of-tag-name parse error.
         // Create a comment token whose data is the empty string. Reconsume in
         // the bogus comment state."
-        create(std::make_unique<CommentToken>());
+        create(COMMENT);
         RECONSUME;
         currentState = BOGUS_COMMENT;
         return;
@@ -166,13 +301,13 @@ void Tokenizer::stateTick() {
       if (m_currentChar == EOF) {
         // "This is an eof-before-tag-name parse error. Emit a U+003C LESS-THAN
         // SIGN character token and an end-of-file token."
-        emit(std::make_unique<CharacterToken>('>'));
-        emit(std::make_unique<EOFToken>());
+        emitCharacters(L"<");
+        emitEOF();
         return;
       }
       // "This is an invalid-first-character-of-tag-name parse error. Emit a
       // U+003C LESS-THAN SIGN character token. Reconsume in the data state."
-      emit(std::make_unique<CharacterToken>('>'));
+      emitCharacters(L"<");
       RECONSUME;
       currentState = DATA;
       break;
@@ -195,33 +330,27 @@ void Tokenizer::stateTick() {
         return;
       }
       if (isupper(m_currentChar)) {
-        assert(m_currentToken->type() == START_TAG ||
-               m_currentToken->type() == END_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->appendName(m_currentChar + 0x20);
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG ||
+               m_currentToken.type == END_TAG);
+        appendToName(m_currentChar + 0x20);
         return;
       }
       if (m_currentChar == 0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current tag token's tag name."
-        assert(m_currentToken->type() == START_TAG ||
-               m_currentToken->type() == END_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->appendName(L"\ufffd");
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG ||
+               m_currentToken.type == END_TAG);
+        appendToName(L"\ufffd");
         return;
       }
       if (m_currentChar == EOF) {
         // "This is an eof-in-tag parse error. Emit an end-of-file token."
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == START_TAG ||
-             m_currentToken->type() == END_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->appendName(m_currentChar);
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == START_TAG ||
+             m_currentToken.type == END_TAG);
+      appendToName(m_currentChar);
       break;
     }
 
@@ -229,7 +358,7 @@ void Tokenizer::stateTick() {
     case END_TAG_OPEN: {
       consume();
       if (isalpha(m_currentChar)) {
-        create(std::make_unique<TagToken>(END_TAG));
+        create(END_TAG);
         RECONSUME;
         currentState = TAG_NAME;
         return;
@@ -244,15 +373,14 @@ void Tokenizer::stateTick() {
         // "This is an eof-before-tag-name parse error. Emit a U+003C LESS-THAN
         // SIGN character token, a U+002F SOLIDUS character token and an
         // end-of-file token."
-        emit(std::make_unique<CharacterToken>('<'));
-        emit(std::make_unique<CharacterToken>('/'));
-        emit(std::make_unique<EOFToken>());
+        emitCharacters(L"</");
+        emitEOF();
         return;
       }
       // "This is an invalid-first-character-of-tag-name parse error. Create a
       // comment token whose data is the empty string. Reconsume in the bogus
       // comment state."
-      create(std::make_unique<CommentToken>());
+      create(COMMENT);
       currentState = BOGUS_COMMENT;
       break;
     }
@@ -264,7 +392,7 @@ void Tokenizer::stateTick() {
         currentState = RCDATA_END_TAG_OPEN;
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
+      emitCharacters(L"<");
       currentState = RCDATA;
       RECONSUME;
       break;
@@ -273,13 +401,12 @@ void Tokenizer::stateTick() {
     case RCDATA_END_TAG_OPEN: {
       consume();
       if (isalpha(m_currentChar)) {
-        create(std::unique_ptr<TagToken>(new TagToken(END_TAG)));
+        create(END_TAG);
         currentState = RCDATA_END_TAG_NAME;
         RECONSUME;
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
+      emitCharacters(L"</");
       currentState = RCDATA;
       RECONSUME;
       break;
@@ -287,57 +414,45 @@ void Tokenizer::stateTick() {
 
     case RCDATA_END_TAG_NAME: {
       consume();
-      auto tagToken = CONVERT_TO(TagToken, m_currentToken);
       if (isspace(m_currentChar)) {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = BEFORE_ATTRIBUTE_NAME;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('/') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = SELF_CLOSING_START_TAG;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('>') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = DATA;
-          emit(std::move(tagToken));
+          emitCurrent();
           return;
         }
       }
 
       if (isupper(m_currentChar)) {
-        tagToken->appendName(m_currentChar + 0x20);
+        appendToName(m_currentChar + 0x20);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
       if (islower(m_currentChar)) {
-        tagToken->appendName(m_currentChar);
+        appendToName(m_currentChar);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
-      for (size_t i = 0; i < m_tempBuffer.size(); i++) {
-        emit(std::unique_ptr<CharacterToken>(
-            new CharacterToken(m_tempBuffer[i])));
-      }
+      emitCharacters(L"</");
+      if (!m_tempBuffer.empty())
+        emitCharacters(m_tempBuffer);
       currentState = RCDATA;
       RECONSUME;
-      create(std::move(tagToken));
       break;
     }
 
@@ -348,7 +463,7 @@ void Tokenizer::stateTick() {
         currentState = RAWTEXT_END_TAG_OPEN;
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
+      emitCharacters(L"<");
       currentState = RAWTEXT;
       RECONSUME;
       break;
@@ -357,13 +472,12 @@ void Tokenizer::stateTick() {
     case RAWTEXT_END_TAG_OPEN: {
       consume();
       if (isalpha(m_currentChar)) {
-        create(std::unique_ptr<TagToken>(new TagToken(END_TAG)));
+        create(END_TAG);
         currentState = RAWTEXT_END_TAG_NAME;
         RECONSUME;
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
+      emitCharacters(L"</");
       currentState = RCDATA;
       RECONSUME;
       break;
@@ -371,57 +485,45 @@ void Tokenizer::stateTick() {
 
     case RAWTEXT_END_TAG_NAME: {
       consume();
-      auto tagToken = CONVERT_TO(TagToken, m_currentToken);
       if (isspace(m_currentChar)) {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = BEFORE_ATTRIBUTE_NAME;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('/') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = SELF_CLOSING_START_TAG;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('>') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = DATA;
-          emit(std::move(tagToken));
+          emitCurrent();
           return;
         }
       }
 
       if (isupper(m_currentChar)) {
-        tagToken->appendName(m_currentChar + 0x20);
+        appendToName(m_currentChar + 0x20);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
       if (islower(m_currentChar)) {
-        tagToken->appendName(m_currentChar);
+        appendToName(m_currentChar);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
-      for (size_t i = 0; i < m_tempBuffer.size(); i++) {
-        emit(std::unique_ptr<CharacterToken>(
-            new CharacterToken(m_tempBuffer[i])));
-      }
+      emitCharacters(L"</");
+      if (!m_tempBuffer.empty())
+        emitCharacters(m_tempBuffer);
       currentState = RAWTEXT;
       RECONSUME;
-      create(std::move(tagToken));
       break;
     }
 
@@ -435,11 +537,10 @@ void Tokenizer::stateTick() {
       }
       IF_IS('!') {
         currentState = SCRIPT_DATA_ESCAPE_START;
-        emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-        emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'!')));
+        emitCharacters(L"<!");
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
+      emitCharacters(L"<");
       currentState = SCRIPT_DATA;
       RECONSUME;
       break;
@@ -449,13 +550,12 @@ void Tokenizer::stateTick() {
     case SCRIPT_DATA_END_TAG_OPEN: {
       consume();
       if (isalpha(m_currentChar)) {
-        create(std::make_unique<TagToken>(END_TAG));
+        create(END_TAG);
         currentState = SCRIPT_DATA_END_TAG_NAME;
         RECONSUME;
         return;
       }
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
+      emitCharacters(L"</");
       currentState = SCRIPT_DATA;
       RECONSUME;
       break;
@@ -464,57 +564,45 @@ void Tokenizer::stateTick() {
     // https://html.spec.whatwg.org/multipage/parsing.html#script-data-end-tag-name-state
     case SCRIPT_DATA_END_TAG_NAME: {
       consume();
-      auto tagToken = CONVERT_TO(TagToken, m_currentToken);
       if (isspace(m_currentChar)) {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = BEFORE_ATTRIBUTE_NAME;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('/') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = SELF_CLOSING_START_TAG;
-          create(std::move(tagToken));
           return;
         }
       }
 
       IF_IS('>') {
-        if (m_lastStartTagEmitted != L"" &&
-            tagToken->name() == m_lastStartTagEmitted) {
+        if (isAppropriateEndTag()) {
           currentState = DATA;
-          emit(std::move(tagToken));
+          emitCurrent();
           return;
         }
       }
 
       if (isupper(m_currentChar)) {
-        tagToken->appendName(m_currentChar + 0x20);
+        appendToName(m_currentChar + 0x20);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
       if (islower(m_currentChar)) {
-        tagToken->appendName(m_currentChar);
+        appendToName(m_currentChar);
         m_tempBuffer += m_currentChar;
-        create(std::move(tagToken));
         return;
       }
 
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'<')));
-      emit(std::unique_ptr<CharacterToken>(new CharacterToken(L'/')));
-      for (size_t i = 0; i < m_tempBuffer.size(); i++) {
-        emit(std::unique_ptr<CharacterToken>(
-            new CharacterToken(m_tempBuffer[i])));
-      }
+      emitCharacters(L"</");
+      if (!m_tempBuffer.empty())
+        emitCharacters(m_tempBuffer);
       currentState = SCRIPT_DATA;
       RECONSUME;
-      create(std::move(tagToken));
       break;
     }
 
@@ -531,19 +619,16 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS('=') {
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.push_back({std::wstring(1, m_currentChar), L""});
+        assert(m_currentToken.type == START_TAG);
+        startAttribute();
+        appendToAttributeName(m_currentChar);
         currentState = ATTRIBUTE_NAME;
-        MOVE_TOKEN(token);
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.push_back({L"", L""});
+      assert(m_currentToken.type == START_TAG);
+      startAttribute();
       RECONSUME;
       currentState = ATTRIBUTE_NAME;
-      MOVE_TOKEN(token);
       break;
     }
 
@@ -561,25 +646,19 @@ void Tokenizer::stateTick() {
         return;
       }
       if (isupper(m_currentChar)) {
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.back().name += m_currentChar + 0x20;
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG);
+        appendToAttributeName(m_currentChar + 0x20);
         return;
       }
       IF_IS(0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current attribute's name."
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.back().name += L"\ufffd";
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG);
+        appendToAttributeName(L"\ufffd");
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.back().name += m_currentChar;
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == START_TAG);
+      appendToAttributeName(m_currentChar);
       break;
     }
 
@@ -604,14 +683,12 @@ void Tokenizer::stateTick() {
       }
       IF_IS(EOF) {
         // This is an eof-in-tag parse error. Emit an end-of-file token.
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.push_back({L"", L""});
+      assert(m_currentToken.type == START_TAG);
+      startAttribute();
       RECONSUME;
-      MOVE_TOKEN(token);
       currentState = ATTRIBUTE_NAME;
       break;
     }
@@ -657,20 +734,16 @@ void Tokenizer::stateTick() {
       IF_IS(0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current attribute's value."
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.back().value += L"\ufffd";
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG);
+        appendToAttributeValue(L"\ufffd");
         return;
       }
       IF_IS(EOF) {
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.back().value += m_currentChar;
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == START_TAG);
+      appendToAttributeValue(m_currentChar);
       break;
     }
 
@@ -689,20 +762,16 @@ void Tokenizer::stateTick() {
       IF_IS(0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current attribute's value."
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.back().value += L"\ufffd";
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG);
+        appendToAttributeValue(L"\ufffd");
         return;
       }
       IF_IS(EOF) {
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.back().value += m_currentChar;
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == START_TAG);
+      appendToAttributeValue(m_currentChar);
       break;
     }
 
@@ -726,20 +795,16 @@ void Tokenizer::stateTick() {
       IF_IS(0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current attribute's value."
-        assert(m_currentToken->type() == START_TAG);
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->attributes.back().value += L"\ufffd";
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == START_TAG);
+        appendToAttributeValue(L"\ufffd");
         return;
       }
       IF_IS(EOF) {
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == START_TAG);
-      auto token = CONVERT_TO(TagToken, m_currentToken);
-      token->attributes.back().value += m_currentChar;
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == START_TAG);
+      appendToAttributeValue(m_currentChar);
       break;
     }
 
@@ -761,7 +826,7 @@ void Tokenizer::stateTick() {
       }
       IF_IS(EOF) {
         // "This is an eof-in-tag parse error. Emit an end-of-file token."
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
       // "This is a missing-whitespace-between-attributes parse error. Reconsume
@@ -775,16 +840,14 @@ void Tokenizer::stateTick() {
     case SELF_CLOSING_START_TAG: {
       consume();
       IF_IS('>') {
-        assert(m_currentToken->type() == START_TAG);
+        assert(m_currentToken.type == START_TAG);
         currentState = DATA;
-        auto token = CONVERT_TO(TagToken, m_currentToken);
-        token->selfClosing = true;
-        MOVE_TOKEN(token);
+        m_currentToken.selfClosing = true;
         emitCurrent();
         return;
       }
       IF_IS(EOF) {
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
       // "This is an unexpected-solidus-in-tag parse error. Reconsume in the
@@ -798,6 +861,9 @@ void Tokenizer::stateTick() {
       m_tempBuffer = L"&";
       consume();
       if (isalnum(m_currentChar)) {
+        m_entityNode = ENTITY_ROOT;
+        m_entityMatchNode = ENTITY_ROOT;
+        m_entityMatchLength = 0;
         currentState = NAMED_CHARACTER_REFERENCE;
         RECONSUME;
         return;
@@ -808,48 +874,113 @@ void Tokenizer::stateTick() {
         return;
       }
 
-      if (CONSUMED_BY_ATTR) {
-        auto tagToken = CONVERT_TO(TagToken, m_currentToken);
-        for (const auto &c : m_tempBuffer) {
-          tagToken->attributes.back().value += c;
+      flushCharacterReference();
+      currentState = returnState;
+      RECONSUME;
+      break;
+    }
+
+    // https://html.spec.whatwg.org/multipage/parsing.html#named-character-reference-state
+    case NAMED_CHARACTER_REFERENCE: {
+      // "Consume the maximum number of characters possible, where the
+      // consumed characters are one of the identifiers in the named character
+      // references table."
+      // The name is matched one character at a time, remembering the longest
+      // match so far, so it works no matter how the input is split up.
+      while (true) {
+        consume();
+        size_t node = m_currentChar == EOF
+                          ? ENTITY_ROOT
+                          : entityStep(m_entityNode, m_currentChar);
+        if (node == ENTITY_ROOT) {
+          RECONSUME;
+          break;
         }
-        m_currentToken = std::move(tagToken);
-      } else {
-        for (const auto &c : m_tempBuffer) {
-          emit(std::make_unique<CharacterToken>(c));
+        m_tempBuffer += m_currentChar;
+        m_entityNode = node;
+        if (!entityValue(node).empty()) {
+          m_entityMatchNode = node;
+          m_entityMatchLength = m_tempBuffer.size();
         }
+        // no name goes on after a ';'
+        if (m_currentChar == ';')
+          break;
+        // otherwise carry on in the next tick once there's more input
+        if (!m_input.hasInput())
+          return;
+      }
+
+      // the characters consumed after the longest match go back to the
+      // return state, and all of them are alphanumeric or ';', which the
+      // return state treats as plain text
+      if (m_entityMatchNode == ENTITY_ROOT) {
+        // FIXME: implement the ambiguous ampersand state; flushing the
+        // characters and switching to the return state has the same effect
+        // short of reporting the parse error
+        flushCharacterReference();
+        currentState = returnState;
+        return;
+      }
+
+      wchar_t lastMatched = m_tempBuffer[m_entityMatchLength - 1];
+      wchar_t next = m_entityMatchLength < m_tempBuffer.size()
+                         ? m_tempBuffer[m_entityMatchLength]
+                         : m_currentChar;
+      // "If the character reference was consumed as part of an attribute, and
+      // the last character matched is not a U+003B SEMICOLON character (;),
+      // and the next input character is either a U+003D EQUALS SIGN character
+      // (=) or an ASCII alphanumeric, then, for historical reasons, flush code
+      // points consumed as a character reference and switch to the return
+      // state."
+      if (CONSUMED_BY_ATTR && lastMatched != ';' &&
+          (next == '=' || isASCIIAlphanumeric(next))) {
+        flushCharacterReference();
+        currentState = returnState;
+        return;
       }
+
+      // "Set the temporary buffer to the empty string. Append one or two
+      // characters corresponding to the character reference name (as given by
+      // the second column of the named character references table) to the
+      // temporary buffer. Flush code points consumed as a character
+      // reference. Switch to the return state."
+      m_tempBuffer.replace(0, m_entityMatchLength,
+                           entityValue(m_entityMatchNode));
+      flushCharacterReference();
       currentState = returnState;
-      RECONSUME;
       break;
     }
 
     case MARKUP_DECLARATION: {
-      if (wcsncmp(&m_input[m_inputPtr], L"--", 2) == 0) {
+      // wait until the longest keyword below is there in full
+      if (m_input.needsMore(7))
+        return;
+      if (m_input.startsWith("--")) {
         consume(2);
-        create(std::make_unique<CommentToken>());
+        create(COMMENT);
         currentState = COMMENT_START;
         return;
       }
-      if (wcsncasecmp(&m_input[m_inputPtr], L"DOCTYPE", 7) == 0) {
+      if (m_input.startsWith("DOCTYPE", true)) {
         consume(7);
         currentState = DOCTYPE_STATE;
         return;
       }
-      if (wcsncmp(&m_input[m_inputPtr], L"[CDATA[", 7) == 0) {
+      if (m_input.startsWith("[CDATA[")) {
         consume(7);
         // FIXME: handle CDATA properly
         // "this is a cdata-in-html-content parse error. Create a comment token
         // whose data is the "[CDATA[" string. Switch to the bogus comment
         // state."
-        create(std::make_unique<CommentToken>(L"[CDATA["));
+        create(COMMENT);
+        appendToData(L"[CDATA[");
         currentState = BOGUS_COMMENT;
         return;
       }
       // "This is an incorrectly-opened-comment parse error. Create a comment
       // token whose data is the empty string. Switch to the bogus comment state
       // (don't consume anything in the current state)."
-      create(std::make_unique<CommentToken>());
+      create(COMMENT);
       currentState = BOGUS_COMMENT;
       break;
     }
@@ -883,12 +1014,10 @@ void Tokenizer::stateTick() {
       }
       IF_IS(EOF) {
         emitCurrent();
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-      commentToken->appendData('-');
-      MOVE_TOKEN(commentToken);
+      appendToData('-');
       currentState = COMMENT_STATE;
       RECONSUME;
       break;
@@ -897,9 +1026,7 @@ void Tokenizer::stateTick() {
     case COMMENT_STATE: {
       consume();
       IF_IS('<') {
-        auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-        commentToken->appendData(m_currentChar);
-        MOVE_TOKEN(commentToken);
+        appendToData(m_currentChar);
         currentState = COMMENT_LESS_THAN_SIGN;
         return;
       }
@@ -908,19 +1035,15 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS(0) {
-        auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-        commentToken->appendData(L'\ufffd');
-        MOVE_TOKEN(commentToken);
+        appendToData(L'\ufffd');
         return;
       }
       IF_IS(EOF) {
         emitCurrent();
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-      commentToken->appendData(m_currentChar);
-      MOVE_TOKEN(commentToken);
+      appendToData(m_currentChar);
       break;
     }
 
@@ -932,12 +1055,10 @@ void Tokenizer::stateTick() {
       }
       IF_IS(EOF) {
         emitCurrent();
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-      commentToken->appendData('-');
-      MOVE_TOKEN(commentToken);
+      appendToData('-');
       currentState = COMMENT_STATE;
       RECONSUME;
       break;
@@ -955,20 +1076,16 @@ void Tokenizer::stateTick() {
         return;
       }
       IF_IS('-') {
-        auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-        commentToken->appendData('-');
-        MOVE_TOKEN(commentToken);
+        appendToData('-');
         return;
       }
       IF_IS(EOF) {
         emitCurrent();
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      auto commentToken = CONVERT_TO(CommentToken, m_currentToken);
-      commentToken->appendData('-');
-      commentToken->appendData('-');
-      MOVE_TOKEN(commentToken);
+      appendToData('-');
+      appendToData('-');
       currentState = COMMENT_STATE;
       RECONSUME;
       break;
@@ -990,10 +1107,10 @@ void Tokenizer::stateTick() {
         // "This is an eof-in-doctype parse error. Create a new DOCTYPE token.
         // Set its force-quirks flag to on. Emit the current token. Emit an
         // end-of-file token."
-        auto token = std::make_unique<DoctypeToken>();
-        token->setForceQuirks(true);
-        emit(std::move(token));
-        emit(std::make_unique<EOFToken>());
+        create(DOCTYPE_TOKEN);
+        m_currentToken.forceQuirks = true;
+        emitCurrent();
+        emitEOF();
         return;
       }
       // "This is a missing-whitespace-before-doctype-name parse error.
@@ -1010,7 +1127,8 @@ void Tokenizer::stateTick() {
         return; // ignore
       }
       if (isupper(m_currentChar)) {
-        create(std::make_unique<DoctypeToken>(m_currentChar + 0x20));
+        create(DOCTYPE_TOKEN);
+        appendToName(m_currentChar + 0x20);
         currentState = DOCTYPE_NAME;
         return;
       }
@@ -1018,7 +1136,8 @@ void Tokenizer::stateTick() {
         // "This is an unexpected-null-character parse error. Create a new
         // DOCTYPE token. Set the token's name to a U+FFFD REPLACEMENT CHARACTER
         // character. Switch to the DOCTYPE name state."
-        create(std::make_unique<DoctypeToken>(L"\ufffd"));
+        create(DOCTYPE_TOKEN);
+        appendToName(L"\ufffd");
         currentState = DOCTYPE_NAME;
         return;
       }
@@ -1026,24 +1145,25 @@ void Tokenizer::stateTick() {
         // "This is a missing-doctype-name parse error. Create a new DOCTYPE
         // token. Set its force-quirks flag to on. Switch to the data state.
         // Emit the current token." emit(DOCTYPE_TOKEN, "");
-        auto token = std::make_unique<DoctypeToken>();
-        token->setForceQuirks(true);
+        create(DOCTYPE_TOKEN);
+        m_currentToken.forceQuirks = true;
         currentState = DATA;
-        emit(std::move(token));
+        emitCurrent();
         return;
       }
       if (m_currentChar == EOF) {
         // "This is an eof-in-doctype parse error. Create a new DOCTYPE token.
         // Set its force-quirks flag to on. Emit the current token. Emit an
         // end-of-file token."
-        auto token = std::make_unique<DoctypeToken>();
-        token->setForceQuirks(true);
-        emit(std::move(token));
-        emit(std::make_unique<EOFToken>());
+        create(DOCTYPE_TOKEN);
+        m_currentToken.forceQuirks = true;
+        emitCurrent();
+        emitEOF();
         return;
       }
 
-      create(std::make_unique<DoctypeToken>(m_currentChar));
+      create(DOCTYPE_TOKEN);
+      appendToName(m_currentChar);
       currentState = DOCTYPE_NAME;
       break;
     }
@@ -1061,67 +1181,165 @@ void Tokenizer::stateTick() {
         return;
       }
       if (isupper(m_currentChar)) {
-        assert(m_currentToken->type() == DOCTYPE_TOKEN);
-        auto token = CONVERT_TO(DoctypeToken, m_currentToken);
-        token->appendName(m_currentChar + 0x20);
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == DOCTYPE_TOKEN);
+        appendToName(m_currentChar + 0x20);
         return;
       }
       if (m_currentChar == 0) {
         // "This is an unexpected-null-character parse error. Append a U+FFFD
         // REPLACEMENT CHARACTER character to the current DOCTYPE token's name.
-        assert(m_currentToken->type() == DOCTYPE_TOKEN);
-        auto token = CONVERT_TO(DoctypeToken, m_currentToken);
-        token->appendName(L"\ufffd");
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == DOCTYPE_TOKEN);
+        appendToName(L"\ufffd");
         return;
       }
       if (m_currentChar == EOF) {
         // "This is an eof-in-doctype parse error. Set the current DOCTYPE
         // token's force-quirks flag to on. Emit the current DOCTYPE token. Emit
         // an end-of-file token."
-        assert(m_currentToken->type() == DOCTYPE_TOKEN);
-        auto token = CONVERT_TO(DoctypeToken, m_currentToken);
-        token->setForceQuirks(true);
-        MOVE_TOKEN(token);
+        assert(m_currentToken.type == DOCTYPE_TOKEN);
+        m_currentToken.forceQuirks = true;
         emitCurrent();
-        emit(std::make_unique<EOFToken>());
+        emitEOF();
         return;
       }
-      assert(m_currentToken->type() == DOCTYPE_TOKEN);
-      auto token = CONVERT_TO(DoctypeToken, m_currentToken);
-      token->appendName(m_currentChar);
-      MOVE_TOKEN(token);
+      assert(m_currentToken.type == DOCTYPE_TOKEN);
+      appendToName(m_currentChar);
       break;
     }
 
     // Unhandled state - missing implementation
     default: {
-      std::wcout << "unknown tokenizer state encountered: " << currentState
-                 << std::endl;
-      throw StringException("unknown tokenizer state encountered");
+      m_error = "unknown tokenizer state encountered";
+      break;
     }
   }
 }
 
-void Tokenizer::emit(std::unique_ptr<Token> token) {
-  if (token->type() == START_TAG) {
+void Tokenizer::emit(Token &token) {
+  if (token.type == START_TAG) {
     // save tag info
-    auto tagToken = CONVERT_TO(TagToken, token);
-    m_lastStartTagEmitted = tagToken->name();
-    token = std::move(tagToken);
+    m_lastStartTagEmitted = token.atom;
+  }
+  assert(m_pendingCount < MAX_PENDING_TOKENS);
+  m_pendingTokens[m_pendingCount++] = &token;
+}
+void Tokenizer::emitCharacters(std::wstring_view data) {
+  // every pending slot has its own character token, so two runs emitted by
+  // the same tick don't overwrite each other
+  Token &token = m_characterTokens[m_pendingCount];
+  token.data = data;
+  token.isWhitespace = isHTMLWhitespace(data);
+  emit(token);
+}
+void Tokenizer::emitEOF() { emit(m_eofToken); }
+void Tokenizer::emitTextRun(bool stopAtAmpersand) {
+  std::string_view run = m_input.consumeTextRun(stopAtAmpersand);
+  if (m_textBuffer.size() < run.size())
+    m_textBuffer.resize(run.size());
+  size_t length = decodeUTF8(run.data(), run.size(), m_textBuffer.data());
+  emitCharacters({m_textBuffer.data(), length});
+}
+void Tokenizer::emitNewline() {
+  // https://html.spec.whatwg.org/multipage/parsing.html#preprocessing-the-input-stream
+  // both "\r\n" and a lone '\r' turn into a single '\n'
+  if (m_input.lineFeedFollows())
+    return; // it starts the next run
+  m_input.skipLineFeed();
+  emitCharacters(L"\n");
+}
+
+void Tokenizer::create(TokenType type) {
+  m_arena.reset();
+  m_nameSpan = m_arena.begin();
+  m_nameHash = LibDOM::ATOM_HASH_SEED;
+  m_dataSpan = m_arena.begin();
+  m_attributeSpans.clear();
+  m_currentToken.type = type;
+  m_currentToken.selfClosing = false;
+  m_currentToken.forceQuirks = false;
+}
+void Tokenizer::emitCurrent() {
+  m_currentToken.name = m_arena.view(m_nameSpan);
+  m_currentToken.data = m_arena.view(m_dataSpan);
+  m_currentToken.atom = LibDOM::NULL_ATOM;
+  m_currentToken.attributes.clear();
+  if (m_currentToken.type != START_TAG && m_currentToken.type != END_TAG) {
+    emit(m_currentToken);
+    return;
   }
-  m_onEmit(std::move(token));
+  m_currentToken.atom = LibDOM::atomize(m_currentToken.name, m_nameHash);
+  size_t count = m_attributeSpans.size();
+  if (m_maxAttributes != 0 && count > m_maxAttributes)
+    count = m_maxAttributes;
+  for (size_t i = 0; i < count; i++) {
+    const auto &span = m_attributeSpans[i];
+    auto name = m_arena.view(span.name);
+    m_currentToken.attributes.push_back({LibDOM::atomize(name, span.nameHash),
+                                         name, m_arena.view(span.value)});
+  }
+  emit(m_currentToken);
+}
+
+// only what fits is hashed, so that the hash matches the name that is kept
+void Tokenizer::appendToName(wchar_t c) {
+  if (m_arena.append(m_nameSpan, c))
+    m_nameHash = LibDOM::atomHashStep(m_nameHash, c);
 }
-void Tokenizer::create(std::unique_ptr<Token> token) {
-  m_currentToken = std::move(token);
+void Tokenizer::appendToName(std::wstring_view s) {
+  size_t appended = m_arena.append(m_nameSpan, s);
+  for (wchar_t c : s.substr(0, appended))
+    m_nameHash = LibDOM::atomHashStep(m_nameHash, c);
+}
+void Tokenizer::appendToData(wchar_t c) { m_arena.append(m_dataSpan, c); }
+void Tokenizer::appendToData(std::wstring_view s) {
+  m_arena.append(m_dataSpan, s);
+}
+void Tokenizer::startAttribute() {
+  // past the limit, the attribute after the last one that is kept is built
+  // over and over again, and left out when the token is emitted
+  if (m_maxAttributes != 0 && m_attributeSpans.size() > m_maxAttributes) {
+    m_arena.rewind(m_attributeSpans.back().name);
+    m_attributeSpans.pop_back();
+  }
+  if (m_maxAttributes != 0 && m_attributeSpans.size() == m_maxAttributes)
+    m_droppedAttributes++;
+  m_attributeSpans.push_back(
+      {m_arena.begin(), m_arena.begin(), LibDOM::ATOM_HASH_SEED});
+}
+void Tokenizer::appendToAttributeName(wchar_t c) {
+  auto &span = m_attributeSpans.back();
+  if (m_arena.append(span.name, c))
+    span.nameHash = LibDOM::atomHashStep(span.nameHash, c);
+}
+void Tokenizer::appendToAttributeName(std::wstring_view s) {
+  auto &span = m_attributeSpans.back();
+  size_t appended = m_arena.append(span.name, s);
+  for (wchar_t c : s.substr(0, appended))
+    span.nameHash = LibDOM::atomHashStep(span.nameHash, c);
+}
+void Tokenizer::appendToAttributeValue(wchar_t c) {
+  m_arena.append(m_attributeSpans.back().value, c);
+}
+void Tokenizer::appendToAttributeValue(std::wstring_view s) {
+  m_arena.append(m_attributeSpans.back().value, s);
 }
-void Tokenizer::emitCurrent() { emit(std::move(m_currentToken)); }
 
-void Tokenizer::consume() { m_currentChar = m_input[m_inputPtr++]; }
-void Tokenizer::consume(size_t howMany) {
-  m_inputPtr += howMany;
-  m_currentChar = m_input[m_inputPtr];
+/** https://html.spec.whatwg.org/multipage/parsing.html#flush-code-points-consumed-as-a-character-reference */
+void Tokenizer::flushCharacterReference() {
+  if (CONSUMED_BY_ATTR) {
+    appendToAttributeValue(m_tempBuffer);
+  } else {
+    emitCharacters(m_tempBuffer);
+  }
+}
+
+/** https://html.spec.whatwg.org/multipage/parsing.html#appropriate-end-tag-token */
+bool Tokenizer::isAppropriateEndTag() {
+  return m_lastStartTagEmitted != LibDOM::NULL_ATOM &&
+         m_arena.view(m_nameSpan) == LibDOM::atomName(m_lastStartTagEmitted);
 }
 
+void Tokenizer::consume() { m_currentChar = m_input.consume(); }
+void Tokenizer::consume(size_t howMany) { m_input.skip(howMany); }
+
 } // namespace LibHTML
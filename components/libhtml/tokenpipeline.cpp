@@ -0,0 +1,182 @@
+#include "libhtml/tokenpipeline.h"
+#include "libdom/atom.h"
+#include "libhtml/tokenizer.h"
+#include "libhtml/tokens.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace LibHTML {
+
+using namespace LibDOM::Atoms;
+
+static size_t stringLength(const Token &token) {
+  size_t length = token.data.size() + token.name.size();
+  for (const auto &attr : token.attributes)
+    length += attr.name.size() + attr.value.size();
+  return length;
+}
+
+/** Copies a string into a batch, which has room for it. */
+static std::wstring_view keep(std::wstring &chars, std::wstring_view s) {
+  size_t start = chars.size();
+  chars.append(s);
+  return std::wstring_view(chars.data() + start, s.size());
+}
+
+TokenPipeline::TokenPipeline(const char *input, size_t size, bool scripting,
+                             bool recover, const ParserLimits &limits)
+    : m_input(input), m_size(size), m_scripting(scripting), m_recover(recover),
+      m_limits(limits) {}
+
+TokenPipeline::~TokenPipeline() { stop(); }
+
+void TokenPipeline::start(TokenizerState state) {
+  m_worker = std::thread(&TokenPipeline::run, this, 0, state, NULL_ATOM);
+}
+
+void TokenPipeline::restart(size_t offset, TokenizerState state,
+                            LibDOM::Atom lastStartTag) {
+  stop();
+  m_ring.clear();
+  m_stopping.store(false);
+  m_finished.store(false);
+  m_restarts++;
+  m_worker =
+      std::thread(&TokenPipeline::run, this, offset, state, lastStartTag);
+}
+
+void TokenPipeline::stop() {
+  m_stopping.store(true);
+  notify();
+  if (m_worker.joinable())
+    m_worker.join();
+}
+
+template <typename F> void TokenPipeline::waitUntil(F ready) {
+  // a batch takes long enough to fill or to build that the other side is
+  // rarely just about done with one
+  for (int i = 0; i < 64; i++) {
+    if (ready())
+      return;
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_changed.wait(lock, ready);
+}
+
+void TokenPipeline::notify() {
+  // taking the lock keeps the notification from slipping in between a waiter
+  // checking its condition and going to sleep
+  { std::lock_guard<std::mutex> lock(m_mutex); }
+  m_changed.notify_all();
+}
+
+TokenPipeline::Batch *TokenPipeline::next() {
+  waitUntil([this] {
+    return m_ring.front() != nullptr ||
+           m_finished.load(std::memory_order_acquire);
+  });
+  return m_ring.front();
+}
+
+void TokenPipeline::pop() {
+  m_ring.pop();
+  notify();
+}
+
+void TokenPipeline::push() {
+  m_ring.push();
+  notify();
+}
+
+TokenPipeline::Batch *TokenPipeline::emptyBatch() {
+  waitUntil([this] {
+    return m_ring.back() != nullptr ||
+           m_stopping.load(std::memory_order_relaxed);
+  });
+  if (m_stopping.load(std::memory_order_relaxed))
+    return nullptr;
+  Batch *batch = m_ring.back();
+  batch->size = 0;
+  batch->chars.clear();
+  batch->error = nullptr;
+  if (batch->chars.capacity() < BATCH_CHARS)
+    batch->chars.reserve(BATCH_CHARS);
+  return batch;
+}
+
+void TokenPipeline::run(size_t offset, TokenizerState state,
+                        LibDOM::Atom lastStartTag) {
+  Tokenizer tokenizer;
+  tokenizer.setLimits(m_limits);
+  tokenizer.feed(m_input + offset, m_size - offset);
+  tokenizer.finish();
+  tokenizer.currentState = state;
+  tokenizer.setLastStartTag(lastStartTag);
+
+  Batch *batch = emptyBatch();
+  while (batch != nullptr) {
+    size_t droppedAttributes = tokenizer.droppedAttributes();
+    size_t droppedCharacters = tokenizer.droppedCharacters();
+    Token *token = tokenizer.next();
+    if (token == nullptr) {
+      batch->error = tokenizer.error();
+      push();
+      if (batch->error == nullptr || !m_recover)
+        break;
+      tokenizer.recover();
+      batch = emptyBatch();
+      continue;
+    }
+
+    size_t length = stringLength(*token);
+    if (batch->size == BATCH_TOKENS ||
+        batch->chars.size() + length > batch->chars.capacity()) {
+      if (batch->size > 0) {
+        push();
+        batch = emptyBatch();
+        if (batch == nullptr)
+          break;
+      }
+      // a token that is bigger than a batch gets one of its own
+      if (batch->chars.capacity() < length)
+        batch->chars.reserve(length);
+    }
+
+    if (batch->size == batch->entries.size())
+      batch->entries.emplace_back();
+    Entry &entry = batch->entries[batch->size++];
+    Token &copy = entry.token;
+    copy.type = token->type;
+    copy.data = keep(batch->chars, token->data);
+    copy.isWhitespace = token->isWhitespace;
+    copy.name = keep(batch->chars, token->name);
+    copy.atom = token->atom;
+    copy.selfClosing = token->selfClosing;
+    copy.attributes.clear();
+    for (const auto &attr : token->attributes) {
+      copy.attributes.push_back({attr.atom, keep(batch->chars, attr.name),
+                                 keep(batch->chars, attr.value)});
+    }
+    copy.forceQuirks = token->forceQuirks;
+
+    entry.end = offset + tokenizer.position();
+    entry.droppedAttributes = tokenizer.droppedAttributes() - droppedAttributes;
+    entry.droppedCharacters = tokenizer.droppedCharacters() - droppedCharacters;
+    entry.switchedTo = UNDEFINED_STATE;
+    if (token->type == START_TAG) {
+      entry.switchedTo = textStateAfter(token->atom, m_scripting);
+      if (entry.switchedTo != UNDEFINED_STATE)
+        tokenizer.currentState = entry.switchedTo;
+    }
+  }
+  m_finished.store(true, std::memory_order_release);
+  notify();
+}
+
+} // namespace LibHTML
@@ -0,0 +1,167 @@
+#include "libhtml/utf8.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <string>
+
+namespace LibHTML {
+
+static const wchar_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+wchar_t decodeUTF8Sequence(const char *input, size_t size, size_t &length) {
+  unsigned char lead = input[0];
+  length = 1;
+  if (lead < 0x80)
+    return lead;
+
+  // the bounds on the second byte rule out overlong forms, surrogates and
+  // anything above U+10FFFF
+  size_t needed;
+  wchar_t codePoint;
+  unsigned char lower = 0x80;
+  unsigned char upper = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    needed = 1;
+    codePoint = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    needed = 2;
+    codePoint = lead & 0x0F;
+    if (lead == 0xE0)
+      lower = 0xA0;
+    if (lead == 0xED)
+      upper = 0x9F;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    needed = 3;
+    codePoint = lead & 0x07;
+    if (lead == 0xF0)
+      lower = 0x90;
+    if (lead == 0xF4)
+      upper = 0x8F;
+  } else {
+    return REPLACEMENT_CHARACTER;
+  }
+
+  for (size_t i = 0; i < needed; i++) {
+    if (length >= size)
+      return REPLACEMENT_CHARACTER;
+    unsigned char byte = input[length];
+    if (byte < lower || byte > upper)
+      return REPLACEMENT_CHARACTER;
+    lower = 0x80;
+    upper = 0xBF;
+    codePoint = (codePoint << 6) | (byte & 0x3F);
+    length++;
+  }
+  return codePoint;
+}
+
+/** The length of the sequence that `lead` starts, or 0 if it can't start one. */
+static size_t sequenceLength(unsigned char lead) {
+  if (lead >= 0xC2 && lead <= 0xDF)
+    return 2;
+  if (lead >= 0xE0 && lead <= 0xEF)
+    return 3;
+  if (lead >= 0xF0 && lead <= 0xF4)
+    return 4;
+  return 0;
+}
+
+size_t incompleteUTF8Suffix(const char *input, size_t size) {
+  for (size_t back = 1; back <= 3 && back <= size; back++) {
+    unsigned char byte = input[size - back];
+    if (byte < 0x80)
+      return 0;
+    if (byte < 0xC0)
+      continue;
+
+    // a lead byte: the sequence is incomplete if it wants more bytes than
+    // there are and the ones that are there are valid so far
+    if (sequenceLength(byte) <= back)
+      return 0;
+    size_t length;
+    decodeUTF8Sequence(&input[size - back], back, length);
+    return length == back ? back : 0;
+  }
+  return 0;
+}
+
+/**
+  Widens 16 bytes of ASCII at `input` into `output`, or returns false without
+  writing anything if one of them isn't ASCII.
+*/
+static inline bool widenASCII16(const char *input, wchar_t *output) {
+#ifdef __SSE2__
+  static_assert(sizeof(wchar_t) == 4, "widening expects UTF-32 wchar_t");
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+  if (_mm_movemask_epi8(bytes) != 0)
+    return false;
+  const __m128i zero = _mm_setzero_si128();
+  __m128i low = _mm_unpacklo_epi8(bytes, zero);
+  __m128i high = _mm_unpackhi_epi8(bytes, zero);
+  __m128i *out = reinterpret_cast<__m128i *>(output);
+  _mm_storeu_si128(out, _mm_unpacklo_epi16(low, zero));
+  _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+  _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+  _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+  return true;
+#else
+  uint64_t words[2];
+  memcpy(words, input, 16);
+  if ((words[0] | words[1]) & 0x8080808080808080ull)
+    return false;
+  for (size_t i = 0; i < 16; i++)
+    output[i] = static_cast<unsigned char>(input[i]);
+  return true;
+#endif
+}
+
+size_t decodeUTF8(const char *input, size_t size, wchar_t *output) {
+  wchar_t *out = output;
+  size_t i = 0;
+  while (i < size) {
+    // ASCII fast path
+    while (i + 16 <= size && widenASCII16(&input[i], out)) {
+      out += 16;
+      i += 16;
+    }
+    while (i < size && static_cast<unsigned char>(input[i]) < 0x80)
+      *out++ = static_cast<unsigned char>(input[i++]);
+    if (i == size)
+      break;
+
+    size_t length;
+    *out++ = decodeUTF8Sequence(&input[i], size - i, length);
+    i += length;
+  }
+  return out - output;
+}
+
+void encodeUTF8(std::wstring_view input, std::string &output) {
+  for (wchar_t c : input) {
+    uint32_t codePoint = static_cast<uint32_t>(c);
+    if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+      codePoint = REPLACEMENT_CHARACTER;
+
+    if (codePoint < 0x80) {
+      output += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+      output += static_cast<char>(0xC0 | (codePoint >> 6));
+      output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+      output += static_cast<char>(0xE0 | (codePoint >> 12));
+      output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+      output += static_cast<char>(0xF0 | (codePoint >> 18));
+      output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+}
+
+} // namespace LibHTML
@@ -7,36 +7,41 @@
 #include <cstdio>
 #include <curl/curl.h>
 #include <curl/easy.h>
-#include <exception>
 #include <fstream>
 #include <iostream>
 #include <memory>
 
-LibHTML::Parser parser;
+/** Everything that works on the document as it comes in. */
+struct Page {
+  LibHTML::Parser parser;
+  LibHTML::FetchQueue fetchQueue;
+  LibHTML::PreloadScanner preloadScanner{fetchQueue};
+};
 
 size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata) {
-  (void)userdata;
   (void)size;
   assert(size == 1);
-  try {
-    parser.parse(ptr, nmemb);
-  } catch (std::exception &exc) {
-    std::cout
-        << "[FATAL ERROR] An exception has occurred during LibHTML parsing: "
-        << exc.what() << "\n";
+  auto &page = *static_cast<Page *>(userdata);
+  // look for subresources in the chunk before the parser gets to it
+  page.preloadScanner.scan(ptr, nmemb);
+  auto &parser = page.parser;
+  if (parser.parse(ptr, nmemb) == LibHTML::PARSE_ABORTED) {
+    std::cout << "[FATAL ERROR] LibHTML gave up parsing: " << parser.error()
+              << "\n";
     return -1;
   }
   return nmemb;
 }
 
-void walkTree(std::shared_ptr<LibDOM::Node> node, int indent = 0) {
+void walkTree(LibDOM::RefPtr<LibDOM::Node> node, int indent = 0) {
   std::wcout << std::wstring(indent * 2, ' ') << L"-> "
              << node->internalName().c_str();
-  if (!node->nodeName.empty()) {
-    std::wcout << " (" << node->nodeName << ")";
+  auto nodeName = node->nodeName().toWString();
+  if (!nodeName.empty()) {
+    std::wcout << " (" << nodeName << ")";
   }
   std::wcout << "\n";
-  for (auto child : node->childNodes) {
+  for (auto child : node->childNodes()) {
     walkTree(child, indent + 1);
   }
 }
@@ -52,7 +57,11 @@ int main(int argc, char **argv) {
     return -2;
 
   curl_easy_setopt(handle, CURLOPT_URL, argv[1]);
+  Page page;
+  auto &parser = page.parser;
+  parser.warnings = &std::wclog;
   curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeCallback);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &page);
   struct curl_slist *headers = NULL;
   headers = curl_slist_append(headers, "Accept: text/html; charset=UTF-8");
   headers = curl_slist_append(headers, "User-Agent: " BROWSER_USER_AGENT);
@@ -65,8 +74,13 @@ int main(int argc, char **argv) {
   curl_slist_free_all(headers);
 
   // let the tokenizer know we're EOF'd now
-  const wchar_t eof[] = {EOF};
-  parser.parse(eof, 1);
+  page.preloadScanner.finish();
+  parser.finish();
+
+  std::cout << "\nSubresources, most urgent first:\n";
+  LibHTML::FetchRequest request;
+  while (page.fetchQueue.pop(request))
+    std::wcout << L"  " << request.url << L"\n";
 
   std::cout << "\nDOM tree dump:\n";
   walkTree(parser.document);
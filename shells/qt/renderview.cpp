@@ -2,33 +2,63 @@
 #include "libdom/document.h"
 #include "libdomrenderer/viewport.h"
 #include "libhtml/parser.h"
+#include "libhtml/status.h"
 #include "qimage.h"
 #include "qpainter.h"
 #include "qwidget.h"
-#include <exception>
+#include <chrono>
+#include <iostream>
 #include <memory>
 
-RenderView::RenderView(QWidget *parent) : QWidget(parent) {}
+/** How long a slice of parsing may keep the event loop waiting. */
+static const std::chrono::milliseconds PARSE_SLICE(8);
+
+static LibHTML::ParseBudget sliceBudget() {
+  LibHTML::ParseBudget budget;
+  budget.deadline = std::chrono::steady_clock::now() + PARSE_SLICE;
+  return budget;
+}
+
+RenderView::RenderView(QWidget *parent) : QWidget(parent) {
+  m_parseTimer.setSingleShot(true);
+  m_parseTimer.setInterval(0);
+  connect(&m_parseTimer, &QTimer::timeout, this, &RenderView::parseSlice);
+}
+
 void RenderView::setHtmlData(QString data) {
   if (m_htmlData == data)
     return;
   m_htmlData = data;
 
-  // create a fresh Document for the parser
-  m_parser.document = std::make_shared<LibDOM::Document>();
+  // create a fresh Document for the parser. The previous one is freed once
+  // the parser lets go of the nodes it still had open in it.
+  m_parseTimer.stop();
   m_parser.reset();
+  m_parser.document = LibDOM::Document::create();
 
-  // parse the document
-  const QByteArray stringData = m_htmlData.toUtf8();
-  const wchar_t eof[] = {EOF};
-  try {
-    m_parser.parse(stringData.constData(), stringData.length());
-    m_parser.parse(eof, 1);
-  } catch (std::exception &exc) {
-    setHtmlData(QString("<p>Failed to parse website: ") + exc.what() +
-                "</p><p>Check the console for details.</p>");
-    return;
+  // parse the document in slices between events, showing as much of it as
+  // can be parsed
+  m_parser.recoveryMode = LibHTML::BEST_EFFORT;
+  m_parser.warnings = &std::wclog;
+  m_htmlBytes = m_htmlData.toUtf8();
+  m_parserFinished = false;
+  continueParsing(m_parser.parse(m_htmlBytes.constData(), m_htmlBytes.length(),
+                                 sliceBudget()));
+}
+
+void RenderView::parseSlice() {
+  continueParsing(m_parser.resume(sliceBudget()));
+}
+
+void RenderView::continueParsing(LibHTML::ParseStatus status) {
+  if (status == LibHTML::PARSE_OK && !m_parserFinished) {
+    m_parserFinished = true;
+    status = m_parser.finish(sliceBudget());
   }
+  if (status == LibHTML::PARSE_PAUSED)
+    m_parseTimer.start();
+  else if (m_parser.error() != nullptr)
+    std::cout << "Parsed the website partially: " << m_parser.error() << "\n";
   update();
 }
 
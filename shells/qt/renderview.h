@@ -4,7 +4,10 @@
 #include "libdomrenderer/renderer.h"
 #include "libdomrenderer/viewport.h"
 #include "libhtml/parser.h"
+#include "libhtml/status.h"
+#include "qbytearray.h"
 #include "qevent.h"
+#include "qtimer.h"
 #include "qtmetamacros.h"
 #include "qwidget.h"
 #include <memory>
@@ -22,9 +25,24 @@ protected:
   void repaint();
   void paintEvent(QPaintEvent *event);
 
+private slots:
+  /** Parses the next slice of the document, see continueParsing(). */
+  void parseSlice();
+
 private:
+  /**
+    Takes the status of the last slice, and schedules the next one if the
+    parser paused, so that events are handled in between.
+  */
+  void continueParsing(LibHTML::ParseStatus status);
+
   LibHTML::Parser m_parser;
   QString m_htmlData;
+  /** The parser's input, which has to outlive the slices. */
+  QByteArray m_htmlBytes;
+  /** Whether the parser was told the input is complete. */
+  bool m_parserFinished = false;
+  QTimer m_parseTimer;
   std::shared_ptr<LibDOMRenderer::Viewport> m_viewport;
   LibDOMRenderer::Renderer m_renderer;
 };